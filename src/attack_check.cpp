@@ -3,6 +3,7 @@
 #include "move_generator.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <vector>
 
 namespace engine::parts::attack_check
@@ -12,16 +13,11 @@ auto square_is_attacked(BoardState &board_state,
                         int y_rank,
                         PieceColor color_being_attacked) -> bool
 {
-  return square_is_attacked_by_pawn(board_state, x_file, y_rank,
-                                    color_being_attacked) ||
-         square_is_attacked_by_knight(board_state, x_file, y_rank,
-                                      color_being_attacked) ||
-         square_is_attacked_by_rook_or_queen(board_state, x_file, y_rank,
-                                             color_being_attacked) ||
-         square_is_attacked_by_bishop_or_queen(board_state, x_file, y_rank,
-                                               color_being_attacked) ||
-         square_is_attacked_by_king(board_state, x_file, y_rank,
-                                    color_being_attacked);
+  if (color_being_attacked == PieceColor::WHITE)
+  {
+    return square_is_attacked<PieceColor::WHITE>(board_state, x_file, y_rank);
+  }
+  return square_is_attacked<PieceColor::BLACK>(board_state, x_file, y_rank);
 }
 
 auto is_checkmate(BoardState &board_state) -> bool
@@ -81,12 +77,73 @@ auto king_is_checked(BoardState &board_state, PieceColor color_of_king) -> bool
 {
   if (color_of_king == PieceColor::WHITE)
   {
-    return square_is_attacked(board_state, board_state.white_king_x_file,
-                              board_state.white_king_y_rank, color_of_king);
+    return king_is_checked<PieceColor::WHITE>(board_state);
+  }
+  return king_is_checked<PieceColor::BLACK>(board_state);
+}
+
+auto CheckInfo::in_check() const -> bool { return checkers != 0; }
+
+auto CheckInfo::move_is_known_legal(const Move &move) const -> bool
+{
+  return !in_check() && move.moving_piece->piece_type != PieceType::KING &&
+         !move.capture_is_en_passant &&
+         !bitboard::contains(pinned, move.from_x, move.from_y);
+}
+
+auto compute_check_info(const BoardState &board_state,
+                        PieceColor color_of_king) -> CheckInfo
+{
+  if (color_of_king == PieceColor::WHITE)
+  {
+    return compute_check_info<PieceColor::WHITE>(board_state);
+  }
+  return compute_check_info<PieceColor::BLACK>(board_state);
+}
+
+auto compute_check_squares(const BoardState &board_state) -> CheckSquares
+{
+  if (board_state.color_to_move == PieceColor::WHITE)
+  {
+    return compute_check_squares<PieceColor::WHITE>(board_state);
+  }
+  return compute_check_squares<PieceColor::BLACK>(board_state);
+}
+
+auto gives_check(BoardState &board_state,
+                 Move &move,
+                 const CheckSquares &check_squares) -> bool
+{
+  bool is_castling = move.moving_piece->piece_type == PieceType::KING &&
+                     std::abs(move.to_x - move.from_x) > 1;
+  if (move.promotion_piece_type != PieceType::EMPTY ||
+      move.capture_is_en_passant || is_castling)
+  {
+    PieceColor enemy_color = (board_state.color_to_move == PieceColor::WHITE)
+                                 ? PieceColor::BLACK
+                                 : PieceColor::WHITE;
+    board_state.apply_move(move);
+    bool move_gives_check = king_is_checked(board_state, enemy_color);
+    board_state.undo_move();
+    return move_gives_check;
+  }
+
+  // DIRECT CHECK
+  const auto piece_type_index =
+      static_cast<uint8_t>(move.moving_piece->piece_type);
+  if (bitboard::contains(check_squares.check_squares[piece_type_index],
+                         move.to_x, move.to_y))
+  {
+    return true;
   }
 
-  return square_is_attacked(board_state, board_state.black_king_x_file,
-                            board_state.black_king_y_rank, color_of_king);
+  // DISCOVERED CHECK
+  // Moving a blocker along the line to the enemy king keeps it blocked.
+  return bitboard::contains(check_squares.discovered_check_blockers,
+                            move.from_x, move.from_y) &&
+         !squares_are_aligned(move.from_x, move.from_y, move.to_x, move.to_y,
+                              check_squares.king_x_file,
+                              check_squares.king_y_rank);
 }
 
 auto move_leaves_king_in_check(BoardState &board_state, Move &move) -> bool
@@ -98,36 +155,306 @@ auto move_leaves_king_in_check(BoardState &board_state, Move &move) -> bool
   return king_is_checked_after_move;
 }
 
+template <PieceColor color_being_attacked>
+auto square_is_attacked(BoardState &board_state, int x_file, int y_rank)
+    -> bool
+{
+  if (board_state.attack_tables_are_enabled())
+  {
+    constexpr PieceColor attacking_color =
+        (color_being_attacked == PieceColor::WHITE) ? PieceColor::BLACK
+                                                    : PieceColor::WHITE;
+    return bitboard::contains(
+        board_state.color_attacks[static_cast<uint8_t>(attacking_color)],
+        x_file, y_rank);
+  }
+
+  return square_is_attacked_by_pawn<color_being_attacked>(board_state, x_file,
+                                                          y_rank) ||
+         square_is_attacked_by_knight<color_being_attacked>(board_state,
+                                                            x_file, y_rank) ||
+         square_is_attacked_by_rook_or_queen<color_being_attacked>(
+             board_state, x_file, y_rank) ||
+         square_is_attacked_by_bishop_or_queen<color_being_attacked>(
+             board_state, x_file, y_rank) ||
+         square_is_attacked_by_king<color_being_attacked>(board_state, x_file,
+                                                          y_rank);
+}
+
+template <PieceColor color_of_king>
+auto king_is_checked(BoardState &board_state) -> bool
+{
+  if constexpr (color_of_king == PieceColor::WHITE)
+  {
+    return square_is_attacked<color_of_king>(board_state,
+                                             board_state.white_king_x_file,
+                                             board_state.white_king_y_rank);
+  }
+  else
+  {
+    return square_is_attacked<color_of_king>(board_state,
+                                             board_state.black_king_x_file,
+                                             board_state.black_king_y_rank);
+  }
+}
+
+template <PieceColor color_of_king>
+auto compute_check_info(const BoardState &board_state) -> CheckInfo
+{
+  constexpr PieceColor enemy_color = OPPOSITE_COLOR<color_of_king>;
+  const chess_board_type &chess_board = board_state.chess_board;
+  CheckInfo check_info;
+
+  int king_x_file;
+  int king_y_rank;
+  if constexpr (color_of_king == PieceColor::WHITE)
+  {
+    king_x_file = board_state.white_king_x_file;
+    king_y_rank = board_state.white_king_y_rank;
+  }
+  else
+  {
+    king_x_file = board_state.black_king_x_file;
+    king_y_rank = board_state.black_king_y_rank;
+  }
+
+  // PAWN CHECKS
+  int pawn_y_rank = king_y_rank + PAWN_DIRECTION<color_of_king>;
+  if (pawn_y_rank >= Y_MIN && pawn_y_rank <= Y_MAX)
+  {
+    for (int capture_direction : {NEGATIVE_DIRECTION, POSITIVE_DIRECTION})
+    {
+      int pawn_x_file = king_x_file + capture_direction;
+      if (pawn_x_file < X_MIN || pawn_x_file > X_MAX)
+      {
+        continue;
+      }
+      const Piece *piece = chess_board[pawn_x_file][pawn_y_rank];
+      if (piece->piece_type == PieceType::PAWN &&
+          piece->piece_color == enemy_color)
+      {
+        check_info.checkers |= bitboard::square_bit(pawn_x_file, pawn_y_rank);
+      }
+    }
+  }
+
+  // KNIGHT CHECKS
+  for (const auto &knight_move : KNIGHT_MOVES)
+  {
+    int new_x = king_x_file + knight_move[0];
+    int new_y = king_y_rank + knight_move[1];
+    if (new_x < X_MIN || new_x > X_MAX || new_y < Y_MIN || new_y > Y_MAX)
+    {
+      continue;
+    }
+    const Piece *piece = chess_board[new_x][new_y];
+    if (piece->piece_type == PieceType::KNIGHT &&
+        piece->piece_color == enemy_color)
+    {
+      check_info.checkers |= bitboard::square_bit(new_x, new_y);
+    }
+  }
+
+  // SLIDING PIECE CHECKS AND PINS
+  // The first piece on a ray gives check if it is an enemy slider moving along
+  // the ray. If it is one of our own pieces, it is pinned if the next piece is
+  // such an enemy slider.
+  for (const auto &direction : QUEEN_DIRECTIONS)
+  {
+    bool is_diagonal = direction[0] != 0 && direction[1] != 0;
+    PieceType slider_type = is_diagonal ? PieceType::BISHOP : PieceType::ROOK;
+
+    int own_piece_x = -1;
+    int own_piece_y = -1;
+    int new_x = king_x_file + direction[0];
+    int new_y = king_y_rank + direction[1];
+    while (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN && new_y <= Y_MAX)
+    {
+      const Piece *piece = chess_board[new_x][new_y];
+      if (piece->piece_type != PieceType::EMPTY)
+      {
+        bool is_enemy_slider =
+            piece->piece_color == enemy_color &&
+            (piece->piece_type == slider_type ||
+             piece->piece_type == PieceType::QUEEN);
+        if (own_piece_x == -1 && piece->piece_color == color_of_king)
+        {
+          own_piece_x = new_x;
+          own_piece_y = new_y;
+        }
+        else
+        {
+          if (is_enemy_slider)
+          {
+            if (own_piece_x == -1)
+            {
+              check_info.checkers |= bitboard::square_bit(new_x, new_y);
+            }
+            else
+            {
+              check_info.pinned |=
+                  bitboard::square_bit(own_piece_x, own_piece_y);
+            }
+          }
+          break;
+        }
+      }
+      new_x += direction[0];
+      new_y += direction[1];
+    }
+  }
+
+  return check_info;
+}
+
+template <PieceColor attacking_color>
+auto compute_check_squares(const BoardState &board_state) -> CheckSquares
+{
+  const chess_board_type &chess_board = board_state.chess_board;
+  CheckSquares check_squares;
+
+  if constexpr (attacking_color == PieceColor::WHITE)
+  {
+    check_squares.king_x_file = board_state.black_king_x_file;
+    check_squares.king_y_rank = board_state.black_king_y_rank;
+  }
+  else
+  {
+    check_squares.king_x_file = board_state.white_king_x_file;
+    check_squares.king_y_rank = board_state.white_king_y_rank;
+  }
+  const int king_x_file = check_squares.king_x_file;
+  const int king_y_rank = check_squares.king_y_rank;
+  auto &pawn_check_squares =
+      check_squares.check_squares[static_cast<uint8_t>(PieceType::PAWN)];
+  auto &knight_check_squares =
+      check_squares.check_squares[static_cast<uint8_t>(PieceType::KNIGHT)];
+  auto &bishop_check_squares =
+      check_squares.check_squares[static_cast<uint8_t>(PieceType::BISHOP)];
+  auto &rook_check_squares =
+      check_squares.check_squares[static_cast<uint8_t>(PieceType::ROOK)];
+
+  // PAWN CHECK SQUARES
+  // Our pawns attack the king from one rank behind it, from our point of view.
+  int pawn_y_rank = king_y_rank - PAWN_DIRECTION<attacking_color>;
+  if (pawn_y_rank >= Y_MIN && pawn_y_rank <= Y_MAX)
+  {
+    for (int capture_direction : {NEGATIVE_DIRECTION, POSITIVE_DIRECTION})
+    {
+      int pawn_x_file = king_x_file + capture_direction;
+      if (pawn_x_file >= X_MIN && pawn_x_file <= X_MAX)
+      {
+        pawn_check_squares |= bitboard::square_bit(pawn_x_file, pawn_y_rank);
+      }
+    }
+  }
+
+  // KNIGHT CHECK SQUARES
+  for (const auto &knight_move : KNIGHT_MOVES)
+  {
+    int new_x = king_x_file + knight_move[0];
+    int new_y = king_y_rank + knight_move[1];
+    if (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN && new_y <= Y_MAX)
+    {
+      knight_check_squares |= bitboard::square_bit(new_x, new_y);
+    }
+  }
+
+  // SLIDING PIECE CHECK SQUARES AND DISCOVERED CHECK BLOCKERS
+  // Every square up to and including the first piece on a ray is a check
+  // square. If that first piece is ours and the next piece is our slider
+  // moving along the ray, the first piece is a discovered check blocker.
+  for (const auto &direction : QUEEN_DIRECTIONS)
+  {
+    bool is_diagonal = direction[0] != 0 && direction[1] != 0;
+    PieceType slider_type = is_diagonal ? PieceType::BISHOP : PieceType::ROOK;
+    bitboard::bitboard_type &slider_check_squares =
+        is_diagonal ? bishop_check_squares : rook_check_squares;
+
+    int blocker_x = -1;
+    int blocker_y = -1;
+    int new_x = king_x_file + direction[0];
+    int new_y = king_y_rank + direction[1];
+    while (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN && new_y <= Y_MAX)
+    {
+      const Piece *piece = chess_board[new_x][new_y];
+      if (blocker_x == -1)
+      {
+        slider_check_squares |= bitboard::square_bit(new_x, new_y);
+      }
+      if (piece->piece_type != PieceType::EMPTY)
+      {
+        if (blocker_x != -1)
+        {
+          if (piece->piece_color == attacking_color &&
+              (piece->piece_type == slider_type ||
+               piece->piece_type == PieceType::QUEEN))
+          {
+            check_squares.discovered_check_blockers |=
+                bitboard::square_bit(blocker_x, blocker_y);
+          }
+          break;
+        }
+        if (piece->piece_color != attacking_color)
+        {
+          break;
+        }
+        blocker_x = new_x;
+        blocker_y = new_y;
+      }
+      new_x += direction[0];
+      new_y += direction[1];
+    }
+  }
+
+  check_squares.check_squares[static_cast<uint8_t>(PieceType::QUEEN)] =
+      bishop_check_squares | rook_check_squares;
+
+  return check_squares;
+}
+
+auto squares_are_aligned(int x_file_1,
+                         int y_rank_1,
+                         int x_file_2,
+                         int y_rank_2,
+                         int x_file_3,
+                         int y_rank_3) -> bool
+{
+  return (x_file_2 - x_file_1) * (y_rank_3 - y_rank_1) ==
+         (y_rank_2 - y_rank_1) * (x_file_3 - x_file_1);
+}
+
+template <PieceColor color_being_attacked>
 auto square_is_attacked_by_pawn(BoardState &board_state,
-                                int &x_file,
-                                int &y_rank,
-                                PieceColor &color_being_attacked) -> bool
+                                int x_file,
+                                int y_rank) -> bool
 {
-  int pawn_direction = (color_being_attacked == PieceColor::WHITE)
-                           ? POSITIVE_DIRECTION
-                           : NEGATIVE_DIRECTION;
+  // Attacking pawns sit one rank ahead of the square, from the point of view
+  // of the color being attacked.
+  constexpr int pawn_direction = PAWN_DIRECTION<color_being_attacked>;
+  int pawn_y_rank = y_rank + pawn_direction;
+  if (pawn_y_rank < Y_MIN || pawn_y_rank > Y_MAX)
+  {
+    return false;
+  }
 
   // Check for pawn attacks in negative x direction.
-  if (x_file > X_MIN && y_rank + pawn_direction >= Y_MIN &&
-      y_rank + pawn_direction <= Y_MAX)
+  if (x_file > X_MIN)
   {
-    if (board_state.chess_board[x_file - 1][y_rank + pawn_direction]
-                ->piece_type == PieceType::PAWN &&
-        board_state.chess_board[x_file - 1][y_rank + pawn_direction]
-                ->piece_color != color_being_attacked)
+    Piece *attacking_piece = board_state.chess_board[x_file - 1][pawn_y_rank];
+    if (attacking_piece->piece_type == PieceType::PAWN &&
+        attacking_piece->piece_color == OPPOSITE_COLOR<color_being_attacked>)
     {
       return true;
     }
   }
 
   // Check for pawn attacks in positive x direction.
-  if (x_file < X_MAX && y_rank + pawn_direction >= Y_MIN &&
-      y_rank + pawn_direction <= Y_MAX)
+  if (x_file < X_MAX)
   {
-    if (board_state.chess_board[x_file + 1][y_rank + pawn_direction]
-                ->piece_type == PieceType::PAWN &&
-        board_state.chess_board[x_file + 1][y_rank + pawn_direction]
-                ->piece_color != color_being_attacked)
+    Piece *attacking_piece = board_state.chess_board[x_file + 1][pawn_y_rank];
+    if (attacking_piece->piece_type == PieceType::PAWN &&
+        attacking_piece->piece_color == OPPOSITE_COLOR<color_being_attacked>)
     {
       return true;
     }
@@ -135,10 +462,10 @@ auto square_is_attacked_by_pawn(BoardState &board_state,
   return false;
 }
 
+template <PieceColor color_being_attacked>
 auto square_is_attacked_by_knight(BoardState &board_state,
-                                  int &x_file,
-                                  int &y_rank,
-                                  PieceColor &color_being_attacked) -> bool
+                                  int x_file,
+                                  int y_rank) -> bool
 {
   return std::any_of(
       KNIGHT_MOVES.begin(), KNIGHT_MOVES.end(),
@@ -150,16 +477,15 @@ auto square_is_attacked_by_knight(BoardState &board_state,
                new_y <= Y_MAX &&
                board_state.chess_board[new_x][new_y]->piece_type ==
                    PieceType::KNIGHT &&
-               board_state.chess_board[new_x][new_y]->piece_color !=
-                   color_being_attacked;
+               board_state.chess_board[new_x][new_y]->piece_color ==
+                   OPPOSITE_COLOR<color_being_attacked>;
       });
 }
 
+template <PieceColor color_being_attacked>
 auto square_is_attacked_by_rook_or_queen(BoardState &board_state,
-                                         int &x_file,
-                                         int &y_rank,
-                                         PieceColor &color_being_attacked)
-    -> bool
+                                         int x_file,
+                                         int y_rank) -> bool
 {
   for (const auto &direction : ROOK_DIRECTIONS)
   {
@@ -172,7 +498,7 @@ auto square_is_attacked_by_rook_or_queen(BoardState &board_state,
       {
         if ((target_piece->piece_type == PieceType::ROOK ||
              target_piece->piece_type == PieceType::QUEEN) &&
-            target_piece->piece_color != color_being_attacked)
+            target_piece->piece_color == OPPOSITE_COLOR<color_being_attacked>)
         {
           return true;
         }
@@ -186,11 +512,10 @@ auto square_is_attacked_by_rook_or_queen(BoardState &board_state,
   return false;
 }
 
+template <PieceColor color_being_attacked>
 auto square_is_attacked_by_bishop_or_queen(BoardState &board_state,
-                                           int &x_file,
-                                           int &y_rank,
-                                           PieceColor &color_being_attacked)
-    -> bool
+                                           int x_file,
+                                           int y_rank) -> bool
 {
   for (const auto &direction : BISHOP_DIRECTIONS)
   {
@@ -203,7 +528,7 @@ auto square_is_attacked_by_bishop_or_queen(BoardState &board_state,
       {
         if ((target_piece->piece_type == PieceType::BISHOP ||
              target_piece->piece_type == PieceType::QUEEN) &&
-            target_piece->piece_color != color_being_attacked)
+            target_piece->piece_color == OPPOSITE_COLOR<color_being_attacked>)
         {
           return true;
         }
@@ -217,10 +542,10 @@ auto square_is_attacked_by_bishop_or_queen(BoardState &board_state,
   return false;
 }
 
+template <PieceColor color_being_attacked>
 auto square_is_attacked_by_king(BoardState &board_state,
-                                int &x_file,
-                                int &y_rank,
-                                PieceColor &color_being_attacked) -> bool
+                                int x_file,
+                                int y_rank) -> bool
 {
   // Check for king attacks.
   return std::any_of(
@@ -233,8 +558,8 @@ auto square_is_attacked_by_king(BoardState &board_state,
                new_y <= Y_MAX &&
                board_state.chess_board[new_x][new_y]->piece_type ==
                    PieceType::KING &&
-               board_state.chess_board[new_x][new_y]->piece_color !=
-                   color_being_attacked;
+               board_state.chess_board[new_x][new_y]->piece_color ==
+                   OPPOSITE_COLOR<color_being_attacked>;
       });
 }
 } // namespace engine::parts::attack_check
@@ -1,11 +1,89 @@
 #ifndef ATTACK_CHECK_H
 #define ATTACK_CHECK_H
 
+#include "bitboard.h"
 #include "board_state.h"
 #include "move.h"
 
 namespace engine::parts::attack_check
 {
+/**
+ * @brief Check state of a king, computed once per search node.
+ */
+struct CheckInfo
+{
+  // PROPERTIES
+
+  /// @brief Squares of the enemy pieces giving check to the king. Non-empty
+  /// if and only if the last move gave check.
+  bitboard::bitboard_type checkers = 0;
+
+  /// @brief Squares of the king's own pieces that are pinned to the king.
+  bitboard::bitboard_type pinned = 0;
+
+  // FUNCTIONS
+
+  /**
+   * @brief Checks if the king is in check.
+   *
+   * @return True if the king is in check, false otherwise.
+   */
+  [[nodiscard]] auto in_check() const -> bool;
+
+  /**
+   * @brief Checks if a move of the side to move can be proven legal without
+   * making it.
+   *
+   * @details A move cannot leave its own king in check if the king is not in
+   * check, the king does not move, the moving piece is not pinned and the
+   * move is not an en passant capture (which removes two pieces from a rank).
+   *
+   * @param move Move of the side this check info was computed for.
+   *
+   * @return True if the move is known to be legal, false if it must be
+   * verified after making it.
+   */
+  [[nodiscard]] auto move_is_known_legal(const Move &move) const -> bool;
+};
+
+/**
+ * @brief Squares from which the side to move would give check to the enemy
+ * king, used to answer gives_check without making the move.
+ */
+struct CheckSquares
+{
+  // PROPERTIES
+
+  /// @brief File of the enemy king.
+  int king_x_file = -1;
+
+  /// @brief Rank of the enemy king.
+  int king_y_rank = -1;
+
+  /// @brief For each piece type, the squares from which a piece of that type
+  /// attacks the enemy king.
+  std::array<bitboard::bitboard_type, NUM_OF_PIECE_TYPES> check_squares{};
+
+  /// @brief Pieces of the side to move standing between one of its sliders
+  /// and the enemy king. Moving one of them off the line gives a discovered
+  /// check.
+  bitboard::bitboard_type discovered_check_blockers = 0;
+};
+
+/**
+ * @brief Computes the checkers and the pinned pieces of the given king.
+ *
+ * @details Scans outwards from the king once, along every ray and from every
+ * knight and pawn square, instead of running separate attack checks.
+ *
+ * @param board_state The current state of the chess board.
+ * @param color_of_king The color of the king (WHITE or BLACK).
+ *
+ * @return Check state of the king.
+ */
+auto compute_check_info(const BoardState &board_state,
+                        PieceColor color_of_king) -> CheckInfo;
+
 /**
  * @brief Checks if the given square is attacked.
  *
@@ -21,6 +99,34 @@ auto square_is_attacked(BoardState &board_state,
                         int y_rank,
                         PieceColor color_being_attacked) -> bool;
 
+/**
+ * @brief Computes the check squares and discovered check blockers of the side
+ * to move.
+ *
+ * @param board_state The current state of the chess board.
+ *
+ * @return Check squares against the enemy king.
+ */
+auto compute_check_squares(const BoardState &board_state) -> CheckSquares;
+
+/**
+ * @brief Checks if a move of the side to move gives check, without making it.
+ *
+ * @details Direct checks are found with the check squares of the piece type
+ * landing on the target square, and discovered checks with the discovered
+ * check blockers. Promotions, en passant captures and castling change more
+ * than one square, so they are verified by making the move.
+ *
+ * @param board_state The current state of the chess board.
+ * @param move Move of the side to move.
+ * @param check_squares Check squares computed for the current board state.
+ *
+ * @return True if the move gives check, false otherwise.
+ */
+auto gives_check(BoardState &board_state,
+                 Move &move,
+                 const CheckSquares &check_squares) -> bool;
+
 /**
  * @brief Checks if the current player is in checkmate.
  *
@@ -65,86 +171,163 @@ auto king_is_checked(BoardState &board_state, PieceColor color_of_king) -> bool;
  */
 auto move_leaves_king_in_check(BoardState &board_state, Move &move) -> bool;
 
+/**
+ * @brief Checks if the given square is attacked, with the color of the pieces
+ * being attacked fixed at compile time.
+ *
+ * @tparam color_being_attacked The color of the pieces being attacked.
+ *
+ * @param board_state The current state of the chess board.
+ * @param x_file The x coordinate of the square (file).
+ * @param y_rank The y coordinate of the square (rank).
+ *
+ * @return True if the square is attacked, false otherwise.
+ */
+template <PieceColor color_being_attacked>
+static auto
+square_is_attacked(BoardState &board_state, int x_file, int y_rank) -> bool;
+
+/**
+ * @brief Checks if the king of the given color is in check, with the color
+ * fixed at compile time.
+ *
+ * @tparam color_of_king The color of the king to check (WHITE or BLACK).
+ *
+ * @param board_state The current state of the chess board.
+ *
+ * @return True if the king is in check, false otherwise.
+ */
+template <PieceColor color_of_king>
+static auto king_is_checked(BoardState &board_state) -> bool;
+
+/**
+ * @brief Computes the checkers and the pinned pieces of the given king, with
+ * the color fixed at compile time.
+ *
+ * @tparam color_of_king The color of the king (WHITE or BLACK).
+ *
+ * @param board_state The current state of the chess board.
+ *
+ * @return Check state of the king.
+ */
+template <PieceColor color_of_king>
+static auto compute_check_info(const BoardState &board_state) -> CheckInfo;
+
+/**
+ * @brief Computes the check squares and discovered check blockers of the side
+ * to move, with its color fixed at compile time.
+ *
+ * @tparam attacking_color The color of the side to move.
+ *
+ * @param board_state The current state of the chess board.
+ *
+ * @return Check squares against the enemy king.
+ */
+template <PieceColor attacking_color>
+static auto compute_check_squares(const BoardState &board_state)
+    -> CheckSquares;
+
+/**
+ * @brief Checks if three squares are on the same line.
+ *
+ * @param x_file_1, y_rank_1 The first square.
+ * @param x_file_2, y_rank_2 The second square.
+ * @param x_file_3, y_rank_3 The third square.
+ *
+ * @return True if the squares are on the same line, false otherwise.
+ */
+static auto squares_are_aligned(int x_file_1,
+                                int y_rank_1,
+                                int x_file_2,
+                                int y_rank_2,
+                                int x_file_3,
+                                int y_rank_3) -> bool;
+
 /**
  * @brief Helper function to check if a square is attacked by a pawn.
  *
+ * @tparam color_being_attacked The color of the pieces being attacked.
+ *
  * @param board_state The current state of the chess board.
- * @param x_file The x coordinate of the pawn.
- * @param y_rank The y coordinate of the pawn.
- * @param color_being_attacked The color of the pieces being attacked.
+ * @param x_file The x coordinate of the square.
+ * @param y_rank The y coordinate of the square.
  *
  * @return True if the square is attacked, false otherwise.
  */
+template <PieceColor color_being_attacked>
 static auto
 square_is_attacked_by_pawn(BoardState &board_state,
-                           int &x_file,
-                           int &y_rank,
-                           PieceColor &color_being_attacked) -> bool;
+                           int x_file,
+                           int y_rank) -> bool;
 
 /**
  * @brief Helper function to check if a square is attacked by a knight.
  *
+ * @tparam color_being_attacked The color of the pieces being attacked.
+ *
  * @param board_state The current state of the chess board.
- * @param x_file The x coordinate of the knight.
- * @param y_rank The y coordinate of the knight.
- * @param color_being_attacked The color of the pieces being attacked.
+ * @param x_file The x coordinate of the square.
+ * @param y_rank The y coordinate of the square.
  *
  * @return True if the square is attacked, false otherwise.
  */
+template <PieceColor color_being_attacked>
 static auto
 square_is_attacked_by_knight(BoardState &board_state,
-                             int &x_file,
-                             int &y_rank,
-                             PieceColor &color_being_attacked) -> bool;
+                             int x_file,
+                             int y_rank) -> bool;
 
 /**
  * @brief Helper function to check if a square is attacked by a rook or queen.
  *
+ * @tparam color_being_attacked The color of the pieces being attacked.
+ *
  * @param board_state The current state of the chess board.
- * @param x_file The x coordinate of the rook or queen.
- * @param y_rank The y coordinate of the rook or queen.
- * @param color_being_attacked The color of the pieces being attacked.
+ * @param x_file The x coordinate of the square.
+ * @param y_rank The y coordinate of the square.
  *
  * @return True if the square is attacked, false otherwise.
  */
+template <PieceColor color_being_attacked>
 static auto
 square_is_attacked_by_rook_or_queen(BoardState &board_state,
-                                    int &x_file,
-                                    int &y_rank,
-                                    PieceColor &color_being_attacked) -> bool;
+                                    int x_file,
+                                    int y_rank) -> bool;
 
 /**
  * @brief Helper function to check if a square is attacked by a bishop or
  * queen.
  *
+ * @tparam color_being_attacked The color of the pieces being attacked.
+ *
  * @param board_state The current state of the chess board.
- * @param x_file The x coordinate of the bishop or queen.
- * @param y_rank The y coordinate of the bishop or queen.
- * @param color_being_attacked The color of the pieces being attacked.
+ * @param x_file The x coordinate of the square.
+ * @param y_rank The y coordinate of the square.
  *
  * @return True if the square is attacked, false otherwise.
  */
+template <PieceColor color_being_attacked>
 static auto
 square_is_attacked_by_bishop_or_queen(BoardState &board_state,
-                                      int &x_file,
-                                      int &y_rank,
-                                      PieceColor &color_being_attacked) -> bool;
+                                      int x_file,
+                                      int y_rank) -> bool;
 
 /**
  * @brief Helper function to check if a square is attacked by a king.
  *
+ * @tparam color_being_attacked The color of the pieces being attacked.
+ *
  * @param board_state The current state of the chess board.
- * @param x_file The x coordinate of the king.
- * @param y_rank The y coordinate of the king.
- * @param color_being_attacked The color of the pieces being attacked.
+ * @param x_file The x coordinate of the square.
+ * @param y_rank The y coordinate of the square.
  *
  * @return True if the square is attacked, false otherwise.
  */
+template <PieceColor color_being_attacked>
 static auto
 square_is_attacked_by_king(BoardState &board_state,
-                           int &x_file,
-                           int &y_rank,
-                           PieceColor &color_being_attacked) -> bool;
+                           int x_file,
+                           int y_rank) -> bool;
 } // namespace engine::parts::attack_check
 
 #endif // ATTACK_CHECK_H
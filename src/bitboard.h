@@ -0,0 +1,284 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "engine_constants.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Namespace for bitboard helpers.
+ *
+ * @details A bitboard is a 64 bit set of squares, where the square (x_file,
+ * y_rank) is bit y_rank * 8 + x_file, the same square index used by the
+ * Zobrist keys.
+ */
+namespace engine::parts::bitboard
+{
+/// @brief 64 bit set of squares.
+using bitboard_type = uint64_t;
+
+/// @brief One bitboard per square.
+using square_table_type = std::array<bitboard_type, NUM_OF_SQUARES>;
+
+/// @brief Number of occupancies of the six inner squares of a rank.
+const int RANK_OCCUPANCIES = 64;
+
+/**
+ * @brief Gets the bitboard with only the given square set.
+ *
+ * @param x_file The x coordinate of the square (file).
+ * @param y_rank The y coordinate of the square (rank).
+ *
+ * @return Bitboard of the square.
+ */
+constexpr auto square_bit(int x_file, int y_rank) -> bitboard_type
+{
+  return bitboard_type{1} << ((y_rank * 8) + x_file);
+}
+
+/**
+ * @brief Checks if the given square is set in a bitboard.
+ *
+ * @param bitboard Bitboard to check.
+ * @param x_file The x coordinate of the square (file).
+ * @param y_rank The y coordinate of the square (rank).
+ *
+ * @return True if the square is set, false otherwise.
+ */
+constexpr auto contains(bitboard_type bitboard, int x_file, int y_rank) -> bool
+{
+  return (bitboard & square_bit(x_file, y_rank)) != 0;
+}
+
+/**
+ * @brief Removes the lowest square from a bitboard.
+ *
+ * @details Used to walk the squares of a bitboard, lowest square first.
+ *
+ * @param bitboard Bitboard to remove the square from, must not be empty.
+ *
+ * @return Index of the removed square.
+ */
+constexpr auto pop_lowest_square(bitboard_type &bitboard) -> int
+{
+  int square = std::countr_zero(bitboard);
+  bitboard &= bitboard - 1;
+  return square;
+}
+
+/**
+ * @brief Builds the squares a leaping piece attacks from every square.
+ *
+ * @tparam num_of_moves Number of offsets.
+ *
+ * @param moves Offsets the piece can jump by.
+ *
+ * @return Attacked squares, indexed by square.
+ */
+template <size_t num_of_moves>
+constexpr auto build_leaper_attacks(
+    const std::array<std::array<int, 2>, num_of_moves> &moves)
+    -> square_table_type
+{
+  square_table_type attacks{};
+  for (int square = 0; square < NUM_OF_SQUARES; ++square)
+  {
+    for (const auto &move : moves)
+    {
+      int x_file = (square % BOARD_WIDTH) + move[0];
+      int y_rank = (square / BOARD_WIDTH) + move[1];
+      if (x_file >= X_MIN && x_file <= X_MAX && y_rank >= Y_MIN &&
+          y_rank <= Y_MAX)
+      {
+        attacks[square] |= square_bit(x_file, y_rank);
+      }
+    }
+  }
+  return attacks;
+}
+
+/**
+ * @brief Builds the line through every square along a direction and its
+ * opposite, up to the board edges and excluding the square itself.
+ *
+ * @param x_step File step of the direction.
+ * @param y_step Rank step of the direction.
+ *
+ * @return Lines, indexed by square.
+ */
+constexpr auto build_line_masks(int x_step, int y_step) -> square_table_type
+{
+  square_table_type line_masks{};
+  for (int square = 0; square < NUM_OF_SQUARES; ++square)
+  {
+    for (int side = -1; side <= 1; side += 2)
+    {
+      int x_file = (square % BOARD_WIDTH) + (side * x_step);
+      int y_rank = (square / BOARD_WIDTH) + (side * y_step);
+      while (x_file >= X_MIN && x_file <= X_MAX && y_rank >= Y_MIN &&
+             y_rank <= Y_MAX)
+      {
+        line_masks[square] |= square_bit(x_file, y_rank);
+        x_file += side * x_step;
+        y_rank += side * y_step;
+      }
+    }
+  }
+  return line_masks;
+}
+
+/**
+ * @brief Builds the squares a rook attacks along a rank, for every file and
+ * every occupancy of the six inner squares of the rank.
+ *
+ * @return Attacked files as a rank bitmask, indexed by file then inner
+ * occupancy.
+ */
+constexpr auto build_rank_attacks()
+    -> std::array<std::array<uint8_t, RANK_OCCUPANCIES>, BOARD_WIDTH>
+{
+  std::array<std::array<uint8_t, RANK_OCCUPANCIES>, BOARD_WIDTH> attacks{};
+  for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
+  {
+    for (int inner_occupancy = 0; inner_occupancy < RANK_OCCUPANCIES;
+         ++inner_occupancy)
+    {
+      // The edge squares are always attacked if reached, so only the inner
+      // squares are part of the occupancy.
+      int occupancy = inner_occupancy << 1;
+      for (int side = -1; side <= 1; side += 2)
+      {
+        for (int current_file = x_file + side;
+             current_file >= X_MIN && current_file <= X_MAX;
+             current_file += side)
+        {
+          attacks[x_file][inner_occupancy] |= 1 << current_file;
+          if ((occupancy & (1 << current_file)) != 0)
+          {
+            break;
+          }
+        }
+      }
+    }
+  }
+  return attacks;
+}
+
+/// @brief Squares a knight attacks from every square.
+inline constexpr square_table_type KNIGHT_ATTACKS =
+    build_leaper_attacks(KNIGHT_MOVES);
+
+/// @brief Squares a king attacks from every square.
+inline constexpr square_table_type KING_ATTACKS =
+    build_leaper_attacks(KING_MOVES);
+
+/// @brief Squares a pawn of each color attacks from every square.
+inline constexpr std::array<square_table_type, NUM_OF_COLORS> PAWN_ATTACKS = {
+    build_leaper_attacks(std::array<std::array<int, 2>, 2>{
+        {{-1, PAWN_DIRECTION<PieceColor::WHITE>},
+         {1, PAWN_DIRECTION<PieceColor::WHITE>}}}),
+    build_leaper_attacks(std::array<std::array<int, 2>, 2>{
+        {{-1, PAWN_DIRECTION<PieceColor::BLACK>},
+         {1, PAWN_DIRECTION<PieceColor::BLACK>}}})};
+
+/// @brief File through every square, excluding the square.
+inline constexpr square_table_type FILE_LINE_MASKS = build_line_masks(0, 1);
+
+/// @brief Diagonal (a1 to h8 direction) through every square, excluding the
+/// square.
+inline constexpr square_table_type DIAGONAL_LINE_MASKS =
+    build_line_masks(1, 1);
+
+/// @brief Anti-diagonal (h1 to a8 direction) through every square, excluding
+/// the square.
+inline constexpr square_table_type ANTI_DIAGONAL_LINE_MASKS =
+    build_line_masks(-1, 1);
+
+/// @brief Rank attacks of a rook, see build_rank_attacks.
+inline constexpr std::array<std::array<uint8_t, RANK_OCCUPANCIES>, BOARD_WIDTH>
+    RANK_ATTACKS = build_rank_attacks();
+
+/**
+ * @brief Reverses the ranks of a bitboard, mirroring it vertically.
+ *
+ * @param bitboard Bitboard to mirror.
+ *
+ * @return Mirrored bitboard.
+ */
+constexpr auto flip_vertical(bitboard_type bitboard) -> bitboard_type
+{
+  // Compilers turn this into a single byte swap instruction.
+  bitboard = ((bitboard >> 8) & 0x00FF00FF00FF00FF) |
+             ((bitboard & 0x00FF00FF00FF00FF) << 8);
+  bitboard = ((bitboard >> 16) & 0x0000FFFF0000FFFF) |
+             ((bitboard & 0x0000FFFF0000FFFF) << 16);
+  return (bitboard >> 32) | (bitboard << 32);
+}
+
+/**
+ * @brief Gets the squares a slider attacks along a line that crosses every
+ * rank at most once (a file or a diagonal).
+ *
+ * @details Subtracting the slider's bit from the blockers carries up to and
+ * including the nearest blocker above the slider. Doing the same on the
+ * vertically mirrored board finds the nearest blocker below it.
+ *
+ * @param line_mask Line through the square, excluding the square.
+ * @param square Square of the slider.
+ * @param occupied Bitboard of all pieces on the board.
+ *
+ * @return Attacked squares on the line.
+ */
+constexpr auto line_attacks(bitboard_type line_mask,
+                            int square,
+                            bitboard_type occupied) -> bitboard_type
+{
+  bitboard_type slider = bitboard_type{1} << square;
+  bitboard_type forward = occupied & line_mask;
+  bitboard_type reverse = flip_vertical(forward);
+  forward -= slider;
+  reverse -= flip_vertical(slider);
+  return (forward ^ flip_vertical(reverse)) & line_mask;
+}
+
+/**
+ * @brief Gets the squares a rook attacks.
+ *
+ * @param square Square of the rook.
+ * @param occupied Bitboard of all pieces on the board.
+ *
+ * @return Attacked squares.
+ */
+constexpr auto rook_attacks(int square, bitboard_type occupied)
+    -> bitboard_type
+{
+  const int rank_shift = square - (square % BOARD_WIDTH);
+  const auto inner_occupancy =
+      static_cast<int>((occupied >> (rank_shift + 1)) & (RANK_OCCUPANCIES - 1));
+  bitboard_type rank_attacks =
+      bitboard_type{RANK_ATTACKS[square % BOARD_WIDTH][inner_occupancy]}
+      << rank_shift;
+  return rank_attacks |
+         line_attacks(FILE_LINE_MASKS[square], square, occupied);
+}
+
+/**
+ * @brief Gets the squares a bishop attacks.
+ *
+ * @param square Square of the bishop.
+ * @param occupied Bitboard of all pieces on the board.
+ *
+ * @return Attacked squares.
+ */
+constexpr auto bishop_attacks(int square, bitboard_type occupied)
+    -> bitboard_type
+{
+  return line_attacks(DIAGONAL_LINE_MASKS[square], square, occupied) |
+         line_attacks(ANTI_DIAGONAL_LINE_MASKS[square], square, occupied);
+}
+} // namespace engine::parts::bitboard
+
+#endif // BITBOARD_H
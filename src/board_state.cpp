@@ -1,7 +1,7 @@
 #include "board_state.h"
 
 #include <algorithm>
-#include <random>
+#include <bit>
 
 namespace engine::parts
 {
@@ -9,65 +9,23 @@ namespace engine::parts
 
 BoardState::BoardState(PieceColor color_to_move) : color_to_move(color_to_move)
 {
-  initialize_zobrist_keys();
+  state_history.reserve(STATE_HISTORY_RESERVE_SIZE);
   setup_default_board();
-  add_current_state_to_visited_states();
 }
 
 BoardState::BoardState(const BoardState &other)
-    : color_to_move(other.color_to_move),
-      previous_move_stack(other.previous_move_stack),
-      zobrist_keys(other.zobrist_keys),
-      zobrist_side_to_move(other.zobrist_side_to_move),
-      queens_on_board(other.queens_on_board),
-      number_of_main_pieces_left(other.number_of_main_pieces_left),
-      is_end_game(other.is_end_game),
-      visisted_states_hash_map(other.visisted_states_hash_map),
-      visisted_states_hash_stack(other.visisted_states_hash_stack),
-      empty_piece(other.empty_piece),
-      white_king_x_file(other.white_king_x_file),
-      white_king_y_rank(other.white_king_y_rank),
-      black_king_x_file(other.black_king_x_file),
-      black_king_y_rank(other.black_king_y_rank),
-      white_has_castled(other.white_has_castled),
-      black_has_castled(other.black_has_castled)
+    : state_history(other.state_history),
+      nnue_accumulators(other.nnue_accumulators)
 {
-  for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
-  {
-    for (int y_rank = Y_MIN; y_rank <= Y_MAX; ++y_rank)
-    {
-      if (other.chess_board[x_file][y_rank] != nullptr)
-      {
-        chess_board[x_file][y_rank] =
-            new Piece(*other.chess_board[x_file][y_rank]);
-      }
-      else
-      {
-        chess_board[x_file][y_rank] = nullptr;
-      }
-    }
-  }
-  // Update pointers in piece_list to point to the new pieces.
-  for (Piece *piece_pointer : other.piece_list)
-  {
-    if (piece_pointer->x_file != -1 && piece_pointer->y_rank != -1)
-    {
-      piece_list.push_back(
-          chess_board[piece_pointer->x_file][piece_pointer->y_rank]);
-    }
-    else
-    {
-      piece_list.push_back(new Piece(*piece_pointer));
-    }
-  }
+  state_history.reserve(STATE_HISTORY_RESERVE_SIZE);
+  copy_position(other);
 }
 
-BoardState::~BoardState() { clear_pointers(); }
-
 // PUBLIC FUNCTIONS
 
 void BoardState::setup_default_board()
 {
+  piece_pool_size = 0;
   // Set empty squares.
   for (int y_rank = Y2_RANK; y_rank <= Y6_RANK; ++y_rank)
   {
@@ -79,68 +37,47 @@ void BoardState::setup_default_board()
   // Set Pawns.
   for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
   {
-    chess_board[x_file][Y2_RANK] =
-        new Piece(x_file, Y2_RANK, PieceType::PAWN, PieceColor::WHITE);
-    chess_board[x_file][Y7_RANK] =
-        new Piece(x_file, Y7_RANK, PieceType::PAWN, PieceColor::BLACK);
+    place_piece(x_file, Y2_RANK, PieceType::PAWN, PieceColor::WHITE);
+    place_piece(x_file, Y7_RANK, PieceType::PAWN, PieceColor::BLACK);
   }
   // Set Rooks.
-  chess_board[XA_FILE][Y1_RANK] =
-      new Piece(XA_FILE, Y1_RANK, PieceType::ROOK, PieceColor::WHITE);
-  chess_board[XH_FILE][Y1_RANK] =
-      new Piece(XH_FILE, Y1_RANK, PieceType::ROOK, PieceColor::WHITE);
-  chess_board[XA_FILE][Y8_RANK] =
-      new Piece(XA_FILE, Y8_RANK, PieceType::ROOK, PieceColor::BLACK);
-  chess_board[XH_FILE][Y8_RANK] =
-      new Piece(XH_FILE, Y8_RANK, PieceType::ROOK, PieceColor::BLACK);
+  place_piece(XA_FILE, Y1_RANK, PieceType::ROOK, PieceColor::WHITE);
+  place_piece(XH_FILE, Y1_RANK, PieceType::ROOK, PieceColor::WHITE);
+  place_piece(XA_FILE, Y8_RANK, PieceType::ROOK, PieceColor::BLACK);
+  place_piece(XH_FILE, Y8_RANK, PieceType::ROOK, PieceColor::BLACK);
   // Set Knights.
-  chess_board[XB_FILE][Y1_RANK] =
-      new Piece(XB_FILE, Y1_RANK, PieceType::KNIGHT, PieceColor::WHITE);
-  chess_board[XG_FILE][Y1_RANK] =
-      new Piece(XG_FILE, Y1_RANK, PieceType::KNIGHT, PieceColor::WHITE);
-  chess_board[XB_FILE][Y8_RANK] =
-      new Piece(XB_FILE, Y8_RANK, PieceType::KNIGHT, PieceColor::BLACK);
-  chess_board[XG_FILE][Y8_RANK] =
-      new Piece(XG_FILE, Y8_RANK, PieceType::KNIGHT, PieceColor::BLACK);
+  place_piece(XB_FILE, Y1_RANK, PieceType::KNIGHT, PieceColor::WHITE);
+  place_piece(XG_FILE, Y1_RANK, PieceType::KNIGHT, PieceColor::WHITE);
+  place_piece(XB_FILE, Y8_RANK, PieceType::KNIGHT, PieceColor::BLACK);
+  place_piece(XG_FILE, Y8_RANK, PieceType::KNIGHT, PieceColor::BLACK);
   // Set Bishops.
-  chess_board[XC_FILE][Y1_RANK] =
-      new Piece(XC_FILE, Y1_RANK, PieceType::BISHOP, PieceColor::WHITE);
-  chess_board[XF_FILE][Y1_RANK] =
-      new Piece(XF_FILE, Y1_RANK, PieceType::BISHOP, PieceColor::WHITE);
-  chess_board[XC_FILE][Y8_RANK] =
-      new Piece(XC_FILE, Y8_RANK, PieceType::BISHOP, PieceColor::BLACK);
-  chess_board[XF_FILE][Y8_RANK] =
-      new Piece(XF_FILE, Y8_RANK, PieceType::BISHOP, PieceColor::BLACK);
+  place_piece(XC_FILE, Y1_RANK, PieceType::BISHOP, PieceColor::WHITE);
+  place_piece(XF_FILE, Y1_RANK, PieceType::BISHOP, PieceColor::WHITE);
+  place_piece(XC_FILE, Y8_RANK, PieceType::BISHOP, PieceColor::BLACK);
+  place_piece(XF_FILE, Y8_RANK, PieceType::BISHOP, PieceColor::BLACK);
   // Set Queens.
-  chess_board[XD_FILE][Y1_RANK] =
-      new Piece(XD_FILE, Y1_RANK, PieceType::QUEEN, PieceColor::WHITE);
-  chess_board[XD_FILE][Y8_RANK] =
-      new Piece(XD_FILE, Y8_RANK, PieceType::QUEEN, PieceColor::BLACK);
+  place_piece(XD_FILE, Y1_RANK, PieceType::QUEEN, PieceColor::WHITE);
+  place_piece(XD_FILE, Y8_RANK, PieceType::QUEEN, PieceColor::BLACK);
   // Set Kings.
-  chess_board[XE_FILE][Y1_RANK] =
-      new Piece(XE_FILE, Y1_RANK, PieceType::KING, PieceColor::WHITE);
-  chess_board[XE_FILE][Y8_RANK] =
-      new Piece(XE_FILE, Y8_RANK, PieceType::KING, PieceColor::BLACK);
-
-  update_pieces_list();
-  add_current_state_to_visited_states();
+  place_piece(XE_FILE, Y1_RANK, PieceType::KING, PieceColor::WHITE);
+  place_piece(XE_FILE, Y8_RANK, PieceType::KING, PieceColor::BLACK);
+
+  update_piece_square_scores();
+  update_pawn_hash();
+  update_bitboards();
+  update_attack_tables();
+  refresh_nnue_accumulators();
+  initialize_state_history();
 }
 
 void BoardState::reset_board()
 {
-  // Empty previous move stack.
-  while (!previous_move_stack.empty())
+  // Undo all moves.
+  while (game_ply() > 0)
   {
     undo_move();
   }
 
-  // Clear visited states hash map and stack.
-  visisted_states_hash_map.clear();
-  while (!visisted_states_hash_stack.empty())
-  {
-    visisted_states_hash_stack.pop();
-  }
-
   color_to_move = PieceColor::WHITE;
   queens_on_board = INITIAL_QUEENS_COUNT;
   number_of_main_pieces_left = INITIAL_MAIN_PIECES_COUNT;
@@ -152,7 +89,6 @@ void BoardState::reset_board()
   black_has_castled = false;
   is_end_game = false;
 
-  clear_pointers();
   setup_default_board();
 }
 
@@ -201,6 +137,9 @@ void BoardState::print_board(PieceColor color)
 
 void BoardState::apply_move(Move &move)
 {
+  manage_piece_square_scores(move, POSITIVE_DIRECTION);
+  manage_pawn_hash(move);
+
   if (move.capture_is_en_passant)
   {
     // Clear old square (point to empty_piece).
@@ -293,21 +232,31 @@ void BoardState::apply_move(Move &move)
   color_to_move = (color_to_move == PieceColor::WHITE) ? PieceColor::BLACK
                                                        : PieceColor::WHITE;
 
-  // Store move in previous moves stack for undoing moves.
-  previous_move_stack.push(move);
   manage_piece_counts_on_apply(move);
 
-  // Update hash for new board state.
-  add_current_state_to_visited_states();
+  bitboard::bitboard_type previous_occupied = occupied;
+  manage_bitboards(move);
+  if (attack_tables_enabled)
+  {
+    manage_attack_tables(move, previous_occupied);
+  }
+
+  if (nnue_network != nullptr)
+  {
+    push_nnue_accumulator(move);
+  }
+
+  // Store the new state for undoing moves and detecting repetitions.
+  push_state(move);
 }
 
 void BoardState::undo_move()
 {
-  if (previous_move_stack.empty())
+  if (game_ply() == 0)
   {
     return;
   }
-  Move &move = previous_move_stack.top();
+  Move &move = state_history.back().move;
   if (move.capture_is_en_passant)
   {
     // Update position of captured piece.
@@ -400,12 +349,36 @@ void BoardState::undo_move()
   color_to_move = (color_to_move == PieceColor::WHITE) ? PieceColor::BLACK
                                                        : PieceColor::WHITE;
 
-  // Remove move from moves stack, move is undone.
-  previous_move_stack.pop();
   manage_piece_counts_on_undo(move);
 
-  // Update hash for new board state.
-  remove_current_state_from_visited_states();
+  bitboard::bitboard_type previous_occupied = occupied;
+  manage_bitboards(move);
+  if (attack_tables_enabled)
+  {
+    manage_attack_tables(move, previous_occupied);
+  }
+
+  // Remove the state of the move, move is undone. The move reference is no
+  // longer valid after this. The incrementally updated scores are restored
+  // from the previous state.
+  state_history.pop_back();
+  const StateInfo &previous_state = state_history.back();
+  piece_square_scores = previous_state.piece_square_scores;
+  pawn_hash = previous_state.pawn_hash;
+
+  if (nnue_network != nullptr)
+  {
+    // Moves applied before the network was set have no accumulator to return
+    // to.
+    if (nnue_accumulators.size() > 1)
+    {
+      nnue_accumulators.pop_back();
+    }
+    else
+    {
+      refresh_nnue_accumulators();
+    }
+  }
 }
 
 void BoardState::apply_null_move()
@@ -413,8 +386,17 @@ void BoardState::apply_null_move()
   // Update move color, it is now the other player's turn.
   color_to_move = (color_to_move == PieceColor::WHITE) ? PieceColor::BLACK
                                                        : PieceColor::WHITE;
-  // Need to update hash since color_to_move also affects hash of board state.
-  add_current_state_to_visited_states();
+  // Need to store a new state since color_to_move also affects hash of board
+  // state. A null move passes up any en passant capture.
+  const StateInfo &previous_state = state_history.back();
+  StateInfo null_move_state;
+  null_move_state.piece_square_scores = previous_state.piece_square_scores;
+  null_move_state.pawn_hash = previous_state.pawn_hash;
+  null_move_state.castling_rights = previous_state.castling_rights;
+  null_move_state.hash =
+      compute_zobrist_hash(null_move_state.castling_rights, NO_SQUARE);
+  null_move_state.halfmove_clock = previous_state.halfmove_clock + 1;
+  state_history.push_back(null_move_state);
 }
 
 void BoardState::undo_null_move()
@@ -422,23 +404,50 @@ void BoardState::undo_null_move()
   // Update move color, it is now the other player's turn.
   color_to_move = (color_to_move == PieceColor::WHITE) ? PieceColor::BLACK
                                                        : PieceColor::WHITE;
-  // Need to update hash since color_to_move also affects hash of board state.
-  remove_current_state_from_visited_states();
+  state_history.pop_back();
 }
 
-void BoardState::clear_chess_board()
+void BoardState::copy_make(const BoardState &parent, const Move &move)
 {
-  // Empty previous move stack.
-  while (!previous_move_stack.empty())
+  copy_position(parent);
+
+  // Positions before the last capture or pawn move cannot repeat.
+  const int first_reversible_ply = std::max(
+      0, parent.game_ply() - parent.state_history.back().halfmove_clock);
+  state_history.assign(parent.state_history.begin() + first_reversible_ply,
+                       parent.state_history.end());
+
+  nnue_accumulators.clear();
+  if (!parent.nnue_accumulators.empty())
   {
-    undo_move();
+    nnue_accumulators.push_back(parent.nnue_accumulators.back());
   }
 
-  // Clear visited states hash map and stack.
-  visisted_states_hash_map.clear();
-  while (!visisted_states_hash_stack.empty())
+  // The move points to the pieces of the parent.
+  Move child_move = move;
+  child_move.moving_piece = translate_piece(parent, move.moving_piece);
+  child_move.captured_piece = translate_piece(parent, move.captured_piece);
+  apply_move(child_move);
+}
+
+auto BoardState::place_piece(int x_file,
+                             int y_rank,
+                             PieceType piece_type,
+                             PieceColor piece_color,
+                             bool piece_has_moved) -> Piece *
+{
+  Piece *piece = &piece_pool[piece_pool_size++];
+  *piece = Piece(x_file, y_rank, piece_type, piece_color, piece_has_moved);
+  chess_board[x_file][y_rank] = piece;
+  return piece;
+}
+
+void BoardState::clear_chess_board()
+{
+  // Undo all moves.
+  while (game_ply() > 0)
   {
-    visisted_states_hash_stack.pop();
+    undo_move();
   }
 
   color_to_move = PieceColor::NONE;
@@ -451,74 +460,95 @@ void BoardState::clear_chess_board()
   white_has_castled = false;
   black_has_castled = false;
   is_end_game = false;
+  piece_square_scores.fill(0);
+  pawn_hash = 0;
+  for (auto &color_piece_bitboards : piece_bitboards)
+  {
+    color_piece_bitboards.fill(0);
+  }
+  color_bitboards.fill(0);
+  occupied = 0;
+  square_attacks.fill(0);
+  color_attacks.fill(0);
+  nnue_accumulators.clear();
+
+  // All empty squares point to the same empty piece.
+  for (auto &file : chess_board)
+  {
+    file.fill(&empty_piece);
+  }
+  piece_pool_size = 0;
+  initialize_state_history();
+}
+
+auto BoardState::get_current_state_hash() -> uint64_t
+{
+  return state_history.back().hash;
+}
+
+auto BoardState::compute_zobrist_hash(int castling_rights,
+                                      int en_passant_square) const -> uint64_t
+{
+  uint64_t hash = 0;
 
   for (int y_rank = Y_MIN; y_rank <= Y_MAX; ++y_rank)
   {
     for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
     {
-      // Clear old piece to avoid memory leaks. All empty squares point to the
-      // same empty piece.
-      if (chess_board[x_file][y_rank] != &empty_piece)
+      Piece *piece = chess_board[x_file][y_rank];
+      if (piece->piece_type != PieceType::EMPTY)
       {
-        delete chess_board[x_file][y_rank];
-        chess_board[x_file][y_rank] = &empty_piece;
+        int piece_index = static_cast<int>(piece->piece_type);
+        int color_index = (piece->piece_color == PieceColor::WHITE) ? 0 : 1;
+        hash ^= zobrist::KEYS.pieces[(y_rank * BOARD_WIDTH) + x_file]
+                                    [piece_index][color_index];
       }
     }
   }
-}
 
-auto BoardState::get_current_state_hash() -> uint64_t
-{
-  if (visisted_states_hash_stack.empty())
+  if (color_to_move == PieceColor::BLACK)
   {
-    return 0;
+    hash ^= zobrist::KEYS.side_to_move;
   }
-  return visisted_states_hash_stack.top();
+
+  hash ^= zobrist::KEYS.castling_rights[castling_rights];
+  if (en_passant_square != NO_SQUARE)
+  {
+    hash ^= zobrist::KEYS.en_passant_files[en_passant_square % BOARD_WIDTH];
+  }
+
+  return hash;
 }
 
 auto BoardState::current_state_has_been_repeated_three_times() -> bool
 {
-  return visisted_states_hash_map[get_current_state_hash()] >= 3;
+  return count_current_state_occurrences() >= 3;
 }
 
 auto BoardState::current_state_has_been_visited() -> bool
 {
-  return visisted_states_hash_map[get_current_state_hash()] > 1;
+  return count_current_state_occurrences() > 1;
 }
 
-void BoardState::add_current_state_to_visited_states()
+auto BoardState::game_ply() const -> int
 {
-  uint64_t current_state_hash = compute_zobrist_hash();
-  visisted_states_hash_stack.push(current_state_hash);
-  if (visisted_states_hash_map.find(current_state_hash) ==
-      visisted_states_hash_map.end())
-  {
-    // If the state has never been visited, it will be added to the map with a
-    // count of 1.
-    visisted_states_hash_map[current_state_hash] = 1;
-  }
-  else
-  {
-    // If the state has been visited before, the count will be incremented by 1.
-    visisted_states_hash_map[current_state_hash]++;
-  }
+  return static_cast<int>(state_history.size()) - 1;
 }
 
-void BoardState::remove_current_state_from_visited_states()
+void BoardState::initialize_state_history(int en_passant_square,
+                                          int halfmove_clock)
 {
-  uint64_t current_state_hash = get_current_state_hash();
-  if (visisted_states_hash_map.find(current_state_hash) !=
-      visisted_states_hash_map.end())
-  {
-    // If the state has been visited before, the count will be decremented by 1.
-    visisted_states_hash_map[current_state_hash]--;
-    if (visisted_states_hash_map[current_state_hash] == 0)
-    {
-      // If the count is 0, the state will be removed from the map.
-      visisted_states_hash_map.erase(current_state_hash);
-    }
-  }
-  visisted_states_hash_stack.pop();
+  state_history.clear();
+  StateInfo initial_state;
+  initial_state.piece_square_scores = piece_square_scores;
+  initial_state.pawn_hash = pawn_hash;
+  initial_state.castling_rights = compute_castling_rights();
+  initial_state.en_passant_square =
+      capturable_en_passant_square(en_passant_square);
+  initial_state.halfmove_clock = halfmove_clock;
+  initial_state.hash = compute_zobrist_hash(initial_state.castling_rights,
+                                            initial_state.en_passant_square);
+  state_history.push_back(initial_state);
 }
 
 void BoardState::is_end_game_check()
@@ -537,60 +567,56 @@ void BoardState::is_end_game_check()
   }
 }
 
-void BoardState::update_pieces_list()
+void BoardState::update_piece_square_scores()
 {
-  piece_list.clear();
+  piece_square_scores.fill(0);
   for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
   {
     for (int y_rank = Y_MIN; y_rank <= Y_MAX; ++y_rank)
     {
       Piece *piece = chess_board[x_file][y_rank];
-      if (piece->piece_type != PieceType::EMPTY)
+      if (piece->piece_type == PieceType::EMPTY)
+      {
+        continue;
+      }
+      for (int phase = 0; phase < NUM_OF_GAME_PHASES; ++phase)
       {
-        piece_list.push_back(piece);
+        piece_square_scores[phase] +=
+            piece_square_tables::PIECE_SQUARE_TABLES
+                [phase][static_cast<uint8_t>(piece->piece_color)]
+                [static_cast<uint8_t>(piece->piece_type)]
+                [(y_rank * BOARD_WIDTH) + x_file];
       }
     }
   }
 }
 
-// PRIVATE FUNCTIONS
-
-void BoardState::clear_pointers()
+void BoardState::update_pawn_hash()
 {
-  for (int x_file = X_MIN; x_file <= Y_MAX; ++x_file)
+  pawn_hash = 0;
+  for (int y_rank = Y_MIN; y_rank <= Y_MAX; ++y_rank)
   {
-    for (int y_rank = Y_MIN; y_rank <= Y_MAX; ++y_rank)
+    for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
     {
-      if (chess_board[x_file][y_rank] != nullptr &&
-          chess_board[x_file][y_rank] != &empty_piece)
+      Piece *piece = chess_board[x_file][y_rank];
+      if (piece->piece_type == PieceType::PAWN)
       {
-        delete chess_board[x_file][y_rank];
-        chess_board[x_file][y_rank] = nullptr;
+        pawn_hash ^= zobrist::KEYS.pieces[(y_rank * BOARD_WIDTH) + x_file]
+                                         [static_cast<int>(PieceType::PAWN)]
+                                         [static_cast<int>(piece->piece_color)];
       }
     }
   }
 }
 
-void BoardState::initialize_zobrist_keys()
+void BoardState::update_bitboards()
 {
-  std::mt19937_64 rng(0); // Use a fixed seed for reproducibility
-  std::uniform_int_distribution<uint64_t> dist;
-
-  for (int square = 0; square < NUM_OF_SQUARES; ++square)
+  for (auto &color_piece_bitboards : piece_bitboards)
   {
-    for (int piece = 0; piece < NUM_OF_PIECE_TYPES; ++piece)
-    {
-      zobrist_keys[square][piece][0] = dist(rng); // White piece
-      zobrist_keys[square][piece][1] = dist(rng); // Black piece
-    }
+    color_piece_bitboards.fill(0);
   }
-  zobrist_side_to_move = dist(rng);
-}
-
-auto BoardState::compute_zobrist_hash() const -> uint64_t
-{
-  uint64_t hash = 0;
-
+  color_bitboards.fill(0);
+  occupied = 0;
   for (int y_rank = Y_MIN; y_rank <= Y_MAX; ++y_rank)
   {
     for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
@@ -598,20 +624,110 @@ auto BoardState::compute_zobrist_hash() const -> uint64_t
       Piece *piece = chess_board[x_file][y_rank];
       if (piece->piece_type != PieceType::EMPTY)
       {
-        int piece_index = static_cast<int>(piece->piece_type);
-        int color_index = (piece->piece_color == PieceColor::WHITE) ? 0 : 1;
-        hash ^= zobrist_keys[(y_rank * BOARD_WIDTH) + x_file][piece_index]
-                            [color_index];
+        toggle_piece_bit(piece->piece_color, piece->piece_type,
+                         (y_rank * BOARD_WIDTH) + x_file);
       }
     }
   }
+}
 
-  if (color_to_move == PieceColor::BLACK)
+void BoardState::update_attack_tables()
+{
+  for (int square = 0; square < NUM_OF_SQUARES; ++square)
   {
-    hash ^= zobrist_side_to_move;
+    square_attacks[square] = compute_square_attacks(square);
   }
+  update_color_attacks();
+}
 
-  return hash;
+void BoardState::set_attack_tables_enabled(bool enabled)
+{
+  attack_tables_enabled = enabled;
+  if (attack_tables_enabled)
+  {
+    update_attack_tables();
+  }
+}
+
+auto BoardState::attack_tables_are_enabled() const -> bool
+{
+  return attack_tables_enabled;
+}
+
+void BoardState::set_nnue_network(const nnue::Network *network)
+{
+  nnue_network = network;
+  refresh_nnue_accumulators();
+}
+
+void BoardState::refresh_nnue_accumulators()
+{
+  nnue_accumulators.clear();
+  if (nnue_network == nullptr)
+  {
+    return;
+  }
+
+  nnue_accumulators.reserve(MAX_SEARCH_DEPTH);
+  nnue::Accumulator &accumulator = nnue_accumulators.emplace_back();
+  refresh_nnue_accumulator(accumulator, PieceColor::WHITE);
+  refresh_nnue_accumulator(accumulator, PieceColor::BLACK);
+}
+
+// PRIVATE FUNCTIONS
+
+void BoardState::copy_position(const BoardState &other)
+{
+  color_to_move = other.color_to_move;
+  queens_on_board = other.queens_on_board;
+  number_of_main_pieces_left = other.number_of_main_pieces_left;
+  white_king_x_file = other.white_king_x_file;
+  white_king_y_rank = other.white_king_y_rank;
+  black_king_x_file = other.black_king_x_file;
+  black_king_y_rank = other.black_king_y_rank;
+  white_has_castled = other.white_has_castled;
+  black_has_castled = other.black_has_castled;
+  is_end_game = other.is_end_game;
+  piece_square_scores = other.piece_square_scores;
+  pawn_hash = other.pawn_hash;
+  piece_bitboards = other.piece_bitboards;
+  color_bitboards = other.color_bitboards;
+  occupied = other.occupied;
+  nnue_network = other.nnue_network;
+  attack_tables_enabled = other.attack_tables_enabled;
+  if (attack_tables_enabled)
+  {
+    square_attacks = other.square_attacks;
+    color_attacks = other.color_attacks;
+  }
+
+  // Only the placed pieces are copied, then the board is pointed at the
+  // copies.
+  std::copy_n(other.piece_pool.begin(), other.piece_pool_size,
+              piece_pool.begin());
+  piece_pool_size = other.piece_pool_size;
+  for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
+  {
+    for (int y_rank = Y_MIN; y_rank <= Y_MAX; ++y_rank)
+    {
+      chess_board[x_file][y_rank] =
+          translate_piece(other, other.chess_board[x_file][y_rank]);
+    }
+  }
+}
+
+auto BoardState::translate_piece(const BoardState &other, const Piece *piece)
+    -> Piece *
+{
+  if (piece == nullptr)
+  {
+    return nullptr;
+  }
+  if (piece == &other.empty_piece)
+  {
+    return &empty_piece;
+  }
+  return &piece_pool[piece - other.piece_pool.data()];
 }
 
 void BoardState::manage_piece_counts_on_apply(Move &move)
@@ -631,21 +747,17 @@ void BoardState::manage_piece_counts_on_apply(Move &move)
     break;
   case PieceType::QUEEN:
     --queens_on_board;
-    is_end_game_check();
     break;
   default:
     --number_of_main_pieces_left;
-    is_end_game_check();
     break;
   }
 
-  if (move.promotion_piece_type == PieceType::EMPTY)
-  {
-    return;
-  }
-
   switch (move.promotion_piece_type)
   {
+  case PieceType::EMPTY:
+    break;
+
   case PieceType::QUEEN:
     ++queens_on_board;
     break;
@@ -654,6 +766,10 @@ void BoardState::manage_piece_counts_on_apply(Move &move)
     ++number_of_main_pieces_left;
     break;
   }
+
+  // The game phase only depends on the piece counts, so undo_move restores
+  // it exactly.
+  is_end_game_check();
 }
 
 void BoardState::manage_piece_counts_on_undo(Move &move)
@@ -673,21 +789,17 @@ void BoardState::manage_piece_counts_on_undo(Move &move)
     break;
   case PieceType::QUEEN:
     ++queens_on_board;
-    is_end_game_check();
     break;
   default:
     ++number_of_main_pieces_left;
-    is_end_game_check();
     break;
   }
 
-  if (move.promotion_piece_type == PieceType::EMPTY)
-  {
-    return;
-  }
-
   switch (move.promotion_piece_type)
   {
+  case PieceType::EMPTY:
+    break;
+
   case PieceType::QUEEN:
     --queens_on_board;
     break;
@@ -696,5 +808,467 @@ void BoardState::manage_piece_counts_on_undo(Move &move)
     --number_of_main_pieces_left;
     break;
   }
+
+  // The game phase only depends on the piece counts, so undo_move restores
+  // it exactly.
+  is_end_game_check();
+}
+void BoardState::manage_piece_square_scores(const Move &move, int direction)
+{
+  const auto color_index =
+      static_cast<uint8_t>(move.moving_piece->piece_color);
+  const int from_square = (move.from_y * BOARD_WIDTH) + move.from_x;
+  const int to_square = (move.to_y * BOARD_WIDTH) + move.to_x;
+
+  // The moving piece is still a pawn on its from square when promoting.
+  const auto from_type_index = static_cast<uint8_t>(
+      (move.promotion_piece_type != PieceType::EMPTY)
+          ? PieceType::PAWN
+          : move.moving_piece->piece_type);
+  const auto to_type_index = static_cast<uint8_t>(
+      (move.promotion_piece_type != PieceType::EMPTY)
+          ? move.promotion_piece_type
+          : move.moving_piece->piece_type);
+
+  for (int phase = 0; phase < NUM_OF_GAME_PHASES; ++phase)
+  {
+    const auto &table = piece_square_tables::PIECE_SQUARE_TABLES[phase];
+    int delta = table[color_index][to_type_index][to_square] -
+                table[color_index][from_type_index][from_square];
+
+    if (move.captured_piece != nullptr)
+    {
+      // En passant captures a pawn beside the from square, not on the to
+      // square.
+      int captured_y_rank = move.capture_is_en_passant ? move.from_y : move.to_y;
+      delta -= table[static_cast<uint8_t>(move.captured_piece->piece_color)]
+                    [static_cast<uint8_t>(move.captured_piece->piece_type)]
+                    [(captured_y_rank * BOARD_WIDTH) + move.to_x];
+    }
+
+    int king_move_distance = move.to_x - move.from_x;
+    if (move.moving_piece->piece_type == PieceType::KING &&
+        (king_move_distance == 2 || king_move_distance == -2))
+    {
+      // Castling also moves the rook.
+      const auto &rook_table =
+          table[color_index][static_cast<uint8_t>(PieceType::ROOK)];
+      int rook_from_x = (king_move_distance == 2) ? XH_FILE : XA_FILE;
+      int rook_to_x = (king_move_distance == 2) ? XF_FILE : XD_FILE;
+      delta += rook_table[(move.to_y * BOARD_WIDTH) + rook_to_x] -
+               rook_table[(move.to_y * BOARD_WIDTH) + rook_from_x];
+    }
+
+    piece_square_scores[phase] += direction * delta;
+  }
+}
+
+void BoardState::manage_pawn_hash(const Move &move)
+{
+  const auto pawn_index = static_cast<int>(PieceType::PAWN);
+
+  // The moving piece is still a pawn on its from square when promoting.
+  if (move.moving_piece->piece_type == PieceType::PAWN ||
+      move.promotion_piece_type != PieceType::EMPTY)
+  {
+    const auto color_index = static_cast<int>(move.moving_piece->piece_color);
+    pawn_hash ^=
+        zobrist::KEYS.pieces[(move.from_y * BOARD_WIDTH) + move.from_x]
+                            [pawn_index][color_index];
+    if (move.promotion_piece_type == PieceType::EMPTY)
+    {
+      pawn_hash ^= zobrist::KEYS.pieces[(move.to_y * BOARD_WIDTH) + move.to_x]
+                                       [pawn_index][color_index];
+    }
+  }
+
+  if (move.captured_piece != nullptr &&
+      move.captured_piece->piece_type == PieceType::PAWN)
+  {
+    // En passant captures a pawn beside the from square, not on the to
+    // square.
+    int captured_y_rank = move.capture_is_en_passant ? move.from_y : move.to_y;
+    const auto captured_color_index =
+        static_cast<int>(move.captured_piece->piece_color);
+    pawn_hash ^=
+        zobrist::KEYS.pieces[(captured_y_rank * BOARD_WIDTH) + move.to_x]
+                            [pawn_index][captured_color_index];
+  }
+}
+
+void BoardState::push_nnue_accumulator(const Move &move)
+{
+  nnue_accumulators.push_back(nnue_accumulators.back());
+  nnue::Accumulator &accumulator = nnue_accumulators.back();
+
+  const PieceColor moving_color = move.moving_piece->piece_color;
+  const int from_square = (move.from_y * BOARD_WIDTH) + move.from_x;
+  const int to_square = (move.to_y * BOARD_WIDTH) + move.to_x;
+
+  // The moving piece is still a pawn on its from square when promoting.
+  const PieceType from_type = (move.promotion_piece_type != PieceType::EMPTY)
+                                  ? PieceType::PAWN
+                                  : move.moving_piece->piece_type;
+  const PieceType to_type = move.moving_piece->piece_type;
+  const bool king_moved = move.moving_piece->piece_type == PieceType::KING;
+
+  for (PieceColor perspective : {PieceColor::WHITE, PieceColor::BLACK})
+  {
+    if (king_moved && perspective == moving_color)
+    {
+      refresh_nnue_accumulator(accumulator, perspective);
+      continue;
+    }
+
+    const int perspective_king_square = king_square(perspective);
+    if (!king_moved)
+    {
+      nnue_network->remove_feature(
+          accumulator, perspective,
+          nnue::feature_index(perspective, perspective_king_square, from_type,
+                              moving_color, from_square));
+      nnue_network->add_feature(
+          accumulator, perspective,
+          nnue::feature_index(perspective, perspective_king_square, to_type,
+                              moving_color, to_square));
+    }
+    else
+    {
+      int king_move_distance = move.to_x - move.from_x;
+      if (king_move_distance == 2 || king_move_distance == -2)
+      {
+        // Castling also moves the rook.
+        int rook_from_x = (king_move_distance == 2) ? XH_FILE : XA_FILE;
+        int rook_to_x = (king_move_distance == 2) ? XF_FILE : XD_FILE;
+        nnue_network->remove_feature(
+            accumulator, perspective,
+            nnue::feature_index(perspective, perspective_king_square,
+                                PieceType::ROOK, moving_color,
+                                (move.to_y * BOARD_WIDTH) + rook_from_x));
+        nnue_network->add_feature(
+            accumulator, perspective,
+            nnue::feature_index(perspective, perspective_king_square,
+                                PieceType::ROOK, moving_color,
+                                (move.to_y * BOARD_WIDTH) + rook_to_x));
+      }
+    }
+
+    if (move.captured_piece != nullptr &&
+        move.captured_piece->piece_type != PieceType::KING)
+    {
+      // En passant captures a pawn beside the from square, not on the to
+      // square.
+      int captured_y_rank =
+          move.capture_is_en_passant ? move.from_y : move.to_y;
+      nnue_network->remove_feature(
+          accumulator, perspective,
+          nnue::feature_index(perspective, perspective_king_square,
+                              move.captured_piece->piece_type,
+                              move.captured_piece->piece_color,
+                              (captured_y_rank * BOARD_WIDTH) + move.to_x));
+    }
+  }
+}
+
+void BoardState::refresh_nnue_accumulator(nnue::Accumulator &accumulator,
+                                          PieceColor perspective) const
+{
+  const int perspective_king_square = king_square(perspective);
+  std::vector<int> active_features;
+  active_features.reserve(std::popcount(occupied));
+  for (int y_rank = Y_MIN; y_rank <= Y_MAX; ++y_rank)
+  {
+    for (int x_file = X_MIN; x_file <= X_MAX; ++x_file)
+    {
+      Piece *piece = chess_board[x_file][y_rank];
+      if (piece->piece_type == PieceType::EMPTY ||
+          piece->piece_type == PieceType::KING)
+      {
+        continue;
+      }
+      active_features.push_back(nnue::feature_index(
+          perspective, perspective_king_square, piece->piece_type,
+          piece->piece_color, (y_rank * BOARD_WIDTH) + x_file));
+    }
+  }
+  nnue_network->refresh_accumulator(accumulator, perspective, active_features);
+}
+
+auto BoardState::king_square(PieceColor color) const -> int
+{
+  if (color == PieceColor::WHITE)
+  {
+    return (white_king_y_rank * BOARD_WIDTH) + white_king_x_file;
+  }
+  return (black_king_y_rank * BOARD_WIDTH) + black_king_x_file;
+}
+
+void BoardState::manage_bitboards(const Move &move)
+{
+  const PieceColor moving_color = move.moving_piece->piece_color;
+
+  // The moving piece is still a pawn on its from square when promoting.
+  const bool is_promotion = move.promotion_piece_type != PieceType::EMPTY;
+  toggle_piece_bit(moving_color,
+                   is_promotion ? PieceType::PAWN
+                                : move.moving_piece->piece_type,
+                   (move.from_y * BOARD_WIDTH) + move.from_x);
+  toggle_piece_bit(moving_color,
+                   is_promotion ? move.promotion_piece_type
+                                : move.moving_piece->piece_type,
+                   (move.to_y * BOARD_WIDTH) + move.to_x);
+
+  if (move.captured_piece != nullptr)
+  {
+    // En passant captures a pawn beside the from square, not on the to
+    // square.
+    int captured_y_rank = move.capture_is_en_passant ? move.from_y : move.to_y;
+    toggle_piece_bit(move.captured_piece->piece_color,
+                     move.captured_piece->piece_type,
+                     (captured_y_rank * BOARD_WIDTH) + move.to_x);
+  }
+
+  int king_move_distance = move.to_x - move.from_x;
+  if (move.moving_piece->piece_type == PieceType::KING &&
+      (king_move_distance == 2 || king_move_distance == -2))
+  {
+    // Castling also moves the rook.
+    int rook_from_x = (king_move_distance == 2) ? XH_FILE : XA_FILE;
+    int rook_to_x = (king_move_distance == 2) ? XF_FILE : XD_FILE;
+    toggle_piece_bit(moving_color, PieceType::ROOK,
+                     (move.to_y * BOARD_WIDTH) + rook_from_x);
+    toggle_piece_bit(moving_color, PieceType::ROOK,
+                     (move.to_y * BOARD_WIDTH) + rook_to_x);
+  }
+}
+
+void BoardState::toggle_piece_bit(PieceColor piece_color,
+                                  PieceType piece_type,
+                                  int square)
+{
+  const bitboard::bitboard_type square_bit = bitboard::bitboard_type{1}
+                                             << square;
+  const auto color_index = static_cast<uint8_t>(piece_color);
+  piece_bitboards[color_index][static_cast<uint8_t>(piece_type)] ^= square_bit;
+  color_bitboards[color_index] ^= square_bit;
+  occupied ^= square_bit;
+}
+
+void BoardState::manage_attack_tables(const Move &move,
+                                      bitboard::bitboard_type previous_occupied)
+{
+  // Squares that changed occupancy, plus the to square, which changes piece
+  // without changing occupancy on captures.
+  const bitboard::bitboard_type changed_squares =
+      (previous_occupied ^ occupied) |
+      bitboard::square_bit(move.to_x, move.to_y);
+
+  // A slider's attacks only change if its nearest changed square on a ray
+  // changed occupancy, and it sees that square from its own square.
+  const auto bishop_index = static_cast<uint8_t>(PieceType::BISHOP);
+  const auto rook_index = static_cast<uint8_t>(PieceType::ROOK);
+  const auto queen_index = static_cast<uint8_t>(PieceType::QUEEN);
+  bitboard::bitboard_type diagonal_sliders = 0;
+  bitboard::bitboard_type straight_sliders = 0;
+  for (const auto &color_piece_bitboards : piece_bitboards)
+  {
+    diagonal_sliders |= color_piece_bitboards[bishop_index] |
+                        color_piece_bitboards[queen_index];
+    straight_sliders |= color_piece_bitboards[rook_index] |
+                        color_piece_bitboards[queen_index];
+  }
+
+  bitboard::bitboard_type squares_to_update = changed_squares;
+  for (bitboard::bitboard_type remaining_squares = changed_squares;
+       remaining_squares != 0; remaining_squares &= remaining_squares - 1)
+  {
+    int square = std::countr_zero(remaining_squares);
+    squares_to_update |=
+        (bitboard::bishop_attacks(square, occupied) & diagonal_sliders) |
+        (bitboard::rook_attacks(square, occupied) & straight_sliders);
+  }
+
+  for (bitboard::bitboard_type remaining_squares = squares_to_update;
+       remaining_squares != 0; remaining_squares &= remaining_squares - 1)
+  {
+    int square = std::countr_zero(remaining_squares);
+    square_attacks[square] = compute_square_attacks(square);
+  }
+  update_color_attacks();
+}
+
+auto BoardState::compute_square_attacks(int square) const
+    -> bitboard::bitboard_type
+{
+  const Piece *piece =
+      chess_board[square % BOARD_WIDTH][square / BOARD_WIDTH];
+  switch (piece->piece_type)
+  {
+  case PieceType::PAWN:
+    return bitboard::PAWN_ATTACKS[static_cast<uint8_t>(piece->piece_color)]
+                                 [square];
+  case PieceType::KNIGHT:
+    return bitboard::KNIGHT_ATTACKS[square];
+  case PieceType::BISHOP:
+    return bitboard::bishop_attacks(square, occupied);
+  case PieceType::ROOK:
+    return bitboard::rook_attacks(square, occupied);
+  case PieceType::QUEEN:
+    return bitboard::bishop_attacks(square, occupied) |
+           bitboard::rook_attacks(square, occupied);
+  case PieceType::KING:
+    return bitboard::KING_ATTACKS[square];
+  default:
+    // Empty square.
+    return 0;
+  }
+}
+
+void BoardState::update_color_attacks()
+{
+  for (int color_index = 0; color_index < NUM_OF_COLORS; ++color_index)
+  {
+    bitboard::bitboard_type attacks = 0;
+    for (bitboard::bitboard_type remaining_pieces =
+             color_bitboards[color_index];
+         remaining_pieces != 0; remaining_pieces &= remaining_pieces - 1)
+    {
+      attacks |= square_attacks[std::countr_zero(remaining_pieces)];
+    }
+    color_attacks[color_index] = attacks;
+  }
+}
+
+void BoardState::push_state(const Move &move)
+{
+  const StateInfo &previous_state = state_history.back();
+  StateInfo state;
+  state.move = move;
+  state.piece_square_scores = piece_square_scores;
+  state.pawn_hash = pawn_hash;
+  state.castling_rights =
+      previous_state.castling_rights &
+      ~(castling_rights_lost((move.from_y * BOARD_WIDTH) + move.from_x) |
+        castling_rights_lost((move.to_y * BOARD_WIDTH) + move.to_x));
+
+  if (move.pawn_moved_two_squares)
+  {
+    // The square the pawn passed over.
+    state.en_passant_square = capturable_en_passant_square(
+        (((move.from_y + move.to_y) / 2) * BOARD_WIDTH) + move.to_x);
+  }
+
+  // The moving piece is already promoted, so check the promotion type too.
+  bool move_is_irreversible =
+      move.captured_piece != nullptr ||
+      move.moving_piece->piece_type == PieceType::PAWN ||
+      move.promotion_piece_type != PieceType::EMPTY;
+  state.halfmove_clock =
+      move_is_irreversible ? 0 : previous_state.halfmove_clock + 1;
+  state.hash =
+      compute_zobrist_hash(state.castling_rights, state.en_passant_square);
+
+  state_history.push_back(state);
+}
+
+auto BoardState::count_current_state_occurrences() const -> int
+{
+  const StateInfo &current_state = state_history.back();
+  int oldest_ply = std::max(0, game_ply() - current_state.halfmove_clock);
+
+  int occurrences = 1;
+  for (int ply = game_ply() - 1; ply >= oldest_ply; --ply)
+  {
+    if (state_history[ply].hash == current_state.hash)
+    {
+      ++occurrences;
+    }
+  }
+  return occurrences;
+}
+
+auto BoardState::capturable_en_passant_square(int en_passant_square) const
+    -> int
+{
+  if (en_passant_square == NO_SQUARE)
+  {
+    return NO_SQUARE;
+  }
+
+  // Pawns that attack the square stand where an enemy pawn on the square
+  // would attack.
+  const auto color_index = static_cast<uint8_t>(color_to_move);
+  const auto enemy_color_index = static_cast<uint8_t>(
+      (color_to_move == PieceColor::WHITE) ? PieceColor::BLACK
+                                           : PieceColor::WHITE);
+  bitboard::bitboard_type attacking_pawns =
+      bitboard::PAWN_ATTACKS[enemy_color_index][en_passant_square] &
+      piece_bitboards[color_index][static_cast<uint8_t>(PieceType::PAWN)];
+  return (attacking_pawns != 0) ? en_passant_square : NO_SQUARE;
+}
+
+auto BoardState::compute_castling_rights() const -> int
+{
+  // A right is kept while neither the king nor the rook has moved.
+  auto piece_has_not_moved = [this](int x_file, int y_rank,
+                                    PieceType piece_type,
+                                    PieceColor piece_color) -> bool
+  {
+    const Piece *piece = chess_board[x_file][y_rank];
+    return piece != nullptr && piece->piece_type == piece_type &&
+           piece->piece_color == piece_color && !piece->piece_has_moved;
+  };
+
+  int castling_rights = NO_CASTLING_RIGHTS;
+  if (piece_has_not_moved(XE_FILE, Y1_RANK, PieceType::KING,
+                          PieceColor::WHITE))
+  {
+    if (piece_has_not_moved(XH_FILE, Y1_RANK, PieceType::ROOK,
+                            PieceColor::WHITE))
+    {
+      castling_rights |= WHITE_KING_SIDE_CASTLE;
+    }
+    if (piece_has_not_moved(XA_FILE, Y1_RANK, PieceType::ROOK,
+                            PieceColor::WHITE))
+    {
+      castling_rights |= WHITE_QUEEN_SIDE_CASTLE;
+    }
+  }
+  if (piece_has_not_moved(XE_FILE, Y8_RANK, PieceType::KING,
+                          PieceColor::BLACK))
+  {
+    if (piece_has_not_moved(XH_FILE, Y8_RANK, PieceType::ROOK,
+                            PieceColor::BLACK))
+    {
+      castling_rights |= BLACK_KING_SIDE_CASTLE;
+    }
+    if (piece_has_not_moved(XA_FILE, Y8_RANK, PieceType::ROOK,
+                            PieceColor::BLACK))
+    {
+      castling_rights |= BLACK_QUEEN_SIDE_CASTLE;
+    }
+  }
+  return castling_rights;
+}
+
+auto BoardState::castling_rights_lost(int square) -> int
+{
+  switch (square)
+  {
+  case (Y1_RANK * BOARD_WIDTH) + XE_FILE:
+    return WHITE_KING_SIDE_CASTLE | WHITE_QUEEN_SIDE_CASTLE;
+  case (Y1_RANK * BOARD_WIDTH) + XH_FILE:
+    return WHITE_KING_SIDE_CASTLE;
+  case (Y1_RANK * BOARD_WIDTH) + XA_FILE:
+    return WHITE_QUEEN_SIDE_CASTLE;
+  case (Y8_RANK * BOARD_WIDTH) + XE_FILE:
+    return BLACK_KING_SIDE_CASTLE | BLACK_QUEEN_SIDE_CASTLE;
+  case (Y8_RANK * BOARD_WIDTH) + XH_FILE:
+    return BLACK_KING_SIDE_CASTLE;
+  case (Y8_RANK * BOARD_WIDTH) + XA_FILE:
+    return BLACK_QUEEN_SIDE_CASTLE;
+  default:
+    return NO_CASTLING_RIGHTS;
+  }
 }
 } // namespace engine::parts
@@ -1,12 +1,16 @@
 #ifndef BOARD_STATE_H
 #define BOARD_STATE_H
 
+#include "bitboard.h"
 #include "engine_constants.h"
 #include "move.h"
+#include "nnue.h"
 #include "piece.h"
+#include "piece_square_tables.h"
+#include "state_info.h"
+#include "zobrist.h"
 
 #include <array>
-#include <stack>
 #include <vector>
 
 namespace engine::parts
@@ -29,15 +33,14 @@ public:
   /// @brief 8 x 8 array to represent a chess board.
   chess_board_type chess_board;
 
-  /// @brief Stack to keep track of previous moves.
-  std::stack<Move> previous_move_stack;
+  /// @brief State of every position of the game, indexed by game ply. The
+  /// front is the initial position and the back is the current position.
+  /// @note Capacity is reserved up front, so apply_move does not allocate.
+  std::vector<StateInfo> state_history;
 
   /// @brief Represents which color is to move.
   PieceColor color_to_move = PieceColor::WHITE;
 
-  /// @brief A vector to store all pieces on the board.
-  std::vector<Piece *> piece_list;
-
   // EVALUATION HELPER PROPERTIES
 
   /// @brief Number of queens on the board.
@@ -67,6 +70,45 @@ public:
   /// @brief Game state.
   bool is_end_game = false;
 
+  /// @brief Running material and piece-square score of each game phase, from
+  /// white's perspective. Updated incrementally in apply_move and undo_move.
+  std::array<int, NUM_OF_GAME_PHASES> piece_square_scores{};
+
+  /// @brief Zobrist hash of the pawns only, used to index the pawn hash table.
+  /// Updated incrementally in apply_move and undo_move.
+  uint64_t pawn_hash = 0;
+
+  /// @brief Squares of the pieces of each color and type, captured pieces
+  /// excluded. These are the piece lists: walk them with
+  /// bitboard::pop_lowest_square. Updated incrementally in apply_move and
+  /// undo_move.
+  std::array<std::array<bitboard::bitboard_type, NUM_OF_PIECE_TYPES>,
+             NUM_OF_COLORS>
+      piece_bitboards{};
+
+  /// @brief All pieces of each color.
+  std::array<bitboard::bitboard_type, NUM_OF_COLORS> color_bitboards{};
+
+  /// @brief All pieces on the board.
+  bitboard::bitboard_type occupied = 0;
+
+  /// @brief Squares attacked by the piece on each square, 0 for empty squares.
+  /// Only up to date while the attack tables are enabled.
+  bitboard::square_table_type square_attacks{};
+
+  /// @brief Squares attacked by each color. Only up to date while the attack
+  /// tables are enabled.
+  std::array<bitboard::bitboard_type, NUM_OF_COLORS> color_attacks{};
+
+  /// @brief Network used to evaluate the board, or nullptr to use the
+  /// classical evaluation. Not owned by the board.
+  const nnue::Network *nnue_network = nullptr;
+
+  /// @brief Stack of network accumulators, one per applied move. The back is
+  /// the accumulator of the current position. Only maintained while
+  /// nnue_network is set.
+  std::vector<nnue::Accumulator> nnue_accumulators;
+
   // CONSTRUCTORS
 
   /**
@@ -82,19 +124,19 @@ public:
    *
    * @note Ensure the new board state is an exact copy of the other board state.
    *
-   * @note Keeping the piece_list order the same is important as it is used in
-   * move_generator functions. Order of moves generated must be the same for the
-   * same chess_board. This is because we rely on the move index to determine
-   * the same move for identical chess_boards.
+   * @note Move generation walks piece_bitboards, so the order of moves
+   * generated only depends on the chess_board. This is important because we
+   * rely on the move index to determine the same move for identical
+   * chess_boards.
    *
    * @param other The board state to copy.
    */
   BoardState(const BoardState &other);
 
   /**
-   * @brief Destructor - clears all pointers in the chess board.
+   * @brief Copy assignment is disabled, use copy_make to reuse a board state.
    */
-  ~BoardState();
+  auto operator=(const BoardState &other) -> BoardState & = delete;
 
   // FUNCTIONS
 
@@ -153,6 +195,41 @@ public:
    */
   void undo_null_move();
 
+  /**
+   * @brief Makes this board state a copy of the parent board state with the
+   * move applied.
+   *
+   * @details Copy-make alternative to apply_move and undo_move: the parent is
+   * left untouched, so there is nothing to undo. Only the state history since
+   * the last capture or pawn move and the current network accumulator are
+   * copied, which is all repetition detection and the incremental updates
+   * need.
+   *
+   * @note game_ply() of this board state counts from the first copied state,
+   * and undo_move is only valid for the move applied here.
+   *
+   * @param parent Board state to copy, must not be this board state.
+   * @param move Move generated for the parent board state.
+   */
+  void copy_make(const BoardState &parent, const Move &move);
+
+  /**
+   * @brief Places a new piece on a square of the chess board.
+   *
+   * @param x_file The x coordinate of the square (file).
+   * @param y_rank The y coordinate of the square (rank).
+   * @param piece_type Type of the piece.
+   * @param piece_color Color of the piece.
+   * @param piece_has_moved Whether the piece has moved.
+   *
+   * @return The placed piece.
+   */
+  auto place_piece(int x_file,
+                   int y_rank,
+                   PieceType piece_type,
+                   PieceColor piece_color,
+                   bool piece_has_moved = false) -> Piece *;
+
   /**
    * @brief Clears all pieces from the chess board.
    *
@@ -162,16 +239,28 @@ public:
   void clear_chess_board();
 
   /**
-   * @brief Gets the board state hash from visited_states_hash_stack.
+   * @brief Gets the board state hash from state_history.
    *
    * @details The current board state hash is calculated after a move is applied
-   * in apply_move and stored in visited_states_hash_stack and
-   * visited_states_hash_map.
+   * in apply_move and stored in state_history.
    *
    * @return The Zobrist hash of the current board state.
    */
   auto get_current_state_hash() -> uint64_t;
 
+  /**
+   * @brief Computes the Zobrist hash for the current board state.
+   *
+   * @param castling_rights Castling rights of the board state.
+   * @param en_passant_square Square a pawn can capture en passant on, or
+   * NO_SQUARE.
+   *
+   * @return The Zobrist hash value.
+   */
+  [[nodiscard]] auto compute_zobrist_hash(int castling_rights,
+                                          int en_passant_square) const
+      -> uint64_t;
+
   /**
    * @brief Checks if the current state has been repeated three times.
    *
@@ -191,23 +280,25 @@ public:
   auto current_state_has_been_visited() -> bool;
 
   /**
-   * @brief Adds the current state hash to the visited states map and stack.
+   * @brief Gets the number of moves applied since the initial position.
    *
-   * @details If the state has never been visited, it will be added to the map
-   * with a count of 1. If the state has been visited before, the count will be
-   * incremented by 1.
+   * @return The game ply of the current position.
    */
-  void add_current_state_to_visited_states();
+  [[nodiscard]] auto game_ply() const -> int;
 
   /**
-   * @brief Removes the current state hash from the visited states map and
-   * stack.
+   * @brief Restarts state_history with the current board as the initial
+   * position.
    *
-   * @details If the state has been visited before, the count will be
-   * decremented by 1. If the count is 0, the state will be removed from the
-   * map.
+   * @note Must be called after the board is set up, once the piece-square
+   * scores and the pawn hash are up to date.
+   *
+   * @param en_passant_square Square a pawn can capture en passant on, or
+   * NO_SQUARE.
+   * @param halfmove_clock Number of moves since the last capture or pawn move.
    */
-  void remove_current_state_from_visited_states();
+  void initialize_state_history(int en_passant_square = NO_SQUARE,
+                                int halfmove_clock = 0);
 
   /**
    * @brief Checks if the game is in an end game state and updates the
@@ -219,55 +310,163 @@ public:
   void is_end_game_check();
 
   /**
-   * @brief Updates the pieces list with all pieces on the board.
+   * @brief Recomputes piece_square_scores from all pieces on the board.
+   *
+   * @note Only needed after the board is set up; apply_move and undo_move
+   * keep the scores up to date afterwards.
+   */
+  void update_piece_square_scores();
+
+  /**
+   * @brief Recomputes pawn_hash from all pawns on the board.
+   *
+   * @note Only needed after the board is set up; apply_move and undo_move
+   * keep the pawn hash up to date afterwards.
    */
-  void update_pieces_list();
+  void update_pawn_hash();
+
+  /**
+   * @brief Recomputes the piece, color and occupancy bitboards from all pieces
+   * on the board.
+   *
+   * @note Only needed after the board is set up; apply_move and undo_move
+   * keep the bitboards up to date afterwards.
+   */
+  void update_bitboards();
+
+  /**
+   * @brief Recomputes square_attacks and color_attacks from the bitboards.
+   *
+   * @note Only needed after the board is set up; apply_move and undo_move
+   * keep the attack tables up to date afterwards while they are enabled.
+   */
+  void update_attack_tables();
+
+  /**
+   * @brief Enables or disables the incremental update of the attack tables.
+   *
+   * @details The tables make attack queries a single bit test, at the cost of
+   * updating them on every move. Enabling them recomputes them.
+   *
+   * @param enabled Flag to maintain the attack tables.
+   */
+  void set_attack_tables_enabled(bool enabled);
+
+  /**
+   * @brief Checks if the attack tables are enabled and up to date.
+   *
+   * @return True if the attack tables are enabled, false otherwise.
+   */
+  [[nodiscard]] auto attack_tables_are_enabled() const -> bool;
+
+  /**
+   * @brief Sets the network used to evaluate the board and refreshes the
+   * accumulators.
+   *
+   * @param network Loaded network, or nullptr to use the classical evaluation.
+   */
+  void set_nnue_network(const nnue::Network *network);
+
+  /**
+   * @brief Recomputes the current network accumulator from all pieces on the
+   * board.
+   *
+   * @note Only needed after the board is set up; apply_move and undo_move
+   * keep the accumulators up to date afterwards.
+   */
+  void refresh_nnue_accumulators();
 
 private:
   // PROPERTIES
 
-  /// @brief Zobrist keys.
-  std::array<
-      std::array<std::array<uint64_t, NUM_OF_COLORS>, NUM_OF_PIECE_TYPES>,
-      NUM_OF_SQUARES>
-      zobrist_keys;
-
-  /// @brief Zobrist key for the side to move.
-  uint64_t zobrist_side_to_move;
+  /// @brief Flag to update the attack tables in apply_move and undo_move.
+  bool attack_tables_enabled = false;
 
   /// @brief All empty squares point to this Empty Piece instance.
   Piece empty_piece =
       Piece(-1, -1, PieceType ::EMPTY, PieceColor::WHITE, false);
 
-  /// @brief Map to keep track of visited states. This is used to detect three
-  /// fold repetition. Game is drawn if the same state is repeated three times.
-  std::map<uint64_t, int> visisted_states_hash_map;
+  /// @brief Storage of every piece placed on the board, captured pieces
+  /// included. chess_board points into it, so board states copy without
+  /// allocating.
+  std::array<Piece, NUM_OF_SQUARES> piece_pool;
 
-  /// @brief Stack to keep track of the sequence of states that have been
-  /// visited (analogous to previous_move_stack, but for the hash of the state).
-  /// This is allows us to know which state in visisted_states_hash_map to
-  /// decrement or remove when undoing a move.
-  /// @note Top of the stack will always be the hash of the current state.
-  std::stack<uint64_t> visisted_states_hash_stack;
+  /// @brief Number of pieces placed in piece_pool.
+  int piece_pool_size = 0;
 
   // FUNCTIONS
 
   /**
-   * @brief Clears all pointers in the chess board.
+   * @brief Copies the pieces and the position properties of another board
+   * state, leaving state_history and nnue_accumulators untouched.
+   *
+   * @param other The board state to copy.
    */
-  void clear_pointers();
+  void copy_position(const BoardState &other);
 
   /**
-   * @brief Initializes the Zobrist keys.
+   * @brief Gets the piece of this board state at the same place in
+   * piece_pool as a piece of another board state.
+   *
+   * @param other Board state that owns the piece.
+   * @param piece Piece of the other board state, may be nullptr.
+   *
+   * @return The matching piece of this board state, or nullptr.
    */
-  void initialize_zobrist_keys();
+  auto translate_piece(const BoardState &other, const Piece *piece) -> Piece *;
 
   /**
-   * @brief Computes the Zobrist hash for the current board state.
+   * @brief Drops an en passant square no pawn of the side to move can capture
+   * on.
    *
-   * @return The Zobrist hash value.
+   * @details Positions only differ by en passant rights if the capture is
+   * possible, so the hash only includes capturable en passant squares.
+   *
+   * @param en_passant_square Square a pawn passed over, or NO_SQUARE.
+   *
+   * @return The en passant square if a pawn of the side to move attacks it,
+   * NO_SQUARE otherwise.
+   */
+  [[nodiscard]] auto capturable_en_passant_square(int en_passant_square) const
+      -> int;
+
+  /**
+   * @brief Pushes the state reached by a move onto state_history.
+   *
+   * @note Must be called after the move is applied to the board.
+   *
+   * @param move Move that was applied.
+   */
+  void push_state(const Move &move);
+
+  /**
+   * @brief Counts the positions in state_history equal to the current one,
+   * the current one included.
+   *
+   * @details Positions before the last capture or pawn move cannot repeat, so
+   * only the last halfmove_clock positions are compared.
+   *
+   * @return Number of occurrences of the current position.
+   */
+  [[nodiscard]] auto count_current_state_occurrences() const -> int;
+
+  /**
+   * @brief Computes the castling rights from the kings and rooks that have not
+   * moved.
+   *
+   * @return Castling rights, a combination of the castling right flags.
+   */
+  [[nodiscard]] auto compute_castling_rights() const -> int;
+
+  /**
+   * @brief Gets the castling rights lost when a piece leaves or lands on a
+   * square.
+   *
+   * @param square Square the piece leaves or lands on.
+   *
+   * @return Castling right flags lost.
    */
-  [[nodiscard]] auto compute_zobrist_hash() const -> uint64_t;
+  static auto castling_rights_lost(int square) -> int;
 
   /**
    * @brief Manages the piece counts after a move.
@@ -282,6 +481,105 @@ private:
    * @param move Manage piece counts for this move.
    */
   void manage_piece_counts_on_undo(Move &move);
+
+  /**
+   * @brief Updates piece_square_scores for the pieces the move displaces.
+   *
+   * @param move Move being applied or undone.
+   * @param direction POSITIVE_DIRECTION when applying the move,
+   * NEGATIVE_DIRECTION when undoing it.
+   */
+  void manage_piece_square_scores(const Move &move, int direction);
+
+  /**
+   * @brief Updates pawn_hash for the pawns the move displaces.
+   *
+   * @note XOR is its own inverse, so the same update applies and undoes the
+   * move.
+   *
+   * @param move Move being applied or undone.
+   */
+  void manage_pawn_hash(const Move &move);
+
+  /**
+   * @brief Updates the piece, color and occupancy bitboards for the pieces
+   * the move displaces.
+   *
+   * @note XOR is its own inverse, so the same update applies and undoes the
+   * move.
+   *
+   * @param move Move being applied or undone.
+   */
+  void manage_bitboards(const Move &move);
+
+  /**
+   * @brief Toggles a piece in the piece, color and occupancy bitboards.
+   *
+   * @param piece_color Color of the piece.
+   * @param piece_type Type of the piece.
+   * @param square Square of the piece.
+   */
+  void toggle_piece_bit(PieceColor piece_color,
+                        PieceType piece_type,
+                        int square);
+
+  /**
+   * @brief Updates the attack tables after a move is applied or undone.
+   *
+   * @details Only the pieces on the squares the move changed and the sliders
+   * whose rays reach a square whose occupancy changed are recomputed.
+   *
+   * @note Must be called after the board and the bitboards are updated.
+   *
+   * @param move Move that was applied or undone.
+   * @param previous_occupied Occupancy before the move was applied or undone.
+   */
+  void manage_attack_tables(const Move &move,
+                            bitboard::bitboard_type previous_occupied);
+
+  /**
+   * @brief Computes the squares attacked by the piece on a square.
+   *
+   * @param square Square of the piece.
+   *
+   * @return Attacked squares, 0 if the square is empty.
+   */
+  [[nodiscard]] auto compute_square_attacks(int square) const
+      -> bitboard::bitboard_type;
+
+  /**
+   * @brief Recomputes color_attacks from square_attacks.
+   */
+  void update_color_attacks();
+
+  /**
+   * @brief Pushes the accumulator of the position after the move, updating
+   * only the features the move changes.
+   *
+   * @note Must be called after the move is made on the board. A side whose
+   * king moved has all its features changed, so its view is refreshed instead.
+   *
+   * @param move Move that was applied.
+   */
+  void push_nnue_accumulator(const Move &move);
+
+  /**
+   * @brief Computes one side's view of the board from scratch.
+   *
+   * @param accumulator Accumulator to refresh.
+   * @param perspective Color of the viewing side.
+   */
+  void refresh_nnue_accumulator(nnue::Accumulator &accumulator,
+                                PieceColor perspective) const;
+
+  /**
+   * @brief Gets the square of a side's king.
+   *
+   * @param color Color of the king.
+   *
+   * @return Square index of the king.
+   */
+  [[nodiscard]] auto king_square(PieceColor color) const -> int;
 };
 } // namespace engine::parts
 
@@ -244,7 +244,9 @@ auto ChessEngine::update_search_engine_parameters(const std::string &user_input)
   if (search_engine.engine_is_pondering &&
       (user_input == "update-depth" || user_input == "update-timelimit" ||
        user_input == "update-window" || user_input == "update-info" ||
-       user_input == "update-pondering"))
+       user_input == "update-pondering" || user_input == "update-threads" ||
+       user_input == "update-nodes" || user_input == "update-deterministic" ||
+       user_input == "update-perf-counters"))
   {
     search_engine.stop_engine_pondering();
   }
@@ -294,6 +296,32 @@ auto ChessEngine::update_search_engine_parameters(const std::string &user_input)
     char allow_pondering_char = get_valid_char_input(user_message, "yn");
     allow_pondering = allow_pondering_char == 'y';
   }
+  else if (user_input == "update-threads")
+  {
+    user_message = "Enter Number of Search Threads";
+    int thread_count = get_valid_int_input(
+        user_message, 1, parts::SearchEngine::MAX_SEARCH_THREADS);
+    search_engine.set_search_thread_count(thread_count);
+  }
+  else if (user_input == "update-nodes")
+  {
+    user_message = "Enter Node Limit for Each Move (0 = No Limit)";
+    int search_nodes =
+        get_valid_int_input(user_message, 0, parts::MAX_SEARCH_NODES);
+    search_engine.max_search_nodes = search_nodes;
+  }
+  else if (user_input == "update-deterministic")
+  {
+    user_message = "Search Deterministically (One Thread, No Time Limit)?";
+    char deterministic_char = get_valid_char_input(user_message, "yn");
+    search_engine.deterministic_search = deterministic_char == 'y';
+  }
+  else if (user_input == "update-perf-counters")
+  {
+    user_message = "Sample Hardware Performance Counters per Search Phase?";
+    char perf_counters_char = get_valid_char_input(user_message, "yn");
+    search_engine.use_perf_counters = perf_counters_char == 'y';
+  }
   else
   {
     return false;
@@ -542,6 +570,19 @@ auto ChessEngine::handle_general_commands(const std::string &user_input) -> bool
     printf("Current State: %s\n", current_state_name.c_str());
     printf("%s", parts::HELP_MESSAGE.c_str());
   }
+  else if (user_input == "bench")
+  {
+    if (search_engine.engine_is_searching())
+    {
+      printf("Cannot run the bench while the engine is searching.\n");
+      return true;
+    }
+    if (search_engine.engine_is_pondering)
+    {
+      search_engine.stop_engine_pondering();
+    }
+    (void)search_engine.run_bench(parts::DEFAULT_BENCH_DEPTH);
+  }
   else
   {
     return false;
@@ -622,23 +663,13 @@ auto ChessEngine::get_valid_char_input(const std::string &user_message,
 
 void ChessEngine::print_applied_moves()
 {
-  std::vector<parts::Move> previous_moves_temp;
-
-  // Save all previous moves temporarily to print them.
-  while (!game_board_state.previous_move_stack.empty())
-  {
-    parts::Move move = game_board_state.previous_move_stack.top();
-    previous_moves_temp.push_back(move);
-    game_board_state.previous_move_stack.pop();
-  }
-
-  // Print first move to last move applied to the board.
-  for (int index = previous_moves_temp.size() - 1; index >= 0; --index)
+  // Print first move to last move applied to the board. The initial state has
+  // no move.
+  for (int ply = 1; ply <= game_board_state.game_ply(); ++ply)
   {
-    parts::Move move = previous_moves_temp[index];
-    printf("%s\n", parts::move_interface::move_to_string(move).c_str());
-    // Add move back to previous move stack.
-    game_board_state.previous_move_stack.push(move);
+    printf("%s\n", parts::move_interface::move_to_string(
+                       game_board_state.state_history[ply].move)
+                       .c_str());
   }
 }
 
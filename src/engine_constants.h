@@ -39,10 +39,40 @@ const int Y_MAX = 7;
 const int X_MIN = 0;
 const int X_MAX = 7;
 
+// Marks a missing square, such as no en passant target.
+const int NO_SQUARE = -1;
+
+// CASTLING RIGHTS
+const int NO_CASTLING_RIGHTS = 0;
+const int WHITE_KING_SIDE_CASTLE = 1;
+const int WHITE_QUEEN_SIDE_CASTLE = 2;
+const int BLACK_KING_SIDE_CASTLE = 4;
+const int BLACK_QUEEN_SIDE_CASTLE = 8;
+const int NUM_OF_CASTLING_FLAGS = 4;
+const int NUM_OF_CASTLING_RIGHTS = 16;
+
 // BOARD DIRECTIONS
 const int POSITIVE_DIRECTION = 1;
 const int NEGATIVE_DIRECTION = -1;
 
+// COLOR DEPENDENT CONSTANTS
+template <PieceColor piece_color>
+constexpr PieceColor OPPOSITE_COLOR =
+    (piece_color == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
+template <PieceColor piece_color>
+constexpr int PAWN_DIRECTION = (piece_color == PieceColor::WHITE)
+                                   ? POSITIVE_DIRECTION
+                                   : NEGATIVE_DIRECTION;
+template <PieceColor piece_color>
+constexpr int BACK_RANK =
+    (piece_color == PieceColor::WHITE) ? Y1_RANK : Y8_RANK;
+template <PieceColor piece_color>
+constexpr int PROMOTION_RANK =
+    (piece_color == PieceColor::WHITE) ? Y8_RANK : Y1_RANK;
+template <PieceColor piece_color>
+constexpr int EN_PASSANT_RANK =
+    (piece_color == PieceColor::WHITE) ? Y5_RANK : Y4_RANK;
+
 // USER INPUT REGEX MATCH INDEXES
 const int FROM_POSITION_INDEX = 1;
 const int TO_POSITION_INDEX = 2;
@@ -67,11 +97,15 @@ const int KING_VALUE = 20000;
 
 // SEARCH ENGINE CONSTANTS
 const int MAX_SEARCH_DEPTH = 100;
+// Room for a long game plus the deepest search line, quiescence included.
+const int STATE_HISTORY_RESERVE_SIZE = 1024;
 const int DEFAULT_SEARCH_TIME_MS = 10000;
 const int MAX_SEARCH_TIME_MS = 600000;
 const int MAX_PONDER_SEARCH_TIME_MS = 20000;
 const int INF = std::numeric_limits<int>::max() - 1000;
 const int INF_MINUS_1000 = INF - 1000;
+// Static evals never come close to INF, so -INF marks a missing static eval.
+const int NO_STATIC_EVAL = -INF;
 const int MIN_ROOT_MOVE_PRUNING_DEPTH = 8;
 const int ROOT_MOVE_PRUNING_INTERVAL = 2;
 const int MIN_SEARCH_THREADS = 12;
@@ -83,6 +117,33 @@ const int PROB_CUT_REDUCTION = 3;
 const int MIN_EARLY_STOP_DEPTH = 10;
 const int EARLY_STOP_MARGIN_VALUE = PAWN_VALUE * 2;
 const int MIN_EARLY_STOP_ITERATIONS = 3;
+const int CACHE_LINE_SIZE = 64;
+const int LAZY_EVAL_MARGIN = PAWN_VALUE * 5;
+const int DEFAULT_DETERMINISTIC_SEARCH_NODES = 1000000;
+const int MAX_SEARCH_NODES = 1000000000;
+const int SEARCH_STATS_MAX_PLY = 64;
+
+// Default search mode, set by the COPY_MAKE build option.
+#ifdef COPY_MAKE
+const bool COPY_MAKE_SEARCH = true;
+#else
+const bool COPY_MAKE_SEARCH = false;
+#endif
+
+// Search statistics collection, set by the SEARCH_STATS build option.
+#ifdef SEARCH_STATS
+const bool SEARCH_STATS_ENABLED = true;
+#else
+const bool SEARCH_STATS_ENABLED = false;
+#endif
+
+// Search phase markers of the hardware counters, set by the PERF_COUNTERS
+// build option.
+#ifdef PERF_COUNTERS
+const bool PERF_COUNTERS_ENABLED = true;
+#else
+const bool PERF_COUNTERS_ENABLED = false;
+#endif
 
 // For getting MVV_LVA_VALUES.
 const std::array<int, 6> PIECE_VALUES = {PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE,
@@ -132,11 +193,80 @@ const int INITIAL_QUEENS_COUNT = 2;
 const int END_GAME_CONDITION_TWO_QUEENS = 2;
 const int END_GAME_CONDITION_ONE_QUEEN = 5;
 const int END_GAME_CONDITION_NO_QUEENS = 8;
+const int MIDDLE_GAME_PHASE = 0;
+const int END_GAME_PHASE = 1;
+const int NUM_OF_GAME_PHASES = 2;
+
+// PAWN HASH TABLE CONSTANTS
+// Must be a power of two, entries are indexed by masking the pawn hash.
+const int PAWN_HASH_TABLE_SIZE = 16384;
+
+// EVAL CACHE CONSTANTS
+// Must be a power of two, entries are indexed by masking the hash.
+const int EVAL_CACHE_SIZE = 1048576;
+// The upper half of the hash verifies an entry, the lower half holds the eval.
+const uint64_t EVAL_CACHE_KEY_MASK = 0xFFFFFFFF00000000;
+
+// PERFT CONSTANTS
+const int DEFAULT_PERFT_DEPTH = 5;
+// The lower bits of an entry's data hold the depth, the upper bits the count.
+const int PERFT_DEPTH_BITS = 8;
+const uint64_t PERFT_DEPTH_MASK = 0xFF;
+
+// BENCH CONSTANTS
+const int DEFAULT_BENCH_DEPTH = 6;
+const int DEFAULT_MICROBENCH_TIME_MS = 500;
+const int MICROBENCH_TT_SIZE = 1048576;
+const int MICROBENCH_TT_OPERATIONS = 4000000;
+// Positions from testing/chess_board_fen_configs. Changing them changes the
+// bench node count.
+const std::array<std::string, 16> BENCH_POSITIONS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "rnbqk2r/pppp1pbp/3p1np1/8/8/2N1PN2/PPP2PPP/R1BQKB1R w KQkq - 0 1",
+    "r2qkb1r/n4ppp/2p2n2/8/Q3p1P1/2p4P/PP2PP2/R1B1KBNR w - - 0 1",
+    "8/8/4p3/4Pp1p/5P1P/4b2K/8/5k2 b - - 0 1",
+    "8/8/1b2p3/5p1p/3P1P1P/4PK2/8/1k6 b - - 0 1",
+    "r2k3r/1pp2p1p/5p2/p1b1nb2/2P5/2N2N2/PP4PP/R3KB1R w KQ - 0 1",
+    "1KR3R1/PPP2P2/4B3/2B1P2P/1N1Q4/np1p1p2/pb1k2pp/r3qbnr w - - 0 1",
+    "r2q1rk1/pppbnppB/2n1p3/4P3/2pP4/P1P2N2/5PPP/R1BQK2R b KQ - 0 1",
+    "rn1qkb1r/p2p1ppp/bpp1pn2/1N6/8/1P2PQ2/P1PP1PPP/R1B1KBNR w KQkq - 0 1",
+    "3r1b1r/1kpq2pp/3p1p1n/QP2p3/2PP4/3BPN1P/5PP1/R4RK1 b - - 0 1",
+    "2B1r3/8/3p2k1/P2K1Rp1/5p1p/5P2/8/4r3 w - - 0 1",
+    "2rk3r/pp5p/8/5pb1/2bN2p1/1NP5/PPK2nPP/R3R3 b - - 0 1",
+    "4k1r1/2p1b1pp/5p2/1p1bN3/1q6/1P1P4/2P1QPPP/2B2RK1 w - - 0 1",
+    "R1Q5/5p1k/1r3p2/4pq1p/8/7P/2R3P1/3Q3K b - - 0 1",
+    "r1b1kbnr/1p1q1p2/p1n4p/4p1p1/P1BpP1P1/N2P1N1P/1P3P2/R1BQ1RK1 b kq - 0 1",
+    "4k3/4q3/5P2/5KP1/8/8/8/8 b - - 1 1"};
+
+// NNUE CONSTANTS
+// HalfKP features: own king square x (5 piece types x 2 colors x 64 squares).
+const int NNUE_PIECE_FEATURES = 5 * NUM_OF_COLORS * NUM_OF_SQUARES;
+const int NNUE_INPUT_DIMENSIONS = NUM_OF_SQUARES * NNUE_PIECE_FEATURES;
+const int NNUE_L1_DIMENSIONS = 256;
+const int NNUE_L2_DIMENSIONS = 32;
+const int NNUE_L3_DIMENSIONS = 32;
+const int NNUE_MAX_ACTIVATION = 127;
+const int NNUE_WEIGHT_SCALE_BITS = 6;
+const int NNUE_OUTPUT_SCALE = 16;
+const int NNUE_HEADER_SIZE = 64;
+const uint32_t NNUE_FILE_VERSION = 1;
+const std::string NNUE_FILE_MAGIC = "ELBYNNUE";
 
 // HISTORY HEURISTIC CONSTANTS
 const int DECAY_RATE_NUMERATOR = 9;
 const int DECAY_RATE_DENOMINATOR = 10;
 
+// STATIC EXCHANGE EVALUATION CONSTANTS
+// Every capture removes a piece, so an exchange has at most 32 captures.
+const int MAX_EXCHANGE_LENGTH = 32;
+
+// KILLER AND COUNTERMOVE CONSTANTS
+const int NUM_OF_KILLER_MOVES = 2;
+const int MAX_KILLER_MOVE_PLY = MAX_SEARCH_DEPTH;
+// A move never starts and ends on the same square, so key 0 is free to mean
+// "no move".
+const int NO_MOVE_KEY = 0;
+
 // MVV-LVA CONSTANTS
 // First index represents the victim piece, second index represents the attacker
 // piece.
@@ -156,38 +286,42 @@ const int CHECKSUM_PRIME_2 = 37;
 const int CHECKSUM_PRIME_3 = 41;
 const int CHECKSUM_PRIME_4 = 43;
 const int CHECKSUM_PRIME_5 = 47;
+const int CHECKSUM_PRIME_6 = 53;
 
 // ASPIRATION WINDOW CONSTANTS
 const std::array<int, 3> ASPIRATION_WINDOWS = {
     {PAWN_VALUE / 2, PAWN_VALUE * 2, INF}};
 
 // POSITION EVALUATION MAP FOR PIECES
-const std::array<int, 8> PAWN_POSITION_EVAL_MAP = {{0, 2, 4, 6, 6, 4, 2, 0}};
-const std::array<int, 8> KNIGHT_POSITION_EVAL_MAP = {{0, 1, 2, 3, 3, 2, 1, 0}};
+constexpr std::array<int, 8> PAWN_POSITION_EVAL_MAP = {
+    {0, 2, 4, 6, 6, 4, 2, 0}};
+constexpr std::array<int, 8> KNIGHT_POSITION_EVAL_MAP = {
+    {0, 1, 2, 3, 3, 2, 1, 0}};
 
-const std::array<int, 8> KING_POSITION_EVAL_MAP = {{5, 20, 0, 0, 0, 0, 20, 5}};
+constexpr std::array<int, 8> KING_POSITION_EVAL_MAP = {
+    {5, 20, 0, 0, 0, 0, 20, 5}};
 
 // DIRECTION MAPS FOR PIECES
-const std::array<std::array<int, 2>, 8> QUEEN_DIRECTIONS = {
+constexpr std::array<std::array<int, 2>, 8> QUEEN_DIRECTIONS = {
     {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
 
 const std::array<std::array<int, 2>, 4> BISHOP_DIRECTIONS = {
     {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
 
-const std::array<std::array<int, 2>, 8> KNIGHT_MOVES = {
+constexpr std::array<std::array<int, 2>, 8> KNIGHT_MOVES = {
     {{1, 2}, {1, -2}, {-1, 2}, {-1, -2}, {2, 1}, {2, -1}, {-2, 1}, {-2, -1}}};
 
 const std::array<std::array<int, 2>, 4> ROOK_DIRECTIONS = {
     {{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
 
-const std::array<std::array<int, 2>, 8> KING_MOVES = {{{-1, -1},
-                                                       {-1, 0},
-                                                       {-1, +1},
-                                                       {0, -1},
-                                                       {0, +1},
-                                                       {+1, -1},
-                                                       {+1, 0},
-                                                       {+1, +1}}};
+constexpr std::array<std::array<int, 2>, 8> KING_MOVES = {{{-1, -1},
+                                                           {-1, 0},
+                                                           {-1, +1},
+                                                           {0, -1},
+                                                           {0, +1},
+                                                           {+1, -1},
+                                                           {+1, 0},
+                                                           {+1, +1}}};
 
 // PIECE TYPE MAPPINGS
 const std::map<char, parts::PieceType> CHAR_TO_PIECE_TYPE = {
@@ -224,18 +358,21 @@ const char BLACK_PIECE_CHAR = 'b';
 // INTERFACE MESSAGES
 const std::string GAME_OVER_HELP_MESSAGE =
     "\n-- Game Over-- \n\nCommand Options :\n  - menu\n  - exit\n  - undo\n  - "
-    "reset\n  - play-engine\n  - play-player\n  - print-moves\n  - help\n\n "
-    "Update Engine Parameters:\n  - update-depth\n  - update-timelimit\n  - "
-    "update-window\n  - update-info\n  - update-pondering\n\nEnter one of the "
+    "reset\n  - play-engine\n  - play-player\n  - print-moves\n  - help\n  - "
+    "bench\n\n Update Engine Parameters:\n  - update-depth\n  - "
+    "update-timelimit\n  - update-window\n  - update-info\n  - "
+    "update-pondering\n  - update-threads\n  - update-nodes\n  - "
+    "update-deterministic\n  - update-perf-counters\n\nEnter one of the "
     "commands above: ";
 
 const std::string HELP_MESSAGE =
     "\nCommands:\n\n ALL States:\n  - menu\n  - exit\n  - play-engine\n  - "
-    "play-player\n  - help\n\n All Playing States:\n  - undo\n  - reset\n  - "
-    "redo\n\n Player's Turn\n  - print-moves\n  - enter a move\n  - Update "
-    "Engine Parameters:\n    ~ update-depth\n    ~ update-timelimit\n    ~ "
-    "update-window\n    ~ update-info\n    ~ update-pondering\n\n "
-    "Engine's turn:\n  - stop-search\n\n";
+    "play-player\n  - help\n  - bench\n\n All Playing States:\n  - undo\n  - "
+    "reset\n  - redo\n\n Player's Turn\n  - print-moves\n  - enter a move\n  - "
+    "Update Engine Parameters:\n    ~ update-depth\n    ~ update-timelimit\n"
+    "    ~ update-window\n    ~ update-info\n    ~ update-pondering\n    ~ "
+    "update-threads\n    ~ update-nodes\n    ~ update-deterministic\n    ~ "
+    "update-perf-counters\n\n Engine's turn:\n  - stop-search\n\n";
 
 } // namespace engine::parts
 
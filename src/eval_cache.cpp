@@ -0,0 +1,44 @@
+#include "eval_cache.h"
+#include "engine_constants.h"
+
+namespace engine::parts
+{
+// CONSTRUCTORS
+
+EvalCache::EvalCache(size_t max_size) : entries(max_size) {}
+
+// PUBLIC FUNCTIONS
+
+auto EvalCache::probe(uint64_t hash, int &eval) const -> bool
+{
+  uint64_t entry =
+      entries[hash & (entries.size() - 1)].load(std::memory_order_relaxed);
+  if ((entry & EVAL_CACHE_KEY_MASK) != hash_key(hash))
+  {
+    return false;
+  }
+  eval = static_cast<int32_t>(static_cast<uint32_t>(entry));
+  return true;
+}
+
+void EvalCache::store(uint64_t hash, int eval)
+{
+  uint64_t entry = hash_key(hash) | static_cast<uint32_t>(eval);
+  entries[hash & (entries.size() - 1)].store(entry, std::memory_order_relaxed);
+}
+
+void EvalCache::clear()
+{
+  for (auto &entry : entries)
+  {
+    entry.store(0, std::memory_order_relaxed);
+  }
+}
+
+// PRIVATE FUNCTIONS
+
+auto EvalCache::hash_key(uint64_t hash) -> uint64_t
+{
+  return hash & EVAL_CACHE_KEY_MASK;
+}
+} // namespace engine::parts
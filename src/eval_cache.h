@@ -0,0 +1,78 @@
+#ifndef EVAL_CACHE_H
+#define EVAL_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine::parts
+{
+/**
+ * @brief Class that caches static evaluations by board state hash.
+ *
+ * @details Shared by all search threads without locks. Each entry is a single
+ * 64 bit word: the upper 32 bits of the hash, used to verify the entry, and
+ * the 32 bit evaluation. The word is read and written atomically, so a probe
+ * never sees a hash from one store mixed with an evaluation from another.
+ * The lower bits of the hash select the entry.
+ */
+class EvalCache
+{
+public:
+  // CONSTRUCTORS
+
+  /**
+   * @brief Construct a new Eval Cache object.
+   *
+   * @param max_size Number of entries in the cache, must be a power of two.
+   */
+  EvalCache(size_t max_size);
+
+  // FUNCTIONS
+
+  /**
+   * @brief Retrieve the evaluation of a board state.
+   *
+   * @param hash Hash of the board state.
+   * @param eval Evaluation of the board state (output parameter).
+   *
+   * @return True if the entry was found, false otherwise.
+   */
+  auto probe(uint64_t hash, int &eval) const -> bool;
+
+  /**
+   * @brief Store the evaluation of a board state, replacing the entry in its
+   * slot.
+   *
+   * @param hash Hash of the board state.
+   * @param eval Evaluation of the board state.
+   */
+  void store(uint64_t hash, int eval);
+
+  /**
+   * @brief Clear the eval cache.
+   */
+  void clear();
+
+private:
+  // PROPERTIES
+
+  /// @brief Entries of the cache.
+  std::vector<std::atomic<uint64_t>> entries;
+
+  // FUNCTIONS
+
+  /**
+   * @brief Gets the verification bits of a hash, stored in the upper half of
+   * an entry.
+   *
+   * @param hash Hash of the board state.
+   *
+   * @return Upper 32 bits of the hash.
+   */
+  static auto hash_key(uint64_t hash) -> uint64_t;
+};
+} // namespace engine::parts
+
+#endif // EVAL_CACHE_H
@@ -13,11 +13,12 @@ auto setup_custom_board(BoardState &board_state,
   std::string board_configuration;
   std::string color_to_move_local;
   std::string castling_rights;
-  std::string en_passant_square;
+  std::string en_passant_target;
+  std::string halfmove_clock;
 
   std::smatch matches;
   std::regex board_config_pattern(
-      R"(^((?:[rnbqkpRNBQKP1-8]{1,8}\/){7}[rnbqkpRNBQKP1-8]{1,8}) ([wb]) (K?Q?k?q?|-) (-|[a-h][36]) \d+ \d+$)");
+      R"(^((?:[rnbqkpRNBQKP1-8]{1,8}\/){7}[rnbqkpRNBQKP1-8]{1,8}) ([wb]) (K?Q?k?q?|-) (-|[a-h][36]) (\d+) \d+$)");
 
   if (std::regex_match(fen_configuration, matches, board_config_pattern))
   {
@@ -25,7 +26,8 @@ auto setup_custom_board(BoardState &board_state,
     board_configuration = matches[1].str();
     color_to_move_local = matches[2].str(); // Capture color to move
     castling_rights = matches[3].str();
-    en_passant_square = matches[4].str();
+    en_passant_target = matches[4].str();
+    halfmove_clock = matches[5].str();
   }
   else
   {
@@ -40,7 +42,9 @@ auto setup_custom_board(BoardState &board_state,
   {
     return false;
   }
-  if (!validate_en_passant_target(board_state, en_passant_square))
+  int en_passant_square = NO_SQUARE;
+  if (!validate_en_passant_target(board_state, en_passant_target,
+                                  en_passant_square))
   {
     return false;
   }
@@ -49,8 +53,9 @@ auto setup_custom_board(BoardState &board_state,
       (color_to_move_local[0] == parts::WHITE_PIECE_CHAR) ? PieceColor::WHITE
                                                           : PieceColor::BLACK;
 
-  // Add the initial board state to the visited states hash map.
-  board_state.add_current_state_to_visited_states();
+  // Start the state history with the initial board state.
+  board_state.initialize_state_history(en_passant_square,
+                                       std::stoi(halfmove_clock));
 
   return true;
 }
@@ -100,7 +105,11 @@ auto initialize_board(BoardState &board_state,
     }
   }
   board_state.is_end_game_check();
-  board_state.update_pieces_list();
+  board_state.update_piece_square_scores();
+  board_state.update_pawn_hash();
+  board_state.update_bitboards();
+  board_state.update_attack_tables();
+  board_state.refresh_nnue_accumulators();
 
   return true;
 }
@@ -156,13 +165,12 @@ void create_pieces(BoardState &board_state,
     {
       has_moved = false;
     }
-    board_state.chess_board[x_file][y_rank] =
-        new Piece(x_file, y_rank, piece_type, piece_color, has_moved);
+    board_state.place_piece(x_file, y_rank, piece_type, piece_color,
+                            has_moved);
   }
   else
   {
-    board_state.chess_board[x_file][y_rank] =
-        new Piece(x_file, y_rank, piece_type, piece_color, true);
+    board_state.place_piece(x_file, y_rank, piece_type, piece_color, true);
   }
 }
 
@@ -302,7 +310,8 @@ auto validate_black_queen_side_castle(BoardState &board_state) -> bool
 }
 
 auto validate_en_passant_target(BoardState &board_state,
-                                const std::string &en_passant_target) -> bool
+                                const std::string &en_passant_target,
+                                int &en_passant_square) -> bool
 {
   if (en_passant_target == "-")
   {
@@ -334,15 +343,7 @@ auto validate_en_passant_target(BoardState &board_state,
     return false;
   }
 
-  // Determine the original rank of the pawn.
-  int original_rank =
-      (pawn_piece->piece_color == PieceColor::WHITE) ? Y2_RANK : Y7_RANK;
-
-  Move previous_pawn_move =
-      Move(pawn_x_file, original_rank, pawn_x_file, pawn_y_rank, pawn_piece,
-           true, true, pawn_x_file, pawn_y_rank);
-
-  board_state.previous_move_stack.push(previous_pawn_move);
+  en_passant_square = (en_passant_rank * BOARD_WIDTH) + pawn_x_file;
 
   return true;
 }
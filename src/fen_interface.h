@@ -149,6 +149,8 @@ static auto validate_black_queen_side_castle(BoardState &board_state) -> bool;
  *
  * @param board_state The board state to check.
  * @param en_passant_target The en passant target square string to validate.
+ * @param en_passant_square Set to the en passant target square, or NO_SQUARE
+ * if there is none.
  *
  * @note Chess board must already be setup with the custom board before this
  * is called.
@@ -158,7 +160,8 @@ static auto validate_black_queen_side_castle(BoardState &board_state) -> bool;
  */
 static auto
 validate_en_passant_target(BoardState &board_state,
-                           const std::string &en_passant_target) -> bool;
+                           const std::string &en_passant_target,
+                           int &en_passant_square) -> bool;
 
 } // namespace engine::parts::fen_interface
 
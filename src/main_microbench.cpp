@@ -0,0 +1,345 @@
+#include "attack_check.h"
+#include "fen_interface.h"
+#include "move_generator.h"
+#include "pawn_hash_table.h"
+#include "perf_counters.h"
+#include "perft.h"
+#include "position_evaluator.h"
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace engine::parts;
+
+/**
+ * @brief Sets up one board state for each position of the corpus: the bench
+ * positions followed by the perft reference positions.
+ *
+ * @return Board states of the corpus. A deque keeps them in place, since their
+ * moves point to their pieces.
+ */
+static auto load_corpus() -> std::deque<BoardState>
+{
+  std::vector<std::string> fens(BENCH_POSITIONS.begin(),
+                                BENCH_POSITIONS.end());
+  for (const auto &position : perft::REFERENCE_POSITIONS)
+  {
+    fens.push_back(position.fen);
+  }
+
+  std::deque<BoardState> corpus;
+  for (const std::string &fen : fens)
+  {
+    corpus.emplace_back();
+    if (!fen_interface::setup_custom_board(corpus.back(), fen))
+    {
+      printf("Invalid corpus FEN: %s\n", fen.c_str());
+      corpus.pop_back();
+    }
+  }
+  return corpus;
+}
+
+/**
+ * @brief Runs a kernel over the corpus until the minimum time has passed and
+ * prints the time per operation.
+ *
+ * @param name Name of the kernel.
+ * @param filter Only runs the kernel if its name contains the filter.
+ * @param min_time_ms Minimum time to run the kernel for.
+ * @param run_pass Runs the kernel once over the corpus and returns the number
+ * of operations.
+ */
+static void run_kernel(const std::string &name,
+                       const std::string &filter,
+                       int min_time_ms,
+                       const std::function<size_t()> &run_pass)
+{
+  if (name.find(filter) == std::string::npos)
+  {
+    return;
+  }
+
+  // Warm up the caches and the branch predictors.
+  (void)run_pass();
+
+  size_t operations = 0;
+  auto start_time = std::chrono::steady_clock::now();
+  auto elapsed_time = std::chrono::nanoseconds(0);
+  while (elapsed_time < std::chrono::milliseconds(min_time_ms))
+  {
+    operations += run_pass();
+    elapsed_time = std::chrono::steady_clock::now() - start_time;
+  }
+
+  double nanoseconds = static_cast<double>(elapsed_time.count());
+  printf("%-32s %10.1f ns/op %14zu ops\n", name.c_str(),
+         nanoseconds / static_cast<double>(std::max<size_t>(operations, 1)),
+         operations);
+}
+
+/**
+ * @brief Stores and retrieves random entries of one transposition table from
+ * several threads at once and prints the time per store and retrieve pair.
+ *
+ * @param filter Only runs the kernel if its name contains the filter.
+ * @param num_of_threads Number of threads sharing the table.
+ * @param checksum Checksum of the retrieved entries (output parameter).
+ */
+static void run_transposition_table_kernel(const std::string &filter,
+                                           int num_of_threads,
+                                           size_t &checksum)
+{
+  std::string name =
+      "tt_store_retrieve/" + std::to_string(num_of_threads) + "_threads";
+  if (name.find(filter) == std::string::npos)
+  {
+    return;
+  }
+
+  TranspositionTable transposition_table(MICROBENCH_TT_SIZE);
+  std::vector<size_t> thread_checksums(num_of_threads, 0);
+  std::vector<std::thread> threads;
+
+  auto start_time = std::chrono::steady_clock::now();
+  for (int thread_index = 0; thread_index < num_of_threads; ++thread_index)
+  {
+    threads.emplace_back(
+        [&transposition_table, &thread_checksums, thread_index]() {
+          // Xorshift keys, seeded per thread so threads write over each
+          // other's entries.
+          uint64_t hash = 0x9E3779B97F4A7C15ULL * (thread_index + 1);
+          size_t thread_checksum = 0;
+          for (int operation = 0; operation < MICROBENCH_TT_OPERATIONS;
+               ++operation)
+          {
+            hash ^= hash << 13;
+            hash ^= hash >> 7;
+            hash ^= hash << 17;
+            transposition_table.store(hash, operation % MAX_SEARCH_DEPTH,
+                                      operation, EXACT, operation % 64,
+                                      operation);
+
+            int search_depth = 0;
+            int eval_score = 0;
+            int flag = 0;
+            int best_move_index = 0;
+            int static_eval = 0;
+            if (transposition_table.retrieve(hash, search_depth, eval_score,
+                                             flag, best_move_index,
+                                             static_eval))
+            {
+              thread_checksum += eval_score;
+            }
+          }
+          thread_checksums[thread_index] = thread_checksum;
+        });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+  auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+  size_t operations =
+      static_cast<size_t>(MICROBENCH_TT_OPERATIONS) * num_of_threads;
+  for (size_t thread_checksum : thread_checksums)
+  {
+    checksum += thread_checksum;
+  }
+  // Wall time per pair across all threads, so perfect scaling divides it by
+  // the number of threads.
+  printf("%-32s %10.1f ns/op %14zu ops\n", name.c_str(),
+         static_cast<double>(elapsed_time.count()) /
+             static_cast<double>(operations),
+         operations);
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void print_usage()
+{
+  printf("Usage: chess_engine_microbench [options]\n"
+         "  --min-time <ms>    Minimum time per kernel (default: %d)\n"
+         "  --threads <count>  Threads sharing the transposition table "
+         "(default: all cores)\n"
+         "  --filter <text>    Only run kernels whose name contains text\n"
+         "  --perf-counters    Sample hardware counters while the kernels run "
+         "and print them\n",
+         DEFAULT_MICROBENCH_TIME_MS);
+}
+
+auto main(int argc, char **argv) -> int
+{
+  int min_time_ms = DEFAULT_MICROBENCH_TIME_MS;
+  int num_of_threads =
+      std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  std::string filter;
+  bool use_perf_counters = false;
+
+  for (int arg_index = 1; arg_index < argc; ++arg_index)
+  {
+    std::string arg = argv[arg_index];
+    bool has_value = arg_index + 1 < argc;
+    if (arg == "--min-time" && has_value)
+    {
+      min_time_ms = std::max(std::stoi(argv[++arg_index]), 1);
+    }
+    else if (arg == "--threads" && has_value)
+    {
+      num_of_threads = std::max(std::stoi(argv[++arg_index]), 1);
+    }
+    else if (arg == "--filter" && has_value)
+    {
+      filter = argv[++arg_index];
+    }
+    else if (arg == "--perf-counters")
+    {
+      use_perf_counters = true;
+    }
+    else
+    {
+      print_usage();
+      return 1;
+    }
+  }
+
+  std::deque<BoardState> corpus = load_corpus();
+  std::vector<std::vector<Move>> corpus_moves;
+  for (BoardState &board_state : corpus)
+  {
+    corpus_moves.push_back(
+        move_generator::calculate_possible_moves(board_state));
+  }
+  PawnHashTable pawn_hash_table;
+  printf("%zu positions\n", corpus.size());
+
+  // Every kernel adds its results to the checksum, so none of them can be
+  // optimized away.
+  size_t checksum = 0;
+
+  // Samples the main thread only, not the transposition table kernel's
+  // threads.
+  perf_counters::PhaseSampler phase_sampler;
+  bool perf_counters_started = use_perf_counters && phase_sampler.start();
+  if (use_perf_counters && !perf_counters_started)
+  {
+    printf("Hardware counters unavailable: %s\n",
+           phase_sampler.get_error().c_str());
+  }
+
+  run_kernel("movegen_all", filter, min_time_ms, [&]() {
+    size_t operations = 0;
+    for (BoardState &board_state : corpus)
+    {
+      checksum += move_generator::calculate_possible_moves(board_state).size();
+      ++operations;
+    }
+    return operations;
+  });
+
+  run_kernel("movegen_captures", filter, min_time_ms, [&]() {
+    size_t operations = 0;
+    for (BoardState &board_state : corpus)
+    {
+      checksum += move_generator::calculate_possible_moves(board_state, false,
+                                                           nullptr, true)
+                      .size();
+      ++operations;
+    }
+    return operations;
+  });
+
+  run_kernel("apply_undo_move", filter, min_time_ms, [&]() {
+    size_t operations = 0;
+    for (size_t index = 0; index < corpus.size(); ++index)
+    {
+      BoardState &board_state = corpus[index];
+      for (Move &move : corpus_moves[index])
+      {
+        board_state.apply_move(move);
+        checksum += board_state.get_current_state_hash();
+        board_state.undo_move();
+        ++operations;
+      }
+    }
+    return operations;
+  });
+
+  run_kernel("compute_zobrist_hash", filter, min_time_ms, [&]() {
+    size_t operations = 0;
+    for (BoardState &board_state : corpus)
+    {
+      const StateInfo &state = board_state.state_history.back();
+      checksum += board_state.compute_zobrist_hash(state.castling_rights,
+                                                   state.en_passant_square);
+      ++operations;
+    }
+    return operations;
+  });
+
+  run_kernel("king_is_checked", filter, min_time_ms, [&]() {
+    size_t operations = 0;
+    for (BoardState &board_state : corpus)
+    {
+      PieceColor color_to_move = board_state.color_to_move;
+      checksum += static_cast<size_t>(
+          attack_check::king_is_checked(board_state, color_to_move));
+      ++operations;
+    }
+    return operations;
+  });
+
+  run_kernel("evaluate_position", filter, min_time_ms, [&]() {
+    size_t operations = 0;
+    for (BoardState &board_state : corpus)
+    {
+      checksum += position_evaluator::evaluate_position(board_state);
+      ++operations;
+    }
+    return operations;
+  });
+
+  run_kernel("evaluate_position/pawn_hash", filter, min_time_ms, [&]() {
+    size_t operations = 0;
+    for (BoardState &board_state : corpus)
+    {
+      checksum +=
+          position_evaluator::evaluate_position(board_state, &pawn_hash_table);
+      ++operations;
+    }
+    return operations;
+  });
+
+  run_transposition_table_kernel(filter, 1, checksum);
+  if (num_of_threads > 1)
+  {
+    run_transposition_table_kernel(filter, num_of_threads, checksum);
+  }
+
+  if (use_perf_counters)
+  {
+    // The report reads the open events, so it is printed before stopping.
+    phase_sampler.print_report();
+    phase_sampler.stop();
+    // A failed start must say why, and a stopped sampler must have closed
+    // every event.
+    if ((!perf_counters_started && phase_sampler.get_error().empty()) ||
+        phase_sampler.is_running())
+    {
+      printf("Hardware counter check failed\n");
+      return 1;
+    }
+  }
+
+  printf("Checksum: %zu\n", checksum);
+  return 0;
+}
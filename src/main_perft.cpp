@@ -0,0 +1,218 @@
+#include "fen_interface.h"
+#include "perft.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace engine::parts;
+
+/**
+ * @brief Counts the leaf nodes of a position and prints the node count, time
+ * and nodes per second.
+ *
+ * @param fen Position in Forsyth-Edwards Notation.
+ * @param depth Depth to count to, at least 1.
+ * @param num_of_threads Number of threads to count with.
+ * @param hash_size_in_mb Size of the perft hash table, 0 to count without it.
+ * @param use_attack_tables Flag to maintain the attack tables while counting.
+ * @param use_copy_make Flag to count with copy-make instead of make/unmake.
+ * @param show_divide Print the node count of every root move.
+ * @param nodes Number of leaf nodes (output parameter).
+ *
+ * @return False if the FEN is invalid, true otherwise.
+ */
+static auto run_perft(const std::string &fen,
+                      int depth,
+                      int num_of_threads,
+                      size_t hash_size_in_mb,
+                      bool use_attack_tables,
+                      bool use_copy_make,
+                      bool show_divide,
+                      size_t &nodes) -> bool
+{
+  BoardState board_state;
+  if (!fen_interface::setup_custom_board(board_state, fen))
+  {
+    printf("Invalid FEN: %s\n", fen.c_str());
+    return false;
+  }
+  board_state.set_attack_tables_enabled(use_attack_tables);
+
+  std::unique_ptr<PerftHashTable> hash_table;
+  if (hash_size_in_mb > 0)
+  {
+    hash_table = std::make_unique<PerftHashTable>(hash_size_in_mb);
+  }
+
+  auto start_time = std::chrono::steady_clock::now();
+  auto move_nodes = perft::divide(board_state, depth, num_of_threads,
+                                  hash_table.get(), use_copy_make);
+  auto elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - start_time)
+                          .count();
+
+  nodes = 0;
+  for (const auto &[move, move_node_count] : move_nodes)
+  {
+    if (show_divide)
+    {
+      printf("%s: %zu\n", move.c_str(), move_node_count);
+    }
+    nodes += move_node_count;
+  }
+
+  printf("Nodes: %zu, Time: %lld ms, NPS: %lld\n", nodes,
+         static_cast<long long>(elapsed_time),
+         static_cast<long long>(nodes * 1000 / (elapsed_time + 1)));
+  return true;
+}
+
+/**
+ * @brief Counts the leaf nodes of a reference position and compares them with
+ * the known node count.
+ *
+ * @param position Reference position to count.
+ * @param num_of_threads Number of threads to count with.
+ * @param hash_size_in_mb Size of the perft hash table, 0 to count without it.
+ * @param use_attack_tables Flag to maintain the attack tables while counting.
+ * @param use_copy_make Flag to count with copy-make instead of make/unmake.
+ *
+ * @return True if the node count matches, false otherwise.
+ */
+static auto run_reference_position(const perft::ReferencePosition &position,
+                                   int num_of_threads,
+                                   size_t hash_size_in_mb,
+                                   bool use_attack_tables,
+                                   bool use_copy_make) -> bool
+{
+  printf("%s (depth %d): ", position.name.c_str(), position.depth);
+  size_t nodes = 0;
+  if (!run_perft(position.fen, position.depth, num_of_threads, hash_size_in_mb,
+                 use_attack_tables, use_copy_make, false, nodes))
+  {
+    return false;
+  }
+  if (nodes != position.nodes)
+  {
+    printf("FAILED: expected %zu nodes, counted %zu\n", position.nodes, nodes);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void print_usage()
+{
+  printf("Usage: chess_engine_perft [options]\n"
+         "  --fen <fen>        Position to count (default: start position)\n"
+         "  --depth <depth>    Depth to count to (default: %d)\n"
+         "  --divide           Print the node count of every root move\n"
+         "  --threads <count>  Number of threads (default: all cores)\n"
+         "  --hash <mb>        Size of the perft hash table (default: 0, off)\n"
+         "  --attack-tables    Maintain the attack tables while counting\n"
+         "  --copy-make        Count with copy-make instead of make/unmake\n"
+         "  --position <name>  Verify a reference position\n"
+         "  --suite            Verify every reference position\n",
+         DEFAULT_PERFT_DEPTH);
+  printf("Reference positions:");
+  for (const auto &position : perft::REFERENCE_POSITIONS)
+  {
+    printf(" %s", position.name.c_str());
+  }
+  printf("\n");
+}
+
+auto main(int argc, char **argv) -> int
+{
+  std::string fen = perft::REFERENCE_POSITIONS[0].fen;
+  int depth = DEFAULT_PERFT_DEPTH;
+  int num_of_threads =
+      std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  size_t hash_size_in_mb = 0;
+  bool use_attack_tables = false;
+  bool use_copy_make = false;
+  bool show_divide = false;
+  bool run_suite = false;
+  std::string position_name;
+
+  for (int arg_index = 1; arg_index < argc; ++arg_index)
+  {
+    std::string arg = argv[arg_index];
+    bool has_value = arg_index + 1 < argc;
+    if (arg == "--fen" && has_value)
+    {
+      fen = argv[++arg_index];
+    }
+    else if (arg == "--depth" && has_value)
+    {
+      depth = std::max(std::stoi(argv[++arg_index]), 1);
+    }
+    else if (arg == "--threads" && has_value)
+    {
+      num_of_threads = std::max(std::stoi(argv[++arg_index]), 1);
+    }
+    else if (arg == "--hash" && has_value)
+    {
+      hash_size_in_mb = std::stoul(argv[++arg_index]);
+    }
+    else if (arg == "--position" && has_value)
+    {
+      position_name = argv[++arg_index];
+    }
+    else if (arg == "--attack-tables")
+    {
+      use_attack_tables = true;
+    }
+    else if (arg == "--copy-make")
+    {
+      use_copy_make = true;
+    }
+    else if (arg == "--divide")
+    {
+      show_divide = true;
+    }
+    else if (arg == "--suite")
+    {
+      run_suite = true;
+    }
+    else
+    {
+      print_usage();
+      return 1;
+    }
+  }
+
+  if (run_suite || !position_name.empty())
+  {
+    bool all_passed = true;
+    bool found_position = run_suite;
+    for (const auto &position : perft::REFERENCE_POSITIONS)
+    {
+      if (run_suite || position.name == position_name)
+      {
+        found_position = true;
+        all_passed &=
+            run_reference_position(position, num_of_threads, hash_size_in_mb,
+                                   use_attack_tables, use_copy_make);
+      }
+    }
+    if (!found_position)
+    {
+      print_usage();
+      return 1;
+    }
+    return all_passed ? 0 : 1;
+  }
+
+  size_t nodes = 0;
+  return run_perft(fen, depth, num_of_threads, hash_size_in_mb,
+                   use_attack_tables, use_copy_make, show_divide, nodes)
+             ? 0
+             : 1;
+}
@@ -0,0 +1,173 @@
+#include "fen_interface.h"
+#include "search_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace engine::parts;
+
+/**
+ * @brief Results of searching every bench position with one thread count.
+ */
+struct ScalingResult
+{
+  /// @brief Number of search threads.
+  int thread_count = 0;
+
+  /// @brief Time to reach the bench depth in all positions, in milliseconds.
+  long long time_ms = 0;
+
+  /// @brief Nodes visited by all threads to reach the bench depth.
+  size_t nodes = 0;
+
+  /// @brief Best move found in each position.
+  std::vector<std::string> best_moves;
+};
+
+/**
+ * @brief Searches every bench position to a fixed depth with the given number
+ * of threads, starting each position from empty search tables.
+ *
+ * @param search_engine Search engine of the board state to set up.
+ * @param board_state Board state the search engine searches.
+ * @param depth Depth to search each position to.
+ * @param thread_count Number of search threads.
+ *
+ * @return Time, node count and best moves of the run.
+ */
+static auto run_scaling_step(SearchEngine &search_engine,
+                             BoardState &board_state,
+                             int depth,
+                             int thread_count) -> ScalingResult
+{
+  ScalingResult result;
+  result.thread_count = thread_count;
+  search_engine.set_search_thread_count(thread_count);
+
+  for (const std::string &fen : BENCH_POSITIONS)
+  {
+    board_state.reset_board();
+    fen_interface::setup_custom_board(board_state, fen);
+    search_engine.clear_search_tables();
+
+    size_t nodes = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    result.best_moves.push_back(search_engine.search_to_depth(depth, nodes));
+    result.time_ms += std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - start_time)
+                          .count();
+    result.nodes += nodes;
+  }
+  return result;
+}
+
+/**
+ * @brief Prints one row of the scaling table, compared with the single thread
+ * run.
+ *
+ * @param result Run to print.
+ * @param baseline Single thread run.
+ */
+static void print_scaling_row(const ScalingResult &result,
+                              const ScalingResult &baseline)
+{
+  long long nps = static_cast<long long>(result.nodes * 1000 /
+                                         (result.time_ms + 1));
+  long long baseline_nps = static_cast<long long>(baseline.nodes * 1000 /
+                                                  (baseline.time_ms + 1));
+
+  size_t agreeing_moves = 0;
+  for (size_t index = 0; index < result.best_moves.size(); ++index)
+  {
+    if (result.best_moves[index] == baseline.best_moves[index])
+    {
+      ++agreeing_moves;
+    }
+  }
+
+  printf("%7d %10lld %12zu %10lld %8.2f %8.2f %8.2f %8zu%%\n",
+         result.thread_count, result.time_ms, result.nodes, nps,
+         static_cast<double>(baseline.time_ms + 1) / (result.time_ms + 1),
+         static_cast<double>(result.nodes) / (baseline.nodes + 1),
+         static_cast<double>(nps) / (baseline_nps + 1),
+         agreeing_moves * PERCENTAGE / result.best_moves.size());
+}
+
+/**
+ * @brief Prints the command line usage.
+ */
+static void print_usage()
+{
+  printf("Usage: chess_engine_smp_bench [options]\n"
+         "  --threads <count>  Highest thread count (default: all cores, "
+         "max %d)\n"
+         "  --depth <depth>    Depth to search each position to (default: "
+         "%d)\n"
+         "Searches the bench positions with 1, 2, 4, 8, ... threads up to the\n"
+         "highest thread count and compares each run with the single thread "
+         "run.\n",
+         SearchEngine::MAX_SEARCH_THREADS, DEFAULT_BENCH_DEPTH);
+}
+
+auto main(int argc, char **argv) -> int
+{
+  int max_thread_count =
+      std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  int depth = DEFAULT_BENCH_DEPTH;
+
+  for (int arg_index = 1; arg_index < argc; ++arg_index)
+  {
+    std::string arg = argv[arg_index];
+    bool has_value = arg_index + 1 < argc;
+    if (arg == "--threads" && has_value)
+    {
+      max_thread_count = std::max(std::stoi(argv[++arg_index]), 1);
+    }
+    else if (arg == "--depth" && has_value)
+    {
+      depth = std::clamp(std::stoi(argv[++arg_index]), 1, MAX_SEARCH_DEPTH);
+    }
+    else
+    {
+      print_usage();
+      return 1;
+    }
+  }
+  max_thread_count =
+      std::min(max_thread_count, SearchEngine::MAX_SEARCH_THREADS);
+
+  BoardState board_state;
+  SearchEngine search_engine(board_state, true);
+  search_engine.show_performance = false;
+
+  std::vector<int> thread_counts;
+  for (int thread_count = 1; thread_count < max_thread_count;
+       thread_count *= 2)
+  {
+    thread_counts.push_back(thread_count);
+  }
+  thread_counts.push_back(max_thread_count);
+
+  printf("Depth %d, %zu positions\n", depth, BENCH_POSITIONS.size());
+  printf("%7s %10s %12s %10s %8s %8s %8s %9s\n", "Threads", "Time (ms)",
+         "Nodes", "NPS", "Speedup", "Nodes", "NPS", "Best Move");
+  printf("%7s %10s %12s %10s %8s %8s %8s %9s\n", "", "", "", "", "", "Ratio",
+         "Ratio", "Agreement");
+
+  ScalingResult baseline;
+  for (int thread_count : thread_counts)
+  {
+    ScalingResult result =
+        run_scaling_step(search_engine, board_state, depth, thread_count);
+    if (thread_count == 1)
+    {
+      baseline = result;
+    }
+    print_scaling_row(result, baseline);
+  }
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include "move_generator.h"
 #include "attack_check.h"
+#include "perf_counters.h"
 
 #include <algorithm>
 
@@ -12,6 +13,7 @@ auto calculate_possible_moves(BoardState &board_state,
                               history_table_type *history_table,
                               bool capture_only) -> std::vector<Move>
 {
+  perf_counters::ScopedPhase phase(perf_counters::SearchPhase::MOVE_GENERATION);
   std::vector<Move> possible_normal_moves;
   std::vector<Move> possible_capture_moves;
 
@@ -20,59 +22,15 @@ auto calculate_possible_moves(BoardState &board_state,
       POSSIBLE_MOVE_RESERVE_SIZE); // Adjust based on expected move count.
   possible_capture_moves.reserve(POSSIBLE_CAPTURE_MOVE_RESERVE_SIZE);
 
-  for (Piece *current_piece : board_state.piece_list)
+  if (board_state.color_to_move == PieceColor::WHITE)
   {
-    // Skip empty squares.
-    if (current_piece->x_file == -1 || current_piece->y_rank == -1 ||
-        current_piece->piece_color != board_state.color_to_move)
-    {
-      continue;
-    }
-
-    int x_file = current_piece->x_file;
-    int y_rank = current_piece->y_rank;
-
-    if (board_state.chess_board[x_file][y_rank] != current_piece)
-    {
-      printf("Piece pointer mismatch at (%d, %d)\n", x_file, y_rank);
-      continue;
-    }
-
-    switch (current_piece->piece_type)
-    {
-    case PieceType::PAWN:
-      generate_pawn_moves(board_state, x_file, y_rank, possible_normal_moves,
-                          possible_capture_moves, capture_only);
-      break;
-    case PieceType::ROOK:
-      generate_rook_moves(board_state, x_file, y_rank, possible_normal_moves,
-                          possible_capture_moves, capture_only);
-      break;
-    case PieceType::KNIGHT:
-      generate_knight_moves(board_state, x_file, y_rank, possible_normal_moves,
-                            possible_capture_moves, capture_only);
-      break;
-    case PieceType::BISHOP:
-      generate_bishop_moves(board_state, x_file, y_rank, possible_normal_moves,
-                            possible_capture_moves, capture_only);
-      break;
-    case PieceType::QUEEN:
-      generate_queen_moves(board_state, x_file, y_rank, possible_normal_moves,
-                           possible_capture_moves, capture_only);
-      break;
-    case PieceType::KING:
-      generate_king_moves(board_state, x_file, y_rank, possible_normal_moves,
-                          possible_capture_moves, capture_only);
-      if (!capture_only)
-      {
-        generate_castle_king_moves(board_state, x_file, y_rank,
-                                   possible_normal_moves);
-      }
-      break;
-    default:
-      // Empty square.
-      break;
-    }
+    generate_moves<PieceColor::WHITE>(board_state, possible_normal_moves,
+                                      possible_capture_moves, capture_only);
+  }
+  else
+  {
+    generate_moves<PieceColor::BLACK>(board_state, possible_normal_moves,
+                                      possible_capture_moves, capture_only);
   }
 
   // Assign list index to each move. This is used for identifying the best move.
@@ -113,6 +71,85 @@ auto calculate_possible_moves(BoardState &board_state,
 
 // STATIC FUNCTIONS
 
+template <PieceColor piece_color>
+void generate_moves(BoardState &board_state,
+                    std::vector<Move> &possible_normal_moves,
+                    std::vector<Move> &possible_capture_moves,
+                    bool capture_only)
+{
+  // Pieces are walked one type at a time, so each loop always calls the same
+  // generator.
+  const auto &own_pieces =
+      board_state.piece_bitboards[static_cast<uint8_t>(piece_color)];
+
+  for (bitboard::bitboard_type pawns =
+           own_pieces[static_cast<uint8_t>(PieceType::PAWN)];
+       pawns != 0;)
+  {
+    int square = bitboard::pop_lowest_square(pawns);
+    generate_pawn_moves<piece_color>(
+        board_state, square % BOARD_WIDTH, square / BOARD_WIDTH,
+        possible_normal_moves, possible_capture_moves, capture_only);
+  }
+
+  for (bitboard::bitboard_type knights =
+           own_pieces[static_cast<uint8_t>(PieceType::KNIGHT)];
+       knights != 0;)
+  {
+    int square = bitboard::pop_lowest_square(knights);
+    generate_knight_moves(board_state, square % BOARD_WIDTH,
+                          square / BOARD_WIDTH, possible_normal_moves,
+                          possible_capture_moves, capture_only);
+  }
+
+  for (bitboard::bitboard_type bishops =
+           own_pieces[static_cast<uint8_t>(PieceType::BISHOP)];
+       bishops != 0;)
+  {
+    int square = bitboard::pop_lowest_square(bishops);
+    generate_bishop_moves(board_state, square % BOARD_WIDTH,
+                          square / BOARD_WIDTH, possible_normal_moves,
+                          possible_capture_moves, capture_only);
+  }
+
+  for (bitboard::bitboard_type rooks =
+           own_pieces[static_cast<uint8_t>(PieceType::ROOK)];
+       rooks != 0;)
+  {
+    int square = bitboard::pop_lowest_square(rooks);
+    generate_rook_moves(board_state, square % BOARD_WIDTH,
+                        square / BOARD_WIDTH, possible_normal_moves,
+                        possible_capture_moves, capture_only);
+  }
+
+  for (bitboard::bitboard_type queens =
+           own_pieces[static_cast<uint8_t>(PieceType::QUEEN)];
+       queens != 0;)
+  {
+    int square = bitboard::pop_lowest_square(queens);
+    generate_queen_moves(board_state, square % BOARD_WIDTH,
+                         square / BOARD_WIDTH, possible_normal_moves,
+                         possible_capture_moves, capture_only);
+  }
+
+  for (bitboard::bitboard_type kings =
+           own_pieces[static_cast<uint8_t>(PieceType::KING)];
+       kings != 0;)
+  {
+    int square = bitboard::pop_lowest_square(kings);
+    int x_file = square % BOARD_WIDTH;
+    int y_rank = square / BOARD_WIDTH;
+    generate_king_moves(board_state, x_file, y_rank, possible_normal_moves,
+                        possible_capture_moves, capture_only);
+    if (!capture_only)
+    {
+      generate_castle_king_moves(board_state, x_file, y_rank,
+                                 possible_normal_moves);
+    }
+  }
+}
+
+template <PieceColor piece_color>
 void generate_pawn_moves(BoardState &board_state,
                          int x_file,
                          int y_rank,
@@ -125,47 +162,36 @@ void generate_pawn_moves(BoardState &board_state,
   bool first_move = !pawn_piece->piece_has_moved;
 
   // Create pawn moves.
-  int pawn_direction;
-  int promotion_rank;
-  if (pawn_piece->piece_color == PieceColor::WHITE)
-  {
-    pawn_direction = POSITIVE_DIRECTION;
-    promotion_rank = Y_MAX;
-  }
-  else
-  {
-    pawn_direction = NEGATIVE_DIRECTION;
-    promotion_rank = Y_MIN;
-  }
-
   if (!capture_only)
   {
-    generate_normal_pawn_moves(chess_board, x_file, y_rank,
-                               possible_normal_moves, pawn_piece,
-                               pawn_direction, first_move, promotion_rank);
+    generate_normal_pawn_moves<piece_color>(
+        chess_board, x_file, y_rank, possible_normal_moves, pawn_piece,
+        first_move);
   }
 
-  generate_pawn_capture_moves(chess_board, x_file, y_rank,
-                              possible_capture_moves, pawn_piece,
-                              pawn_direction, first_move, promotion_rank);
+  generate_pawn_capture_moves<piece_color>(chess_board, x_file, y_rank,
+                                           possible_capture_moves, pawn_piece,
+                                           first_move);
 
-  if (!board_state.previous_move_stack.empty())
+  int en_passant_square = board_state.state_history.back().en_passant_square;
+  if (en_passant_square != NO_SQUARE)
   {
-    generate_en_passant_pawn_capture_moves(
+    generate_en_passant_pawn_capture_moves<piece_color>(
         chess_board, x_file, y_rank, possible_capture_moves, pawn_piece,
-        pawn_direction, first_move, board_state.previous_move_stack.top());
+        first_move, en_passant_square);
   }
 }
 
+template <PieceColor piece_color>
 void generate_normal_pawn_moves(chess_board_type &chess_board,
                                 int x_file,
                                 int y_rank,
                                 std::vector<Move> &possible_normal_moves,
                                 Piece *pawn_piece,
-                                int pawn_direction,
-                                bool first_move,
-                                int promotion_rank)
+                                bool first_move)
 {
+  constexpr int pawn_direction = PAWN_DIRECTION<piece_color>;
+
   // One square move forward.
   // Check if the square in front of the pawn is empty.
   int new_y_rank = y_rank + pawn_direction;
@@ -174,7 +200,7 @@ void generate_normal_pawn_moves(chess_board_type &chess_board,
     if (chess_board[x_file][new_y_rank]->piece_type == PieceType::EMPTY)
     {
 
-      if (new_y_rank == promotion_rank)
+      if (new_y_rank == PROMOTION_RANK<piece_color>)
       {
         // Promotion moves.
         for (auto piece_type : {PieceType::QUEEN, PieceType::BISHOP,
@@ -206,28 +232,31 @@ void generate_normal_pawn_moves(chess_board_type &chess_board,
   }
 }
 
+template <PieceColor piece_color>
 void generate_pawn_capture_moves(chess_board_type &chess_board,
                                  int x_file,
                                  int y_rank,
                                  std::vector<Move> &possible_capture_moves,
                                  Piece *pawn_piece,
-                                 int pawn_direction,
-                                 bool first_move,
-                                 int promotion_rank)
+                                 bool first_move)
 {
+  int new_y_rank = y_rank + PAWN_DIRECTION<piece_color>;
+  if (new_y_rank < Y_MIN || new_y_rank > Y_MAX)
+  {
+    return;
+  }
+
   // Pawn can capture left and right.
   for (int capture_direction : {NEGATIVE_DIRECTION, POSITIVE_DIRECTION})
   {
     int new_x_file = x_file + capture_direction;
-    int new_y_rank = y_rank + pawn_direction;
-    if (new_x_file >= X_MIN && new_x_file <= X_MAX && new_y_rank >= Y_MIN &&
-        new_y_rank <= Y_MAX)
+    if (new_x_file >= X_MIN && new_x_file <= X_MAX)
     {
       Piece *captured_piece = chess_board[new_x_file][new_y_rank];
       if (captured_piece->piece_type != PieceType::EMPTY &&
-          captured_piece->piece_color != pawn_piece->piece_color)
+          captured_piece->piece_color == OPPOSITE_COLOR<piece_color>)
       {
-        if (y_rank + pawn_direction == promotion_rank)
+        if (new_y_rank == PROMOTION_RANK<piece_color>)
         {
           // Add promotion moves.
           for (auto piece_type : {PieceType::QUEEN, PieceType::BISHOP,
@@ -250,40 +279,40 @@ void generate_pawn_capture_moves(chess_board_type &chess_board,
   }
 }
 
+template <PieceColor piece_color>
 void generate_en_passant_pawn_capture_moves(
     chess_board_type &chess_board,
     int x_file,
     int y_rank,
     std::vector<Move> &possible_capture_moves,
     Piece *pawn_piece,
-    int pawn_direction,
     bool first_move,
-    Move &previous_move)
+    int en_passant_square)
 {
   // En-passant moves can only be made on the 5th rank for white and 4th rank
   // for black.
-  if ((y_rank == Y5_RANK && pawn_piece->piece_color == PieceColor::WHITE) ||
-      (y_rank == Y4_RANK && pawn_piece->piece_color == PieceColor::BLACK))
+  if (y_rank != EN_PASSANT_RANK<piece_color>)
+  {
+    return;
+  }
+
+  // Pawn can capture, en-passant, left and right.
+  int new_y_rank = y_rank + PAWN_DIRECTION<piece_color>;
+  for (int capture_direction : {NEGATIVE_DIRECTION, POSITIVE_DIRECTION})
   {
-    // Pawn can capture, en-passant, left and right.
-    for (int capture_direction : {NEGATIVE_DIRECTION, POSITIVE_DIRECTION})
+    int new_x_file = x_file + capture_direction;
+    if (new_x_file >= X_MIN && new_x_file <= X_MAX)
     {
-      int new_x_file = x_file + capture_direction;
-      int new_y_rank = y_rank + pawn_direction;
-      if (new_x_file >= X_MIN && new_x_file <= X_MAX)
+      Piece *captured_piece = chess_board[new_x_file][y_rank];
+      if (captured_piece->piece_type == PieceType::PAWN &&
+          en_passant_square == (new_y_rank * BOARD_WIDTH) + new_x_file &&
+          captured_piece->piece_color == OPPOSITE_COLOR<piece_color> &&
+          chess_board[new_x_file][new_y_rank]->piece_type == PieceType::EMPTY)
       {
-        Piece *captured_piece = chess_board[new_x_file][y_rank];
-        if (captured_piece->piece_type == PieceType::PAWN &&
-            previous_move.pawn_moved_two_squares_to_x == new_x_file &&
-            previous_move.pawn_moved_two_squares_to_y == y_rank &&
-            captured_piece->piece_color != pawn_piece->piece_color &&
-            chess_board[new_x_file][new_y_rank]->piece_type == PieceType::EMPTY)
-        {
 
-          possible_capture_moves.emplace_back(x_file, y_rank, new_x_file,
-                                              new_y_rank, pawn_piece,
-                                              captured_piece, first_move, true);
-        }
+        possible_capture_moves.emplace_back(x_file, y_rank, new_x_file,
+                                            new_y_rank, pawn_piece,
+                                            captured_piece, first_move, true);
       }
     }
   }
@@ -349,9 +378,11 @@ void generate_castle_king_moves(BoardState &board_state,
                                          king_piece, first_move, false);
     }
 
-    // Castle queen side.
+    // Castle queen side. The king does not pass the b-file, so it only has to
+    // be empty.
     potential_rook_piece = chess_board[X_MIN][y_rank];
-    if (can_castle(board_state, king_piece, y_rank, potential_rook_piece,
+    if (chess_board[XB_FILE][y_rank]->piece_type == PieceType::EMPTY &&
+        can_castle(board_state, king_piece, y_rank, potential_rook_piece,
                    {XC_FILE, XD_FILE}))
     {
       possible_normal_moves.emplace_back(x_file, y_rank, x_file - 2, y_rank,
@@ -366,8 +397,9 @@ auto can_castle(BoardState &board_state,
                 Piece *potential_rook_piece,
                 const std::vector<int> &castle_path) -> bool
 {
-  // Check if the piece is a rook and has not moved.
+  // Check if the piece is a rook of the king's color and has not moved.
   if (potential_rook_piece->piece_type != PieceType::ROOK ||
+      potential_rook_piece->piece_color != king_piece->piece_color ||
       potential_rook_piece->piece_has_moved)
   {
     return false;
@@ -35,12 +35,36 @@ auto calculate_possible_moves(BoardState &board_state,
                               history_table_type *history_table = nullptr,
                               bool capture_only = false) -> std::vector<Move>;
 
+/**
+ * @brief Generates the unsorted moves of every live piece of the side to
+ * move.
+ *
+ * @note Generated moves are pushed back into the
+ * possible_normal_moves/possible_capture_moves vectors.
+ *
+ * @tparam piece_color Color of the side to move.
+ *
+ * @param board_state Reference of the current board state.
+ * @param possible_normal_moves Reference to the list of possible non-capture
+ * moves.
+ * @param possible_capture_moves Reference to the list of possible capture
+ * moves.
+ * @param capture_only If true, only capture moves are generated.
+ */
+template <PieceColor piece_color>
+static void generate_moves(BoardState &board_state,
+                           std::vector<Move> &possible_normal_moves,
+                           std::vector<Move> &possible_capture_moves,
+                           bool capture_only);
+
 /**
  * @brief Generates all possible moves for a given pawn.
  *
  * @note Generated moves are pushed back into the
  * possible_normal_moves/possible_capture_moves vectors.
  *
+ * @tparam piece_color Color of the pawn.
+ *
  * @param board_state Reference of the current board state.
  * @param x_file The x-coordinate (file) of the pawn.
  * @param y_rank The y-coordinate (rank) of the pawn.
@@ -50,6 +74,7 @@ auto calculate_possible_moves(BoardState &board_state,
  * moves.
  * @param capture_only If true, only capture moves are generated.
  */
+template <PieceColor piece_color>
 static void generate_pawn_moves(BoardState &board_state,
                                 int x_file,
                                 int y_rank,
@@ -64,24 +89,24 @@ static void generate_pawn_moves(BoardState &board_state,
  * @note Generated moves are pushed back into the possible_normal_moves
  * vector.
  *
+ * @tparam piece_color Color of the pawn, fixes its direction and promotion
+ * rank.
+ *
  * @param chess_board Reference of the current chess board.
  * @param x_file The x-coordinate (file) of the pawn.
  * @param y_rank The y-coordinate (rank) of the pawn.
  * @param possible_normal_moves Reference to the list of possible non-capture
  * moves.
  * @param pawn_piece The pawn piece.
- * @param pawn_direction The direction of the pawn's movement.
  * @param first_move True if the pawn has not moved yet.
- * @param promotion_rank The rank at which the pawn is promoted.
  */
+template <PieceColor piece_color>
 static void generate_normal_pawn_moves(chess_board_type &chess_board,
                                        int x_file,
                                        int y_rank,
                                        std::vector<Move> &possible_normal_moves,
                                        Piece *pawn_piece,
-                                       int pawn_direction,
-                                       bool first_move,
-                                       int promotion_rank);
+                                       bool first_move);
 
 /**
  * @brief Generates normal pawn capture moves.
@@ -89,24 +114,25 @@ static void generate_normal_pawn_moves(chess_board_type &chess_board,
  * @note Generated moves are pushed back into the possible_capture_moves
  * vector.
  *
+ * @tparam piece_color Color of the pawn, fixes its direction and promotion
+ * rank.
+ *
  * @param chess_board Reference of the current chess board.
  * @param x_file The x-coordinate (file) of the pawn.
  * @param y_rank The y-coordinate (rank) of the pawn.
  * @param possible_capture_moves Reference to the list of possible capture
  * moves.
  * @param pawn_piece The pawn piece.
- * @param pawn_direction The direction of the pawn's movement.
- * @param promotion_rank The rank at which the pawn is promoted.
+ * @param first_move True if the pawn has not moved yet.
  */
+template <PieceColor piece_color>
 static void
 generate_pawn_capture_moves(chess_board_type &chess_board,
                             int x_file,
                             int y_rank,
                             std::vector<Move> &possible_capture_moves,
                             Piece *pawn_piece,
-                            int pawn_direction,
-                            bool first_move,
-                            int promotion_rank);
+                            bool first_move);
 
 /**
  * @brief Generates en passant pawn capture moves.
@@ -114,24 +140,27 @@ generate_pawn_capture_moves(chess_board_type &chess_board,
  * @note Generated moves are pushed back into the possible_capture_moves
  * vector.
  *
+ * @tparam piece_color Color of the pawn, fixes its direction and en passant
+ * rank.
+ *
  * @param chess_board Reference of the current chess board.
  * @param x_file The x-coordinate (file) of the pawn.
  * @param y_rank The y-coordinate (rank) of the pawn.
  * @param possible_capture_moves Reference to the list of possible capture
  * moves.
  * @param pawn_piece The pawn piece.
- * @param pawn_direction The direction of the pawn's movement.
- * @param previous_move The previous move applied on the board.
+ * @param first_move True if the pawn has not moved yet.
+ * @param en_passant_square Square a pawn can capture en passant on.
  */
+template <PieceColor piece_color>
 static void generate_en_passant_pawn_capture_moves(
     chess_board_type &chess_board,
     int x_file,
     int y_rank,
     std::vector<Move> &possible_capture_moves,
     Piece *pawn_piece,
-    int pawn_direction,
     bool first_move,
-    Move &previous_move);
+    int en_passant_square);
 
 /**
  * @brief Generates all possible moves for a given king.
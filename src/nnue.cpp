@@ -0,0 +1,408 @@
+#include "nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+namespace engine::parts::nnue
+{
+// CONSTRUCTORS
+
+Network::~Network() { unload(); }
+
+// PUBLIC FUNCTIONS
+
+auto Network::load(const std::string &file_path) -> bool
+{
+  unload();
+
+#ifndef _WIN32
+  int file_descriptor = open(file_path.c_str(), O_RDONLY);
+  if (file_descriptor < 0)
+  {
+    return false;
+  }
+
+  struct stat file_stat{};
+  if (fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size <= 0)
+  {
+    close(file_descriptor);
+    return false;
+  }
+
+  mapped_file_size = static_cast<size_t>(file_stat.st_size);
+  mapped_file = mmap(nullptr, mapped_file_size, PROT_READ, MAP_PRIVATE,
+                     file_descriptor, 0);
+  close(file_descriptor);
+  if (mapped_file == MAP_FAILED)
+  {
+    mapped_file = nullptr;
+    mapped_file_size = 0;
+    return false;
+  }
+
+  if (!set_weights(static_cast<const char *>(mapped_file), mapped_file_size))
+  {
+    unload();
+    return false;
+  }
+  return true;
+#else
+  std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+  if (!file)
+  {
+    return false;
+  }
+
+  file_buffer.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  if (!file.read(file_buffer.data(),
+                 static_cast<std::streamsize>(file_buffer.size())) ||
+      !set_weights(file_buffer.data(), file_buffer.size()))
+  {
+    unload();
+    return false;
+  }
+  return true;
+#endif
+}
+
+auto Network::is_loaded() const -> bool { return feature_weights != nullptr; }
+
+void Network::refresh_accumulator(Accumulator &accumulator,
+                                  PieceColor perspective,
+                                  const std::vector<int> &active_features) const
+{
+  int16_t *values =
+      accumulator.values[static_cast<uint8_t>(perspective)].data();
+  std::memcpy(values, feature_biases, sizeof(int16_t) * NNUE_L1_DIMENSIONS);
+  for (int feature : active_features)
+  {
+    add_row(values, feature_weights + (feature * NNUE_L1_DIMENSIONS));
+  }
+}
+
+void Network::add_feature(Accumulator &accumulator,
+                          PieceColor perspective,
+                          int feature) const
+{
+  add_row(accumulator.values[static_cast<uint8_t>(perspective)].data(),
+          feature_weights + (feature * NNUE_L1_DIMENSIONS));
+}
+
+void Network::remove_feature(Accumulator &accumulator,
+                             PieceColor perspective,
+                             int feature) const
+{
+  subtract_row(accumulator.values[static_cast<uint8_t>(perspective)].data(),
+               feature_weights + (feature * NNUE_L1_DIMENSIONS));
+}
+
+auto Network::evaluate(const Accumulator &accumulator,
+                       PieceColor color_to_move) const -> int
+{
+  alignas(CACHE_LINE_SIZE) std::array<uint8_t, 2 * NNUE_L1_DIMENSIONS>
+      l1_output;
+  alignas(CACHE_LINE_SIZE) std::array<uint8_t, NNUE_L2_DIMENSIONS> l2_output;
+  alignas(CACHE_LINE_SIZE) std::array<uint8_t, NNUE_L3_DIMENSIONS> l3_output;
+
+  // The side to move's view always comes first, so the network learns who is
+  // to move.
+  PieceColor other_color = (color_to_move == PieceColor::WHITE)
+                               ? PieceColor::BLACK
+                               : PieceColor::WHITE;
+  clip_accumulator(
+      accumulator.values[static_cast<uint8_t>(color_to_move)].data(),
+      l1_output.data());
+  clip_accumulator(accumulator.values[static_cast<uint8_t>(other_color)].data(),
+                   l1_output.data() + NNUE_L1_DIMENSIONS);
+
+  propagate_layer(l1_output.data(), 2 * NNUE_L1_DIMENSIONS, l2_biases,
+                  l2_weights, l2_output.data(), NNUE_L2_DIMENSIONS);
+  propagate_layer(l2_output.data(), NNUE_L2_DIMENSIONS, l3_biases, l3_weights,
+                  l3_output.data(), NNUE_L3_DIMENSIONS);
+
+  int32_t output = *output_bias + dot_product(l3_output.data(), output_weights,
+                                              NNUE_L3_DIMENSIONS);
+  return output / NNUE_OUTPUT_SCALE;
+}
+
+// PRIVATE FUNCTIONS
+
+void Network::unload()
+{
+#ifndef _WIN32
+  if (mapped_file != nullptr)
+  {
+    munmap(mapped_file, mapped_file_size);
+  }
+#endif
+  mapped_file = nullptr;
+  mapped_file_size = 0;
+  file_buffer.clear();
+  file_buffer.shrink_to_fit();
+
+  feature_biases = nullptr;
+  feature_weights = nullptr;
+  l2_biases = nullptr;
+  l2_weights = nullptr;
+  l3_biases = nullptr;
+  l3_weights = nullptr;
+  output_bias = nullptr;
+  output_weights = nullptr;
+}
+
+auto Network::set_weights(const char *data, size_t size) -> bool
+{
+  const size_t expected_size =
+      NNUE_HEADER_SIZE + (sizeof(int16_t) * NNUE_L1_DIMENSIONS) +
+      (sizeof(int16_t) * NNUE_INPUT_DIMENSIONS * NNUE_L1_DIMENSIONS) +
+      (sizeof(int32_t) * NNUE_L2_DIMENSIONS) +
+      (sizeof(int8_t) * NNUE_L2_DIMENSIONS * 2 * NNUE_L1_DIMENSIONS) +
+      (sizeof(int32_t) * NNUE_L3_DIMENSIONS) +
+      (sizeof(int8_t) * NNUE_L3_DIMENSIONS * NNUE_L2_DIMENSIONS) +
+      sizeof(int32_t) + (sizeof(int8_t) * NNUE_L3_DIMENSIONS);
+  if (size != expected_size ||
+      std::memcmp(data, NNUE_FILE_MAGIC.data(), NNUE_FILE_MAGIC.size()) != 0)
+  {
+    return false;
+  }
+
+  std::array<uint32_t, 5> header_fields{};
+  std::memcpy(header_fields.data(), data + NNUE_FILE_MAGIC.size(),
+              sizeof(header_fields));
+  if (header_fields !=
+      std::array<uint32_t, 5>{NNUE_FILE_VERSION, NNUE_INPUT_DIMENSIONS,
+                              NNUE_L1_DIMENSIONS, NNUE_L2_DIMENSIONS,
+                              NNUE_L3_DIMENSIONS})
+  {
+    return false;
+  }
+
+  // Every array starts at a multiple of its element size, so the weights can
+  // be read in place.
+  const char *position = data + NNUE_HEADER_SIZE;
+  auto take = [&position](size_t bytes)
+  {
+    const char *array_start = position;
+    position += bytes;
+    return array_start;
+  };
+
+  feature_biases = reinterpret_cast<const int16_t *>(
+      take(sizeof(int16_t) * NNUE_L1_DIMENSIONS));
+  feature_weights = reinterpret_cast<const int16_t *>(
+      take(sizeof(int16_t) * NNUE_INPUT_DIMENSIONS * NNUE_L1_DIMENSIONS));
+  l2_biases = reinterpret_cast<const int32_t *>(
+      take(sizeof(int32_t) * NNUE_L2_DIMENSIONS));
+  l2_weights = reinterpret_cast<const int8_t *>(
+      take(NNUE_L2_DIMENSIONS * 2 * NNUE_L1_DIMENSIONS));
+  l3_biases = reinterpret_cast<const int32_t *>(
+      take(sizeof(int32_t) * NNUE_L3_DIMENSIONS));
+  l3_weights = reinterpret_cast<const int8_t *>(
+      take(NNUE_L3_DIMENSIONS * NNUE_L2_DIMENSIONS));
+  output_bias = reinterpret_cast<const int32_t *>(take(sizeof(int32_t)));
+  output_weights = reinterpret_cast<const int8_t *>(take(NNUE_L3_DIMENSIONS));
+  return true;
+}
+
+void Network::propagate_layer(const uint8_t *input,
+                              int input_size,
+                              const int32_t *biases,
+                              const int8_t *weights,
+                              uint8_t *output,
+                              int output_size)
+{
+  for (int output_index = 0; output_index < output_size; ++output_index)
+  {
+    int32_t sum =
+        biases[output_index] +
+        dot_product(input, weights + (output_index * input_size), input_size);
+    output[output_index] = static_cast<uint8_t>(std::clamp(
+        sum >> NNUE_WEIGHT_SCALE_BITS, 0, NNUE_MAX_ACTIVATION));
+  }
+}
+
+// FUNCTIONS
+
+auto feature_index(PieceColor perspective,
+                   int king_square,
+                   PieceType piece_type,
+                   PieceColor piece_color,
+                   int square) -> int
+{
+  // Black sees the board flipped, so both sides learn the same patterns.
+  if (perspective == PieceColor::BLACK)
+  {
+    king_square ^= NUM_OF_SQUARES - BOARD_WIDTH;
+    square ^= NUM_OF_SQUARES - BOARD_WIDTH;
+  }
+  int piece_index = (static_cast<int>(piece_type) * NUM_OF_COLORS) +
+                    ((piece_color == perspective) ? 0 : 1);
+  return (king_square * NNUE_PIECE_FEATURES) + (piece_index * NUM_OF_SQUARES) +
+         square;
+}
+
+// PRIVATE FUNCTIONS
+
+void add_row(int16_t *accumulator, const int16_t *weights)
+{
+#if defined(__AVX2__)
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; index += 16)
+  {
+    auto *values = reinterpret_cast<__m256i *>(accumulator + index);
+    _mm256_storeu_si256(
+        values, _mm256_add_epi16(_mm256_loadu_si256(values),
+                                 _mm256_loadu_si256(
+                                     reinterpret_cast<const __m256i *>(
+                                         weights + index))));
+  }
+#elif defined(__SSE4_1__)
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; index += 8)
+  {
+    auto *values = reinterpret_cast<__m128i *>(accumulator + index);
+    _mm_storeu_si128(values,
+                     _mm_add_epi16(_mm_loadu_si128(values),
+                                   _mm_loadu_si128(
+                                       reinterpret_cast<const __m128i *>(
+                                           weights + index))));
+  }
+#else
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; ++index)
+  {
+    accumulator[index] =
+        static_cast<int16_t>(accumulator[index] + weights[index]);
+  }
+#endif
+}
+
+void subtract_row(int16_t *accumulator, const int16_t *weights)
+{
+#if defined(__AVX2__)
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; index += 16)
+  {
+    auto *values = reinterpret_cast<__m256i *>(accumulator + index);
+    _mm256_storeu_si256(
+        values, _mm256_sub_epi16(_mm256_loadu_si256(values),
+                                 _mm256_loadu_si256(
+                                     reinterpret_cast<const __m256i *>(
+                                         weights + index))));
+  }
+#elif defined(__SSE4_1__)
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; index += 8)
+  {
+    auto *values = reinterpret_cast<__m128i *>(accumulator + index);
+    _mm_storeu_si128(values,
+                     _mm_sub_epi16(_mm_loadu_si128(values),
+                                   _mm_loadu_si128(
+                                       reinterpret_cast<const __m128i *>(
+                                           weights + index))));
+  }
+#else
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; ++index)
+  {
+    accumulator[index] =
+        static_cast<int16_t>(accumulator[index] - weights[index]);
+  }
+#endif
+}
+
+void clip_accumulator(const int16_t *accumulator, uint8_t *output)
+{
+#if defined(__AVX2__)
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max_activation = _mm256_set1_epi16(NNUE_MAX_ACTIVATION);
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; index += 32)
+  {
+    __m256i low = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(accumulator + index));
+    __m256i high = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(accumulator + index + 16));
+    low = _mm256_min_epi16(_mm256_max_epi16(low, zero), max_activation);
+    high = _mm256_min_epi16(_mm256_max_epi16(high, zero), max_activation);
+
+    // Packing works within 128 bit lanes, so restore the order afterwards.
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high),
+                                              0b11011000);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + index), packed);
+  }
+#elif defined(__SSE4_1__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max_activation = _mm_set1_epi16(NNUE_MAX_ACTIVATION);
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; index += 16)
+  {
+    __m128i low =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(accumulator + index));
+    __m128i high = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(accumulator + index + 8));
+    low = _mm_min_epi16(_mm_max_epi16(low, zero), max_activation);
+    high = _mm_min_epi16(_mm_max_epi16(high, zero), max_activation);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output + index),
+                     _mm_packus_epi16(low, high));
+  }
+#else
+  for (int index = 0; index < NNUE_L1_DIMENSIONS; ++index)
+  {
+    output[index] = static_cast<uint8_t>(
+        std::clamp(static_cast<int>(accumulator[index]), 0,
+                   NNUE_MAX_ACTIVATION));
+  }
+#endif
+}
+
+auto dot_product(const uint8_t *input, const int8_t *weights, int size)
+    -> int32_t
+{
+#if defined(__AVX2__)
+  // Inputs are at most 127, so the pairwise byte products summed by maddubs
+  // never saturate 16 bits.
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum = _mm256_setzero_si256();
+  for (int index = 0; index < size; index += 32)
+  {
+    __m256i products = _mm256_maddubs_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + index)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + index)));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+  }
+  __m128i sum_128 = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                  _mm256_extracti128_si256(sum, 1));
+  sum_128 = _mm_hadd_epi32(sum_128, sum_128);
+  sum_128 = _mm_hadd_epi32(sum_128, sum_128);
+  return _mm_cvtsi128_si32(sum_128);
+#elif defined(__SSE4_1__)
+  const __m128i ones = _mm_set1_epi16(1);
+  __m128i sum = _mm_setzero_si128();
+  for (int index = 0; index < size; index += 16)
+  {
+    __m128i products = _mm_maddubs_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + index)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + index)));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+  }
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  return _mm_cvtsi128_si32(sum);
+#else
+  int32_t sum = 0;
+  for (int index = 0; index < size; ++index)
+  {
+    sum += static_cast<int32_t>(input[index]) * weights[index];
+  }
+  return sum;
+#endif
+}
+} // namespace engine::parts::nnue
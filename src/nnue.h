@@ -0,0 +1,263 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "engine_constants.h"
+#include "piece.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Namespace for the efficiently updatable neural network (NNUE)
+ * evaluator.
+ *
+ * @details The network is HalfKP style. Each side has its own view of the
+ * board: every non-king piece is a feature indexed by the side's king square,
+ * the piece type, whether the piece is its own or the enemy's, and the piece
+ * square, with the board flipped for black. The first layer sums the weights
+ * of the active features into a 256 wide accumulator per side, which
+ * BoardState updates incrementally as moves are made. The side to move's
+ * accumulator, followed by the other side's, is clipped to [0, 127] and fed
+ * through two 32 wide int8 layers and an int8 output layer.
+ *
+ * @details Network file layout (little endian):
+ * - 64 byte header: 8 byte magic "ELBYNNUE", uint32 version, then uint32
+ *   input, L1, L2 and L3 dimensions, zero padded.
+ * - int16 feature biases [L1], int16 feature weights [input][L1].
+ * - int32 L2 biases [L2], int8 L2 weights [L2][2 * L1].
+ * - int32 L3 biases [L3], int8 L3 weights [L3][L2].
+ * - int32 output bias, int8 output weights [L3].
+ */
+namespace engine::parts::nnue
+{
+/**
+ * @brief First layer outputs of both sides' views of the board.
+ */
+struct alignas(CACHE_LINE_SIZE) Accumulator
+{
+  // PROPERTIES
+
+  /// @brief Accumulated feature weights, indexed by the viewing side's color.
+  std::array<std::array<int16_t, NNUE_L1_DIMENSIONS>, NUM_OF_COLORS> values;
+};
+
+/**
+ * @brief Class that loads and owns the weights of a network file.
+ *
+ * @details On POSIX systems the file is memory mapped and the weights are read
+ * in place, so every engine process loading the same file shares the pages.
+ */
+class Network
+{
+public:
+  // CONSTRUCTORS
+
+  /**
+   * @brief Construct an empty Network object with no weights loaded.
+   */
+  Network() = default;
+
+  /**
+   * @brief Destroy the Network object and release the weights.
+   */
+  ~Network();
+
+  Network(const Network &) = delete;
+  auto operator=(const Network &) -> Network & = delete;
+
+  // FUNCTIONS
+
+  /**
+   * @brief Loads the weights from a network file, replacing any loaded
+   * weights.
+   *
+   * @note Boards using this network must refresh their accumulators after
+   * loading.
+   *
+   * @param file_path Path to the network file.
+   *
+   * @return True if the file was loaded, false otherwise.
+   */
+  auto load(const std::string &file_path) -> bool;
+
+  /**
+   * @brief Checks if weights are loaded.
+   *
+   * @return True if weights are loaded, false otherwise.
+   */
+  [[nodiscard]] auto is_loaded() const -> bool;
+
+  /**
+   * @brief Computes the first layer of a view of the board from scratch.
+   *
+   * @param accumulator Accumulator to refresh.
+   * @param perspective Color of the viewing side.
+   * @param active_features Feature indexes of the pieces on the board.
+   */
+  void refresh_accumulator(Accumulator &accumulator,
+                           PieceColor perspective,
+                           const std::vector<int> &active_features) const;
+
+  /**
+   * @brief Adds a feature's weights to a view of the board.
+   *
+   * @param accumulator Accumulator to update.
+   * @param perspective Color of the viewing side.
+   * @param feature Feature index of the added piece.
+   */
+  void add_feature(Accumulator &accumulator,
+                   PieceColor perspective,
+                   int feature) const;
+
+  /**
+   * @brief Subtracts a feature's weights from a view of the board.
+   *
+   * @param accumulator Accumulator to update.
+   * @param perspective Color of the viewing side.
+   * @param feature Feature index of the removed piece.
+   */
+  void remove_feature(Accumulator &accumulator,
+                      PieceColor perspective,
+                      int feature) const;
+
+  /**
+   * @brief Evaluates a position from its accumulator.
+   *
+   * @param accumulator Up to date accumulator of the position.
+   * @param color_to_move Color of the side to move.
+   *
+   * @return Score of the position, positive is good for the side to move.
+   */
+  [[nodiscard]] auto evaluate(const Accumulator &accumulator,
+                              PieceColor color_to_move) const -> int;
+
+private:
+  // PROPERTIES
+
+  /// @brief Start of the memory mapped file, or nullptr if not mapped.
+  void *mapped_file = nullptr;
+
+  /// @brief Size of the memory mapped file.
+  size_t mapped_file_size = 0;
+
+  /// @brief File contents when memory mapping is not available.
+  std::vector<char> file_buffer;
+
+  /// @brief First layer biases.
+  const int16_t *feature_biases = nullptr;
+
+  /// @brief First layer weights, one row per feature.
+  const int16_t *feature_weights = nullptr;
+
+  /// @brief Second layer biases.
+  const int32_t *l2_biases = nullptr;
+
+  /// @brief Second layer weights, one row per output.
+  const int8_t *l2_weights = nullptr;
+
+  /// @brief Third layer biases.
+  const int32_t *l3_biases = nullptr;
+
+  /// @brief Third layer weights, one row per output.
+  const int8_t *l3_weights = nullptr;
+
+  /// @brief Output layer bias.
+  const int32_t *output_bias = nullptr;
+
+  /// @brief Output layer weights.
+  const int8_t *output_weights = nullptr;
+
+  // FUNCTIONS
+
+  /**
+   * @brief Releases the loaded weights.
+   */
+  void unload();
+
+  /**
+   * @brief Checks the header and points the weight arrays into the file.
+   *
+   * @param data Start of the file contents.
+   * @param size Size of the file contents.
+   *
+   * @return True if the file is a valid network file, false otherwise.
+   */
+  auto set_weights(const char *data, size_t size) -> bool;
+
+  /**
+   * @brief Runs an int8 layer with clipped ReLU outputs.
+   *
+   * @param input Layer inputs, each in [0, 127].
+   * @param input_size Number of inputs, a multiple of 32.
+   * @param biases Biases of the layer.
+   * @param weights Weights of the layer, one row of input_size per output.
+   * @param output Layer outputs, each in [0, 127].
+   * @param output_size Number of outputs.
+   */
+  static void propagate_layer(const uint8_t *input,
+                              int input_size,
+                              const int32_t *biases,
+                              const int8_t *weights,
+                              uint8_t *output,
+                              int output_size);
+};
+
+/**
+ * @brief Gets the feature index of a piece in a side's view of the board.
+ *
+ * @param perspective Color of the viewing side.
+ * @param king_square Square of the viewing side's king.
+ * @param piece_type Type of the piece, must not be a king.
+ * @param piece_color Color of the piece.
+ * @param square Square of the piece.
+ *
+ * @return Feature index in [0, NNUE_INPUT_DIMENSIONS).
+ */
+auto feature_index(PieceColor perspective,
+                   int king_square,
+                   PieceType piece_type,
+                   PieceColor piece_color,
+                   int square) -> int;
+
+/**
+ * @brief Adds a row of first layer weights to an accumulator half.
+ *
+ * @param accumulator Accumulator half of NNUE_L1_DIMENSIONS values.
+ * @param weights Weight row of NNUE_L1_DIMENSIONS values.
+ */
+static void add_row(int16_t *accumulator, const int16_t *weights);
+
+/**
+ * @brief Subtracts a row of first layer weights from an accumulator half.
+ *
+ * @param accumulator Accumulator half of NNUE_L1_DIMENSIONS values.
+ * @param weights Weight row of NNUE_L1_DIMENSIONS values.
+ */
+static void subtract_row(int16_t *accumulator, const int16_t *weights);
+
+/**
+ * @brief Clips an accumulator half to [0, 127] and narrows it to bytes.
+ *
+ * @param accumulator Accumulator half of NNUE_L1_DIMENSIONS values.
+ * @param output Clipped values.
+ */
+static void clip_accumulator(const int16_t *accumulator, uint8_t *output);
+
+/**
+ * @brief Computes the dot product of unsigned byte inputs and signed byte
+ * weights.
+ *
+ * @param input Inputs, each in [0, 127].
+ * @param weights Weights.
+ * @param size Number of inputs, a multiple of 32.
+ *
+ * @return Dot product.
+ */
+static auto dot_product(const uint8_t *input, const int8_t *weights, int size)
+    -> int32_t;
+} // namespace engine::parts::nnue
+
+#endif // NNUE_H
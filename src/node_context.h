@@ -1,10 +1,31 @@
 #ifndef NODE_CONTEXT_H
 #define NODE_CONTEXT_H
 
+#include "attack_check.h"
 #include "board_state.h"
+#include "move.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace engine::parts
 {
+/**
+ * @brief Enum to represent the type of a search node.
+ *
+ * @details The node type is a template parameter of the search functions so
+ * that each node type gets its own specialized search body:
+ * - ROOT: The root node of the search. Scores every root move.
+ * - PV: A node searched with an open window (beta - alpha > 1).
+ * - NON_PV: A node searched with a null window (beta - alpha == 1).
+ */
+enum class NodeType : std::uint8_t
+{
+  ROOT,
+  PV,
+  NON_PV,
+};
 
 struct NodeContext
 {
@@ -14,24 +35,42 @@ struct NodeContext
   int beta;
   int depth;
   bool is_forward_pruning_line;
-  bool is_pvs_line;
   int ply;
   int thread_index;
   int original_alpha;
+  const attack_check::CheckInfo *previous_check_info;
   bool previous_state_in_check;
   int iteration_depth;
-  bool is_quiescence;
   uint64_t hash;
 
   // DEFAULTS
   int eval = 0;
-  int static_eval = 0;
+  int static_eval = NO_STATIC_EVAL;
   int max_eval = 0;
   int tt_eval = 0;
   int tt_flag = 0;
   int tt_entry_search_depth = 0;
   int tt_best_move_index = -1;
-  bool king_in_check = false; // TODO: Move this to board state.
+  int tt_static_eval = NO_STATIC_EVAL;
+  bool king_in_check = false;
+
+  /// @brief Check state of the side to move, computed once per node.
+  attack_check::CheckInfo check_info{};
+
+  /// @brief True if check_info has already been computed for this position,
+  /// e.g. when a leaf node hands over to quiescence search.
+  bool check_state_is_known = false;
+
+  /// @brief True if the node was reached through a null move, which is not on
+  /// the previous move stack.
+  bool previous_move_is_null = false;
+
+  /// @brief True if static_eval is only the lazy material and piece-square
+  /// score, which must not be reused as the node's static evaluation.
+  bool static_eval_is_lazy = false;
+
+  /// @brief Scores of every root move. Only set for the ROOT node.
+  std::vector<std::pair<Move, int>> *root_move_scores = nullptr;
 };
 
 /**
@@ -43,12 +82,11 @@ struct NodeContext
  * @param depth Current depth of search.
  * @param is_forward_pruning_line Flag to indicate if the search line is from
  * a null move, late move reduction.
- * @param is_pvs_line Flag to indicate if the node is a PVS node.
  * @param ply Current ply of the search.
  * @param thread_index Thread index of the search thread.
- * @param previous_state_in_check Whether previous state was in check.
+ * @param previous_check_info Check state of the previous node, nullptr if
+ * there is no previous node.
  * @param iteration_depth Current iteration depth of search.
- * @param is_quiescence Flag whether node is a quiesence node.
  *
  * @return The created node context.
  */
@@ -57,12 +95,10 @@ auto new_context(BoardState &board_state,
                  int beta,
                  int depth,
                  bool is_forward_pruning_line,
-                 bool is_pvs_line,
                  int ply,
                  int thread_index,
-                 bool previous_state_in_check,
-                 int iteration_depth,
-                 bool is_quiescence = false) -> NodeContext;
+                 const attack_check::CheckInfo *previous_check_info,
+                 int iteration_depth) -> NodeContext;
 } // namespace engine::parts
 
 #endif // NODE_CONTEXT_H
@@ -0,0 +1,35 @@
+#include "pawn_hash_table.h"
+
+namespace engine::parts
+{
+// CONSTRUCTORS
+
+PawnHashTable::PawnHashTable(size_t max_size) : entries(max_size) {}
+
+// PUBLIC FUNCTIONS
+
+auto PawnHashTable::probe(uint64_t pawn_hash) -> const PawnHashEntry *
+{
+  const PawnHashEntry &entry = entries[pawn_hash & (entries.size() - 1)];
+  if (entry.pawn_hash != pawn_hash)
+  {
+    ++misses;
+    return nullptr;
+  }
+  ++hits;
+  return &entry;
+}
+
+auto PawnHashTable::store(const PawnHashEntry &entry) -> const PawnHashEntry &
+{
+  PawnHashEntry &slot = entries[entry.pawn_hash & (entries.size() - 1)];
+  slot = entry;
+  return slot;
+}
+
+void PawnHashTable::reset_counters()
+{
+  hits = 0;
+  misses = 0;
+}
+} // namespace engine::parts
@@ -0,0 +1,95 @@
+#ifndef PAWN_HASH_TABLE_H
+#define PAWN_HASH_TABLE_H
+
+#include "bitboard.h"
+#include "engine_constants.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine::parts
+{
+/**
+ * @brief Entry in the pawn hash table.
+ *
+ * @details Everything in the entry only depends on the pawns on the board, so
+ * it stays valid for every position with the same pawn hash.
+ */
+struct PawnHashEntry
+{
+  // PROPERTIES
+
+  /// @brief Pawn hash of the board state.
+  uint64_t pawn_hash = 0;
+
+  /// @brief Pawn structure score, from white's perspective.
+  int score = 0;
+
+  /// @brief Squares attacked by the pawns of each color.
+  std::array<bitboard::bitboard_type, NUM_OF_COLORS> pawn_attacks{};
+
+  /// @brief Passed pawns of each color.
+  std::array<bitboard::bitboard_type, NUM_OF_COLORS> passed_pawns{};
+};
+
+/**
+ * @brief Class that caches pawn structure evaluations by pawn hash.
+ *
+ * @note Not thread safe. Each search thread owns its own table.
+ */
+class PawnHashTable
+{
+public:
+  // PROPERTIES
+
+  /// @brief Number of probes that found their entry.
+  size_t hits = 0;
+
+  /// @brief Number of probes that did not find their entry.
+  size_t misses = 0;
+
+  // CONSTRUCTORS
+
+  /**
+   * @brief Construct a new Pawn Hash Table object.
+   *
+   * @param max_size Number of entries in the table, must be a power of two.
+   */
+  PawnHashTable(size_t max_size = PAWN_HASH_TABLE_SIZE);
+
+  // FUNCTIONS
+
+  /**
+   * @brief Retrieve the entry of a pawn hash.
+   *
+   * @param pawn_hash Pawn hash of the board state.
+   *
+   * @return Pointer to the entry if found, nullptr otherwise.
+   */
+  auto probe(uint64_t pawn_hash) -> const PawnHashEntry *;
+
+  /**
+   * @brief Store an entry, replacing the entry in its slot.
+   *
+   * @param entry Entry to store.
+   *
+   * @return Reference to the stored entry.
+   */
+  auto store(const PawnHashEntry &entry) -> const PawnHashEntry &;
+
+  /**
+   * @brief Resets the hit and miss counters.
+   */
+  void reset_counters();
+
+private:
+  // PROPERTIES
+
+  /// @brief Entries of the table.
+  std::vector<PawnHashEntry> entries;
+};
+} // namespace engine::parts
+
+#endif // PAWN_HASH_TABLE_H
@@ -0,0 +1,288 @@
+#include "perf_counters.h"
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace engine::parts::perf_counters
+{
+#ifdef __linux__
+/// @brief Sampler of the calling thread, read by its signal handler.
+static thread_local PhaseSampler *active_sampler = nullptr;
+
+/// @brief Type and config of each event, see perf_event_open(2).
+static const std::array<std::pair<uint32_t, uint64_t>, NUM_OF_PERF_EVENTS>
+    PERF_EVENT_CONFIGS = {{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    }};
+
+/**
+ * @brief Gets the signal the events send when they overflow.
+ *
+ * @details A real-time signal, so overflows that happen close together are
+ * queued instead of merged.
+ *
+ * @return Signal number.
+ */
+static auto sample_signal() -> int { return SIGRTMIN; }
+
+/**
+ * @brief Handles the signal sent by an event overflow, see
+ * PhaseSampler::record_sample.
+ *
+ * @param signal Signal number.
+ * @param info Signal information, holds the event's file descriptor.
+ * @param context Unused.
+ */
+static void handle_sample_signal(int /*signal*/,
+                                 siginfo_t *info,
+                                 void * /*context*/)
+{
+  PhaseSampler *sampler = active_sampler;
+  if (sampler != nullptr)
+  {
+    sampler->record_sample(info->si_fd);
+  }
+}
+
+/**
+ * @brief Installs the signal handler of the samplers, once per process.
+ *
+ * @return True if the signal handler is installed.
+ */
+static auto install_signal_handler() -> bool
+{
+  static const bool is_installed = []() {
+    struct sigaction action = {};
+    action.sa_sigaction = handle_sample_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    return sigaction(sample_signal(), &action, nullptr) == 0;
+  }();
+  return is_installed;
+}
+#endif
+
+/**
+ * @brief Formats an estimated event count for the report.
+ *
+ * @param count Estimated count.
+ * @param is_available Flag to indicate if the event is sampled.
+ *
+ * @return Count, or "n/a" if the event is not sampled.
+ */
+static auto format_count(uint64_t count, bool is_available) -> std::string
+{
+  return is_available ? std::to_string(count) : "n/a";
+}
+
+// CONSTRUCTORS
+
+PhaseSampler::PhaseSampler() { event_fds.fill(-1); }
+
+PhaseSampler::~PhaseSampler() { stop(); }
+
+// PUBLIC FUNCTIONS
+
+auto PhaseSampler::start() -> bool
+{
+  stop();
+  error.clear();
+
+#ifdef __linux__
+  if (!install_signal_handler())
+  {
+    error = "failed to install the sample signal handler";
+    return false;
+  }
+
+  // The handler looks the sampler up, so it is set before any event can fire.
+  active_sampler = this;
+  f_owner_ex owner = {F_OWNER_TID, static_cast<pid_t>(syscall(SYS_gettid))};
+  int open_errno = 0;
+  for (int event = 0; event < NUM_OF_PERF_EVENTS; ++event)
+  {
+    perf_event_attr attributes = {};
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_EVENT_CONFIGS[event].first;
+    attributes.config = PERF_EVENT_CONFIGS[event].second;
+    attributes.sample_period = PERF_EVENT_SAMPLE_PERIODS[event];
+    attributes.wakeup_events = 1;
+    attributes.disabled = 1;
+    // User space only, which perf_event_paranoid allows by default.
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    int event_fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes,
+                                            0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    if (event_fd < 0)
+    {
+      open_errno = errno;
+      continue;
+    }
+    // Send the overflow signal to this thread only.
+    if (fcntl(event_fd, F_SETFL, O_ASYNC | O_NONBLOCK) != 0 ||
+        fcntl(event_fd, F_SETSIG, sample_signal()) != 0 ||
+        fcntl(event_fd, F_SETOWN_EX, &owner) != 0)
+    {
+      open_errno = errno;
+      close(event_fd);
+      continue;
+    }
+    event_fds[event] = event_fd;
+  }
+
+  if (!is_running())
+  {
+    active_sampler = nullptr;
+    error = std::string("perf_event_open failed: ") + strerror(open_errno);
+    return false;
+  }
+
+  for (int event_fd : event_fds)
+  {
+    if (event_fd >= 0)
+    {
+      ioctl(event_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(event_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  return true;
+#else
+  error = "hardware counters are only supported on Linux";
+  return false;
+#endif
+}
+
+void PhaseSampler::stop()
+{
+#ifdef __linux__
+  for (int &event_fd : event_fds)
+  {
+    if (event_fd >= 0)
+    {
+      ioctl(event_fd, PERF_EVENT_IOC_DISABLE, 0);
+      close(event_fd);
+      event_fd = -1;
+    }
+  }
+  if (active_sampler == this)
+  {
+    active_sampler = nullptr;
+  }
+#endif
+}
+
+void PhaseSampler::reset()
+{
+  for (auto &phase_samples : samples)
+  {
+    for (auto &event_samples : phase_samples)
+    {
+      event_samples = 0;
+    }
+  }
+}
+
+auto PhaseSampler::is_running() const -> bool
+{
+  for (int event = 0; event < NUM_OF_PERF_EVENTS; ++event)
+  {
+    if (event_is_available(event))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto PhaseSampler::event_is_available(int event) const -> bool
+{
+  return event_fds[event] >= 0;
+}
+
+auto PhaseSampler::estimated_count(SearchPhase phase, int event) const
+    -> uint64_t
+{
+  return samples[static_cast<int>(phase)][event].load(
+             std::memory_order_relaxed) *
+         PERF_EVENT_SAMPLE_PERIODS[event];
+}
+
+auto PhaseSampler::get_error() const -> const std::string & { return error; }
+
+void PhaseSampler::print_report() const
+{
+  if (!is_running())
+  {
+    printf("Hardware Counters: unavailable (%s)\n\n",
+           error.empty() ? "not started" : error.c_str());
+    return;
+  }
+
+  printf("Hardware Counters - Main Thread (estimated from samples):\n");
+  printf("%-11s %12s %12s %5s %10s %10s %10s\n", "Phase", "Cycles",
+         "Instructions", "IPC", "L1D Misses", "LLC Misses", "Br Misses");
+  for (int phase_index = 0; phase_index < NUM_OF_SEARCH_PHASES; ++phase_index)
+  {
+    auto phase = static_cast<SearchPhase>(phase_index);
+    uint64_t cycles = estimated_count(phase, CYCLES_EVENT);
+    uint64_t instructions = estimated_count(phase, INSTRUCTIONS_EVENT);
+
+    std::string ipc = "n/a";
+    if (cycles != 0 && event_is_available(INSTRUCTIONS_EVENT))
+    {
+      char ipc_buffer[16];
+      snprintf(ipc_buffer, sizeof(ipc_buffer), "%.2f",
+               static_cast<double>(instructions) / cycles);
+      ipc = ipc_buffer;
+    }
+
+    printf("%-11s %12s %12s %5s %10s %10s %10s\n",
+           SEARCH_PHASE_NAMES[phase_index],
+           format_count(cycles, event_is_available(CYCLES_EVENT)).c_str(),
+           format_count(instructions, event_is_available(INSTRUCTIONS_EVENT))
+               .c_str(),
+           ipc.c_str(),
+           format_count(estimated_count(phase, L1D_MISSES_EVENT),
+                        event_is_available(L1D_MISSES_EVENT))
+               .c_str(),
+           format_count(estimated_count(phase, LLC_MISSES_EVENT),
+                        event_is_available(LLC_MISSES_EVENT))
+               .c_str(),
+           format_count(estimated_count(phase, BRANCH_MISSES_EVENT),
+                        event_is_available(BRANCH_MISSES_EVENT))
+               .c_str());
+  }
+  printf("\n");
+}
+
+void PhaseSampler::record_sample(int event_fd)
+{
+  for (int event = 0; event < NUM_OF_PERF_EVENTS; ++event)
+  {
+    if (event_fds[event] == event_fd)
+    {
+      samples[static_cast<int>(current_phase)][event].fetch_add(
+          1, std::memory_order_relaxed);
+      return;
+    }
+  }
+}
+} // namespace engine::parts::perf_counters
@@ -0,0 +1,222 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include "engine_constants.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Hardware performance counters of the search, sampled with Linux
+ * perf_event_open and attributed to coarse search phases.
+ *
+ * @details Every sampled event sends a signal to its thread after a fixed
+ * number of events. The signal handler adds the sample to the phase the
+ * thread is in at that moment. Entering a phase is a ScopedPhase, which only
+ * stores the phase in a thread local variable, so the markers are cheap
+ * enough to stay in the search.
+ */
+namespace engine::parts::perf_counters
+{
+/**
+ * @brief Coarse phases of the search. Nested phases take over from the phase
+ * they are nested in, e.g. move generation inside the quiescence search counts
+ * as move generation.
+ */
+enum class SearchPhase : std::uint8_t
+{
+  SEARCH = 0,
+  MOVE_GENERATION = 1,
+  MAKE_UNMAKE = 2,
+  EVALUATION = 3,
+  TT_PROBE = 4,
+  QUIESCENCE = 5
+};
+
+const int NUM_OF_SEARCH_PHASES = 6;
+const int NUM_OF_PERF_EVENTS = 5;
+
+// EVENT INDICES
+const int CYCLES_EVENT = 0;
+const int INSTRUCTIONS_EVENT = 1;
+const int L1D_MISSES_EVENT = 2;
+const int LLC_MISSES_EVENT = 3;
+const int BRANCH_MISSES_EVENT = 4;
+
+const std::array<const char *, NUM_OF_SEARCH_PHASES> SEARCH_PHASE_NAMES = {
+    "search", "movegen", "make_unmake", "eval", "tt_probe", "qsearch"};
+
+const std::array<const char *, NUM_OF_PERF_EVENTS> PERF_EVENT_NAMES = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+
+/// @brief Number of events between two samples of each event. Rare events are
+/// sampled more often so that every phase gets enough samples.
+const std::array<uint64_t, NUM_OF_PERF_EVENTS> PERF_EVENT_SAMPLE_PERIODS = {
+    1000000, 1000000, 20000, 2000, 10000};
+
+/// @brief Search phase of the calling thread.
+/// NOTE: Volatile because the signal handler reads it between any two
+/// instructions of the thread.
+inline thread_local volatile SearchPhase current_phase = SearchPhase::SEARCH;
+
+/**
+ * @brief Marks the calling thread as being in a search phase until the end of
+ * the scope. Does nothing when the engine is built without PERF_COUNTERS.
+ *
+ * @note Defined in the header so that the markers inline.
+ */
+class ScopedPhase
+{
+public:
+  // CONSTRUCTORS
+
+  /**
+   * @brief Enters a search phase.
+   *
+   * @param phase Search phase to enter.
+   */
+  explicit ScopedPhase(SearchPhase phase)
+  {
+    if constexpr (PERF_COUNTERS_ENABLED)
+    {
+      previous_phase = current_phase;
+      current_phase = phase;
+    }
+  }
+
+  /**
+   * @brief Returns to the phase the scope was entered from.
+   */
+  ~ScopedPhase()
+  {
+    if constexpr (PERF_COUNTERS_ENABLED)
+    {
+      current_phase = previous_phase;
+    }
+  }
+
+  ScopedPhase(const ScopedPhase &) = delete;
+  auto operator=(const ScopedPhase &) -> ScopedPhase & = delete;
+
+private:
+  // PROPERTIES
+
+  /// @brief Phase the scope was entered from.
+  SearchPhase previous_phase = SearchPhase::SEARCH;
+};
+
+/**
+ * @brief Samples the hardware events of one thread and attributes them to the
+ * thread's search phases.
+ *
+ * @details Each event is opened on its own, so a machine that only supports
+ * some of the events still reports those. When no event can be opened, e.g.
+ * in a virtual machine without a PMU, with a restrictive
+ * perf_event_paranoid setting, or on another platform, start fails and the
+ * search runs as usual.
+ */
+class PhaseSampler
+{
+public:
+  // CONSTRUCTORS
+
+  PhaseSampler();
+
+  /**
+   * @brief Stops sampling.
+   */
+  ~PhaseSampler();
+
+  PhaseSampler(const PhaseSampler &) = delete;
+  auto operator=(const PhaseSampler &) -> PhaseSampler & = delete;
+
+  // FUNCTIONS
+
+  /**
+   * @brief Starts sampling the calling thread.
+   *
+   * @note Only the thread that called start may call stop.
+   *
+   * @return True if at least one event is sampled, false otherwise. See
+   * get_error for the reason.
+   */
+  auto start() -> bool;
+
+  /**
+   * @brief Stops sampling and closes the events. The samples are kept.
+   */
+  void stop();
+
+  /**
+   * @brief Clears the samples.
+   */
+  void reset();
+
+  /**
+   * @brief Checks if the sampler is sampling.
+   *
+   * @return True if at least one event is sampled.
+   */
+  [[nodiscard]] auto is_running() const -> bool;
+
+  /**
+   * @brief Checks if an event is sampled.
+   *
+   * @param event Index of the event.
+   *
+   * @return True if the event could be opened.
+   */
+  [[nodiscard]] auto event_is_available(int event) const -> bool;
+
+  /**
+   * @brief Estimates the number of events in a phase from its samples.
+   *
+   * @param phase Search phase.
+   * @param event Index of the event.
+   *
+   * @return Number of samples times the sample period of the event.
+   */
+  [[nodiscard]] auto estimated_count(SearchPhase phase, int event) const
+      -> uint64_t;
+
+  /**
+   * @brief Gets the reason the last start failed.
+   *
+   * @return Reason, empty if the last start succeeded.
+   */
+  [[nodiscard]] auto get_error() const -> const std::string &;
+
+  /**
+   * @brief Prints the estimated events, IPC and miss rates of each phase.
+   */
+  void print_report() const;
+
+  /**
+   * @brief Adds a sample to the current phase of the calling thread.
+   *
+   * @note Called by the signal handler of the sampled thread.
+   *
+   * @param event_fd File descriptor of the event that overflowed.
+   */
+  void record_sample(int event_fd);
+
+private:
+  // PROPERTIES
+
+  /// @brief File descriptor of each event, -1 if the event is not sampled.
+  std::array<int, NUM_OF_PERF_EVENTS> event_fds{};
+
+  /// @brief Samples of each event in each phase.
+  /// NOTE: Atomic because the signal handler writes them.
+  std::array<std::array<std::atomic<uint64_t>, NUM_OF_PERF_EVENTS>,
+             NUM_OF_SEARCH_PHASES>
+      samples{};
+
+  /// @brief Reason the last start failed.
+  std::string error;
+};
+} // namespace engine::parts::perf_counters
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,199 @@
+#include "perft.h"
+#include "move_generator.h"
+#include "move_interface.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace engine::parts::perft
+{
+auto perft(BoardState &board_state, int depth, PerftHashTable *hash_table)
+    -> size_t
+{
+  if (depth == 0)
+  {
+    return 1;
+  }
+
+  size_t nodes = 0;
+  uint64_t hash = board_state.get_current_state_hash();
+  if (hash_table != nullptr && hash_table->probe(hash, depth, nodes))
+  {
+    return nodes;
+  }
+
+  PieceColor color_to_move = board_state.color_to_move;
+  attack_check::CheckInfo check_info =
+      attack_check::compute_check_info(board_state, color_to_move);
+  std::vector<Move> possible_moves =
+      move_generator::calculate_possible_moves(board_state);
+
+  for (Move &move : possible_moves)
+  {
+    bool move_is_known_legal = check_info.move_is_known_legal(move);
+
+    // BULK COUNTING
+    // A legal move at the last ply is a leaf, so it does not need to be made.
+    if (depth == 1 && move_is_known_legal)
+    {
+      ++nodes;
+      continue;
+    }
+
+    board_state.apply_move(move);
+    if (move_is_known_legal ||
+        !attack_check::king_is_checked(board_state, color_to_move))
+    {
+      nodes += perft(board_state, depth - 1, hash_table);
+    }
+    board_state.undo_move();
+  }
+
+  if (hash_table != nullptr)
+  {
+    hash_table->store(hash, depth, nodes);
+  }
+  return nodes;
+}
+
+auto copy_make_perft(BoardState &board_state,
+                     int depth,
+                     PerftHashTable *hash_table,
+                     std::deque<BoardState> &child_board_states) -> size_t
+{
+  if (depth == 0)
+  {
+    return 1;
+  }
+
+  size_t nodes = 0;
+  uint64_t hash = board_state.get_current_state_hash();
+  if (hash_table != nullptr && hash_table->probe(hash, depth, nodes))
+  {
+    return nodes;
+  }
+
+  PieceColor color_to_move = board_state.color_to_move;
+  attack_check::CheckInfo check_info =
+      attack_check::compute_check_info(board_state, color_to_move);
+  std::vector<Move> possible_moves =
+      move_generator::calculate_possible_moves(board_state);
+
+  BoardState &child_board_state = child_board_states[depth - 1];
+  for (Move &move : possible_moves)
+  {
+    bool move_is_known_legal = check_info.move_is_known_legal(move);
+
+    // BULK COUNTING
+    if (depth == 1 && move_is_known_legal)
+    {
+      ++nodes;
+      continue;
+    }
+
+    child_board_state.copy_make(board_state, move);
+    if (move_is_known_legal ||
+        !attack_check::king_is_checked(child_board_state, color_to_move))
+    {
+      nodes += copy_make_perft(child_board_state, depth - 1, hash_table,
+                               child_board_states);
+    }
+  }
+
+  if (hash_table != nullptr)
+  {
+    hash_table->store(hash, depth, nodes);
+  }
+  return nodes;
+}
+
+auto divide(const BoardState &board_state,
+            int depth,
+            int num_of_threads,
+            PerftHashTable *hash_table,
+            bool use_copy_make)
+    -> std::vector<std::pair<std::string, size_t>>
+{
+  // Move generation only depends on the board, so every copy of the board
+  // state generates the root moves in the same order.
+  BoardState root_board_state(board_state);
+  attack_check::CheckInfo check_info = attack_check::compute_check_info(
+      root_board_state, root_board_state.color_to_move);
+  std::vector<Move> root_moves =
+      move_generator::calculate_possible_moves(root_board_state);
+
+  std::vector<int> legal_move_indices;
+  for (int move_index = 0; move_index < static_cast<int>(root_moves.size());
+       ++move_index)
+  {
+    if (move_is_legal(root_board_state, root_moves[move_index], check_info))
+    {
+      legal_move_indices.push_back(move_index);
+    }
+  }
+
+  std::vector<size_t> root_move_nodes(legal_move_indices.size(), 0);
+  std::atomic<int> next_legal_move = 0;
+
+  std::vector<std::thread> perft_threads;
+  for (int thread_index = 0; thread_index < std::max(num_of_threads, 1);
+       ++thread_index)
+  {
+    perft_threads.emplace_back(
+        [&board_state, &legal_move_indices, &root_move_nodes, &next_legal_move,
+         depth, hash_table, use_copy_make]() {
+          BoardState thread_board_state(board_state);
+          std::vector<Move> thread_root_moves =
+              move_generator::calculate_possible_moves(thread_board_state);
+          // One board state for the root move and one for each ply below it.
+          std::deque<BoardState> child_board_states(use_copy_make ? depth : 0);
+
+          for (int legal_move = next_legal_move.fetch_add(1);
+               legal_move < static_cast<int>(legal_move_indices.size());
+               legal_move = next_legal_move.fetch_add(1))
+          {
+            Move &move = thread_root_moves[legal_move_indices[legal_move]];
+            if (use_copy_make)
+            {
+              BoardState &root_child_board_state =
+                  child_board_states[depth - 1];
+              root_child_board_state.copy_make(thread_board_state, move);
+              root_move_nodes[legal_move] =
+                  copy_make_perft(root_child_board_state, depth - 1,
+                                  hash_table, child_board_states);
+              continue;
+            }
+            thread_board_state.apply_move(move);
+            root_move_nodes[legal_move] =
+                perft(thread_board_state, depth - 1, hash_table);
+            thread_board_state.undo_move();
+          }
+        });
+  }
+
+  for (auto &perft_thread : perft_threads)
+  {
+    perft_thread.join();
+  }
+
+  std::vector<std::pair<std::string, size_t>> move_nodes;
+  for (size_t legal_move = 0; legal_move < legal_move_indices.size();
+       ++legal_move)
+  {
+    move_nodes.emplace_back(
+        move_interface::move_to_string(
+            root_moves[legal_move_indices[legal_move]]),
+        root_move_nodes[legal_move]);
+  }
+  return move_nodes;
+}
+
+auto move_is_legal(BoardState &board_state,
+                   Move &move,
+                   const attack_check::CheckInfo &check_info) -> bool
+{
+  return check_info.move_is_known_legal(move) ||
+         !attack_check::move_leaves_king_in_check(board_state, move);
+}
+} // namespace engine::parts::perft
@@ -0,0 +1,132 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "attack_check.h"
+#include "board_state.h"
+#include "perft_hash_table.h"
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Namespace for perft functions, which count the leaf nodes of the
+ * legal move tree to verify and time move generation.
+ */
+namespace engine::parts::perft
+{
+/**
+ * @brief Position with a known perft node count.
+ */
+struct ReferencePosition
+{
+  // PROPERTIES
+
+  /// @brief Name used to select the position.
+  std::string name;
+
+  /// @brief Position in Forsyth-Edwards Notation.
+  std::string fen;
+
+  /// @brief Depth of the known node count.
+  int depth;
+
+  /// @brief Known node count.
+  size_t nodes;
+};
+
+/// @brief Positions that cover castling, en passant, promotion and checks,
+/// with their published node counts.
+const std::array<ReferencePosition, 9> REFERENCE_POSITIONS = {{
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+     4865609},
+    {"kiwipete",
+     "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+     4085603},
+    {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+    {"promotions",
+     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4,
+     422333},
+    {"middlegame", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     4, 2103487},
+    {"en_passant_pin", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888},
+    {"en_passant_check", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467},
+    {"underpromotion", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683},
+    {"castling_rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4,
+     1274206},
+}};
+
+/**
+ * @brief Counts the leaf nodes of the legal move tree.
+ *
+ * @details Moves at the last ply are counted without being made when the
+ * check state proves them legal (bulk counting).
+ *
+ * @param board_state Board state to count from, restored on return.
+ * @param depth Depth to count to.
+ * @param hash_table Table to cache node counts in, or nullptr.
+ *
+ * @return Number of leaf nodes.
+ */
+auto perft(BoardState &board_state, int depth, PerftHashTable *hash_table)
+    -> size_t;
+
+/**
+ * @brief Counts the leaf nodes of the legal move tree with copy-make: every
+ * child is a copy of its parent with the move applied, see
+ * BoardState::copy_make.
+ *
+ * @param board_state Board state to count from, left untouched.
+ * @param depth Depth to count to.
+ * @param hash_table Table to cache node counts in, or nullptr.
+ * @param child_board_states Board states to make the children in, one for
+ * each remaining ply, at least depth of them.
+ *
+ * @return Number of leaf nodes.
+ */
+auto copy_make_perft(BoardState &board_state,
+                     int depth,
+                     PerftHashTable *hash_table,
+                     std::deque<BoardState> &child_board_states) -> size_t;
+
+/**
+ * @brief Counts the leaf nodes under every legal root move.
+ *
+ * @details Root moves are handed out to the threads one at a time, each
+ * thread counting on its own copy of the board state.
+ *
+ * @param board_state Board state to count from.
+ * @param depth Depth to count to, at least 1.
+ * @param num_of_threads Number of threads to count with.
+ * @param hash_table Table to cache node counts in, or nullptr. Shared by all
+ * threads.
+ * @param use_copy_make Flag to count with copy-make instead of make/unmake.
+ *
+ * @return Each legal root move in UCI format with its number of leaf nodes,
+ * in move generation order.
+ */
+auto divide(const BoardState &board_state,
+            int depth,
+            int num_of_threads,
+            PerftHashTable *hash_table,
+            bool use_copy_make = false)
+    -> std::vector<std::pair<std::string, size_t>>;
+
+/**
+ * @brief Checks if a move of the side to move is legal, making it if needed.
+ *
+ * @param board_state Board state the move was generated for.
+ * @param move Move to check.
+ * @param check_info Check state of the side to move.
+ *
+ * @return True if the move does not leave its own king in check.
+ */
+static auto move_is_legal(BoardState &board_state,
+                          Move &move,
+                          const attack_check::CheckInfo &check_info) -> bool;
+} // namespace engine::parts::perft
+
+#endif // PERFT_H
@@ -0,0 +1,43 @@
+#include "perft_hash_table.h"
+#include "engine_constants.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace engine::parts
+{
+// CONSTRUCTORS
+
+PerftHashTable::PerftHashTable(size_t size_in_mb)
+    : entries(std::bit_floor(
+          std::max<size_t>(size_in_mb * 1024 * 1024 / sizeof(PerftHashEntry),
+                           1)))
+{
+}
+
+// PUBLIC FUNCTIONS
+
+auto PerftHashTable::probe(uint64_t hash, int depth, size_t &nodes) const
+    -> bool
+{
+  const PerftHashEntry &entry = entries[hash & (entries.size() - 1)];
+  uint64_t data = entry.data.load(std::memory_order_relaxed);
+  uint64_t key = entry.key.load(std::memory_order_relaxed);
+  if ((key ^ data) != hash ||
+      (data & PERFT_DEPTH_MASK) != static_cast<uint64_t>(depth))
+  {
+    return false;
+  }
+  nodes = data >> PERFT_DEPTH_BITS;
+  return true;
+}
+
+void PerftHashTable::store(uint64_t hash, int depth, size_t nodes)
+{
+  PerftHashEntry &entry = entries[hash & (entries.size() - 1)];
+  uint64_t data = (static_cast<uint64_t>(nodes) << PERFT_DEPTH_BITS) |
+                  static_cast<uint64_t>(depth);
+  entry.key.store(hash ^ data, std::memory_order_relaxed);
+  entry.data.store(data, std::memory_order_relaxed);
+}
+} // namespace engine::parts
@@ -0,0 +1,79 @@
+#ifndef PERFT_HASH_TABLE_H
+#define PERFT_HASH_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine::parts
+{
+/**
+ * @brief Entry in the perft hash table.
+ *
+ * @details The data word packs the node count and the depth. The key word is
+ * the hash XORed with the data, so an entry torn by two threads storing at
+ * once fails verification instead of returning a wrong count.
+ */
+struct PerftHashEntry
+{
+  // PROPERTIES
+
+  /// @brief Hash of the board state XORed with data.
+  std::atomic<uint64_t> key{0};
+
+  /// @brief Node count shifted by PERFT_DEPTH_BITS, plus the depth.
+  std::atomic<uint64_t> data{0};
+};
+
+/**
+ * @brief Class that caches perft node counts by board state hash and depth.
+ *
+ * @details Shared by all perft threads without locks. The lower bits of the
+ * hash select the entry.
+ */
+class PerftHashTable
+{
+public:
+  // CONSTRUCTORS
+
+  /**
+   * @brief Construct a new Perft Hash Table object.
+   *
+   * @param size_in_mb Memory to use, rounded down to a power of two number of
+   * entries.
+   */
+  PerftHashTable(size_t size_in_mb);
+
+  // FUNCTIONS
+
+  /**
+   * @brief Retrieve the node count of a board state.
+   *
+   * @param hash Hash of the board state.
+   * @param depth Depth the nodes were counted to.
+   * @param nodes Number of nodes (output parameter).
+   *
+   * @return True if the entry was found, false otherwise.
+   */
+  auto probe(uint64_t hash, int depth, size_t &nodes) const -> bool;
+
+  /**
+   * @brief Store the node count of a board state, replacing the entry in its
+   * slot.
+   *
+   * @param hash Hash of the board state.
+   * @param depth Depth the nodes were counted to.
+   * @param nodes Number of nodes.
+   */
+  void store(uint64_t hash, int depth, size_t nodes);
+
+private:
+  // PROPERTIES
+
+  /// @brief Entries of the table.
+  std::vector<PerftHashEntry> entries;
+};
+} // namespace engine::parts
+
+#endif // PERFT_HASH_TABLE_H
@@ -70,13 +70,17 @@ struct Piece
   /**
    * @brief Constructor with default values.
    *
+   * @param x_file The x coordinate of the piece (default is -1, off the
+   * board).
+   * @param y_rank The y coordinate of the piece (default is -1, off the
+   * board).
    * @param piece_type Type of piece (default is EMPTY).
    * @param piece_color Color of the piece (default is NONE).
    * @param piece_has_moved Whether the piece has moved or not (default is
    * false).
    */
-  Piece(int x_file,
-        int y_rank,
+  Piece(int x_file = -1,
+        int y_rank = -1,
         PieceType piece_type = PieceType::EMPTY,
         PieceColor piece_color = PieceColor::NONE,
         bool piece_has_moved = false);
@@ -0,0 +1,155 @@
+#ifndef PIECE_SQUARE_TABLES_H
+#define PIECE_SQUARE_TABLES_H
+
+#include "engine_constants.h"
+#include "piece.h"
+
+#include <array>
+
+/**
+ * @brief Namespace for the material and piece-square tables.
+ *
+ * @details These are the evaluation terms that only depend on a piece and the
+ * square it stands on. BoardState keeps their sum up to date in apply_move and
+ * undo_move, so the position evaluator does not need to recompute them.
+ */
+namespace engine::parts::piece_square_tables
+{
+/// @brief Score of every piece type of every color on every square, for each
+/// game phase. Scores are from white's perspective, so black scores are
+/// negative.
+using piece_square_table_type = std::array<
+    std::array<std::array<std::array<int, NUM_OF_SQUARES>, NUM_OF_PIECE_TYPES>,
+               NUM_OF_COLORS>,
+    NUM_OF_GAME_PHASES>;
+
+/**
+ * @brief Computes the material and piece-square score of a piece, from the
+ * piece's own perspective.
+ *
+ * @param piece_type Type of the piece.
+ * @param piece_color Color of the piece.
+ * @param x_file The x coordinate of the piece (file).
+ * @param y_rank The y coordinate of the piece (rank).
+ * @param is_end_game Flag to indicate if the score is for the end game.
+ *
+ * @return Score of the piece on the square.
+ */
+constexpr auto piece_square_score(PieceType piece_type,
+                                  PieceColor piece_color,
+                                  int x_file,
+                                  int y_rank,
+                                  bool is_end_game) -> int
+{
+  int score = 0;
+  switch (piece_type)
+  {
+  case PieceType::PAWN:
+  {
+    score += PAWN_VALUE + PAWN_POSITION_EVAL_MAP[x_file];
+
+    // If in the end game, give a pawn more value the closer they are to
+    // getting promoted into a main piece.
+    int ranks_advanced =
+        (piece_color == PieceColor::WHITE) ? y_rank : (Y_MAX - y_rank);
+    score += ranks_advanced * (is_end_game ? VERY_SMALL_EVAL_VALUE
+                                           : EXTREMELY_SMALL_EVAL_VALUE);
+
+    // If pawn is in the middle of the board, give it a bonus.
+    if (!is_end_game && (x_file == XD_FILE || x_file == XE_FILE) &&
+        (y_rank == Y4_RANK || y_rank == Y5_RANK))
+    {
+      score += MEDIUM_EVAL_VALUE;
+    }
+    break;
+  }
+  case PieceType::KNIGHT:
+    score += KNIGHT_VALUE;
+
+    // The more squares a knight can reach, and the closer they are to the
+    // center, the better.
+    for (const auto &knight_move : KNIGHT_MOVES)
+    {
+      int new_x = x_file + knight_move[0];
+      int new_y = y_rank + knight_move[1];
+      if (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN && new_y <= Y_MAX)
+      {
+        score += KNIGHT_POSITION_EVAL_MAP[new_y];
+        score += KNIGHT_POSITION_EVAL_MAP[new_x];
+      }
+      else
+      {
+        score -= SMALL_EVAL_VALUE;
+      }
+    }
+    break;
+  case PieceType::BISHOP:
+    score += BISHOP_VALUE;
+
+    // We don't generally want bishops on the back rank, but not in the end
+    // game.
+    if (!is_end_game &&
+        y_rank == ((piece_color == PieceColor::WHITE) ? Y1_RANK : Y8_RANK))
+    {
+      score -= LARGE_EVAL_VALUE;
+    }
+    break;
+  case PieceType::ROOK:
+    score += ROOK_VALUE;
+    break;
+  case PieceType::QUEEN:
+    score += QUEEN_VALUE;
+    break;
+  case PieceType::KING:
+    score += KING_VALUE;
+
+    // Give points if the king is far away from the center of the board. But
+    // not in the end game where the king needs to be active.
+    if (!is_end_game)
+    {
+      score += KING_POSITION_EVAL_MAP[x_file];
+    }
+    break;
+  default:
+    break;
+  }
+  return score;
+}
+
+/**
+ * @brief Builds the piece-square tables of both game phases.
+ *
+ * @return Piece-square tables.
+ */
+constexpr auto build_piece_square_tables() -> piece_square_table_type
+{
+  piece_square_table_type tables{};
+  for (int phase = 0; phase < NUM_OF_GAME_PHASES; ++phase)
+  {
+    for (int color = 0; color < NUM_OF_COLORS; ++color)
+    {
+      for (int type = 0; type < NUM_OF_PIECE_TYPES; ++type)
+      {
+        for (int square = 0; square < NUM_OF_SQUARES; ++square)
+        {
+          int score = piece_square_score(
+              static_cast<PieceType>(type), static_cast<PieceColor>(color),
+              square % BOARD_WIDTH, square / BOARD_WIDTH,
+              phase == END_GAME_PHASE);
+          tables[phase][color][type][square] =
+              (static_cast<PieceColor>(color) == PieceColor::WHITE) ? score
+                                                                    : -score;
+        }
+      }
+    }
+  }
+  return tables;
+}
+
+/// @brief Material and piece-square tables, indexed by game phase, piece
+/// color, piece type and square.
+inline constexpr piece_square_table_type PIECE_SQUARE_TABLES =
+    build_piece_square_tables();
+} // namespace engine::parts::piece_square_tables
+
+#endif // PIECE_SQUARE_TABLES_H
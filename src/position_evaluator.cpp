@@ -1,94 +1,44 @@
 #include "position_evaluator.h"
 
+#include <bit>
+
 namespace engine::parts::position_evaluator
 {
 // PUBLIC FUNCTIONS
 
-auto evaluate_position(const BoardState &board_state) -> int
+auto evaluate_position(const BoardState &board_state,
+                       PawnHashTable *pawn_hash_table) -> int
 {
-  int eval = 0;
-  // We pass eval_temp to evaluators now instead of eval directly. This way, the
-  // functions can evaluate white and black pieces the same way (positively). We
-  // can then check the piece color and add or subtract accordingly to the
-  // actual eval.
-  int eval_temp = 0;
-
-  // We give points if a player has a bishop pair. Bishop pair is extremely
-  // important in the end game as they can cover both color squares from a
-  // distance, and can protect pawns effectively.
-  int black_bishop_count = 0;
-  int white_bishop_count = 0;
-
-  for (Piece *piece_pointer : board_state.piece_list)
+  // Material and piece-square terms are kept up to date by BoardState, so
+  // only the terms that need a board scan are computed here.
+  int eval = board_state.piece_square_scores[board_state.is_end_game
+                                                 ? END_GAME_PHASE
+                                                 : MIDDLE_GAME_PHASE];
+
+  PawnHashEntry evaluated_pawn_entry;
+  const PawnHashEntry *pawn_entry = nullptr;
+  if (pawn_hash_table == nullptr)
   {
-    // Captured pieces have x_file == -1 and y_rank == -1.
-    // We skip them.
-    if (piece_pointer->x_file == -1)
-    {
-      continue;
-    }
-
-    eval_temp = 0;
-    Piece &piece = *piece_pointer;
-    PieceType &piece_type = piece.piece_type;
-    int &x_file = piece.x_file;
-    int &y_rank = piece.y_rank;
-
-    switch (piece_type)
+    evaluated_pawn_entry = evaluate_pawn_structure(board_state);
+    pawn_entry = &evaluated_pawn_entry;
+  }
+  else
+  {
+    pawn_entry = pawn_hash_table->probe(board_state.pawn_hash);
+    if (pawn_entry == nullptr)
     {
-    case PieceType::PAWN:
-      evaluate_pawn(x_file, y_rank, piece, eval_temp, board_state);
-      break;
-    case PieceType::ROOK:
-      evaluate_rook(x_file, y_rank, piece, eval_temp, board_state);
-      break;
-    case PieceType::KNIGHT:
-      evaluate_knight(x_file, y_rank, piece, eval_temp, board_state);
-      break;
-    case PieceType::BISHOP:
-      if (piece.piece_color == PieceColor::WHITE)
-      {
-        ++white_bishop_count;
-      }
-      else
-      {
-        ++black_bishop_count;
-      }
-      evaluate_bishop(x_file, y_rank, piece, eval_temp, board_state);
-      break;
-    case PieceType::QUEEN:
-      evaluate_queen(x_file, y_rank, piece, eval_temp, board_state);
-      break;
-    case PieceType::KING:
-      evaluate_king(x_file, y_rank, piece, eval_temp, board_state);
-      break;
-    default:
-      // Empty square.
-      break;
-    }
-
-    // If piece is black, subtract the evaluation.
-    if (piece_type != PieceType::EMPTY)
-    {
-      if (piece.piece_color == PieceColor::WHITE)
-      {
-        eval += eval_temp;
-      }
-      else
-      {
-        eval -= eval_temp;
-      }
+      pawn_entry =
+          &pawn_hash_table->store(evaluate_pawn_structure(board_state));
     }
   }
+  eval += pawn_entry->score;
 
-  if (white_bishop_count >= BISHOP_PAIR_COUNT)
-  {
-    eval += (MEDIUM_EVAL_VALUE + SMALL_EVAL_VALUE);
-  }
-  if (black_bishop_count >= BISHOP_PAIR_COUNT)
-  {
-    eval -= (MEDIUM_EVAL_VALUE + SMALL_EVAL_VALUE);
-  }
+  const AttackSets attack_sets = compute_attack_sets(board_state, *pawn_entry);
+
+  // Both sides are evaluated the same way (positively) by their own
+  // specialization, so no per-piece color branch is needed here.
+  eval += evaluate_pieces<PieceColor::WHITE>(board_state, attack_sets) -
+          evaluate_pieces<PieceColor::BLACK>(board_state, attack_sets);
 
   // In raw evaluations, positive eval is good for white and negative eval is
   // good for black. Since negamax nodes are always maximizing nodes, we need to
@@ -100,157 +50,282 @@ auto evaluate_position(const BoardState &board_state) -> int
   return eval;
 }
 
+auto evaluate_position_lazily(const BoardState &board_state,
+                              int alpha,
+                              int beta,
+                              int lazy_eval_margin,
+                              PawnHashTable *pawn_hash_table,
+                              bool &is_lazy) -> int
+{
+  int lazy_eval = board_state.piece_square_scores[board_state.is_end_game
+                                                      ? END_GAME_PHASE
+                                                      : MIDDLE_GAME_PHASE];
+  if (board_state.color_to_move == PieceColor::BLACK)
+  {
+    lazy_eval = -lazy_eval;
+  }
+
+  is_lazy = lazy_eval - lazy_eval_margin >= beta ||
+            lazy_eval + lazy_eval_margin <= alpha;
+  if (is_lazy)
+  {
+    return lazy_eval;
+  }
+  return evaluate_position(board_state, pawn_hash_table);
+}
+
 // PRIVATE FUNCTIONS
 
-void evaluate_pawn(const int x_file,
-                   const int y_rank,
-                   const Piece &pawn_piece,
-                   int &eval,
-                   const BoardState &board_state)
+template <PieceColor piece_color>
+auto evaluate_pieces(const BoardState &board_state,
+                     const AttackSets &attack_sets) -> int
 {
-  // Piece value.
-  eval += PAWN_VALUE;
+  int eval = 0;
 
-  // Position value - x coordinate.
-  eval += PAWN_POSITION_EVAL_MAP[x_file];
+  // Pawn structure is evaluated separately, see evaluate_pawn_structure.
+  const auto &own_pieces =
+      board_state.piece_bitboards[static_cast<uint8_t>(piece_color)];
 
-  // If in the end game, give a pawn more value the closer they are to
-  // getting promoted into a main piece.
-  int pawn_rank_score = EXTREMELY_SMALL_EVAL_VALUE;
-  if (board_state.is_end_game)
+  for (bitboard::bitboard_type knights =
+           own_pieces[static_cast<uint8_t>(PieceType::KNIGHT)];
+       knights != 0;)
   {
-    pawn_rank_score = VERY_SMALL_EVAL_VALUE;
+    int square = bitboard::pop_lowest_square(knights);
+    int x_file = square % BOARD_WIDTH;
+    int y_rank = square / BOARD_WIDTH;
+    evaluate_knight<piece_color>(x_file, y_rank,
+                                 *board_state.chess_board[x_file][y_rank],
+                                 eval, board_state);
   }
 
-  int rank_eval = 0;
-  if (pawn_piece.piece_color == PieceColor::WHITE)
+  // We give points if a player has a bishop pair. Bishop pair is extremely
+  // important in the end game as they can cover both color squares from a
+  // distance, and can protect pawns effectively.
+  bitboard::bitboard_type bishops =
+      own_pieces[static_cast<uint8_t>(PieceType::BISHOP)];
+  if (std::popcount(bishops) >= BISHOP_PAIR_COUNT)
   {
-    rank_eval = y_rank * pawn_rank_score;
+    eval += (MEDIUM_EVAL_VALUE + SMALL_EVAL_VALUE);
   }
-  else
+  while (bishops != 0)
   {
-    rank_eval = (Y_MAX - y_rank) * pawn_rank_score;
+    int square = bitboard::pop_lowest_square(bishops);
+    int x_file = square % BOARD_WIDTH;
+    int y_rank = square / BOARD_WIDTH;
+    evaluate_bishop<piece_color>(x_file, y_rank,
+                                 *board_state.chess_board[x_file][y_rank],
+                                 eval, board_state, attack_sets);
   }
-  eval += rank_eval;
 
-  // If pawn is in the middle of the board, give it a bonus.
-  if (!board_state.is_end_game && (x_file == XD_FILE || x_file == XE_FILE) &&
-      (y_rank == Y4_RANK || y_rank == Y5_RANK))
+  for (bitboard::bitboard_type rooks =
+           own_pieces[static_cast<uint8_t>(PieceType::ROOK)];
+       rooks != 0;)
   {
-    eval += MEDIUM_EVAL_VALUE;
+    int square = bitboard::pop_lowest_square(rooks);
+    int x_file = square % BOARD_WIDTH;
+    int y_rank = square / BOARD_WIDTH;
+    evaluate_rook<piece_color>(x_file, y_rank,
+                               *board_state.chess_board[x_file][y_rank], eval,
+                               board_state, attack_sets);
+  }
+
+  for (bitboard::bitboard_type queens =
+           own_pieces[static_cast<uint8_t>(PieceType::QUEEN)];
+       queens != 0;)
+  {
+    int square = bitboard::pop_lowest_square(queens);
+    int x_file = square % BOARD_WIDTH;
+    int y_rank = square / BOARD_WIDTH;
+    evaluate_queen<piece_color>(x_file, y_rank, eval, board_state,
+                                attack_sets);
+  }
+
+  for (bitboard::bitboard_type kings =
+           own_pieces[static_cast<uint8_t>(PieceType::KING)];
+       kings != 0;)
+  {
+    int square = bitboard::pop_lowest_square(kings);
+    int x_file = square % BOARD_WIDTH;
+    int y_rank = square / BOARD_WIDTH;
+    evaluate_king<piece_color>(x_file, y_rank, eval, board_state,
+                               attack_sets);
   }
 
-  evaluate_pawn_file_quality(x_file, y_rank, pawn_piece, eval, board_state);
+  // Pieces the enemy attacks that no own piece defends are hanging.
+  bitboard::bitboard_type hanging_pieces =
+      attack_sets.hangable_pieces[static_cast<uint8_t>(piece_color)] &
+      attack_sets.attacks[static_cast<uint8_t>(
+          OPPOSITE_COLOR<piece_color>)] &
+      ~attack_sets.attacks[static_cast<uint8_t>(piece_color)];
+  eval -= std::popcount(hanging_pieces) * SMALL_EVAL_VALUE;
+  return eval;
 }
 
-void evaluate_pawn_file_quality(int x_file,
-                                int y_rank,
-                                const Piece &pawn_piece,
-                                int &eval,
-                                const BoardState &board_state)
+auto compute_attack_sets(const BoardState &board_state,
+                         const PawnHashEntry &pawn_entry) -> AttackSets
 {
-  int direction;
-  if (pawn_piece.piece_color == PieceColor::WHITE)
+  AttackSets attack_sets;
+  attack_sets.occupied = board_state.occupied;
+  for (int color_index = 0; color_index < NUM_OF_COLORS; ++color_index)
   {
-    direction = POSITIVE_DIRECTION;
+    const auto &color_piece_bitboards =
+        board_state.piece_bitboards[color_index];
+    attack_sets.hangable_pieces[color_index] =
+        board_state.color_bitboards[color_index] &
+        ~(color_piece_bitboards[static_cast<uint8_t>(PieceType::PAWN)] |
+          color_piece_bitboards[static_cast<uint8_t>(PieceType::KING)]);
   }
-  else
+
+  // The incrementally updated tables already hold every piece's attacks,
+  // including the pawns'.
+  if (board_state.attack_tables_are_enabled())
   {
-    direction = NEGATIVE_DIRECTION;
+    attack_sets.attacks = board_state.color_attacks;
+    attack_sets.piece_attacks = board_state.square_attacks;
+    return attack_sets;
   }
 
-  bool is_passed_pawn = true;
-  for (int current_rank = y_rank + direction;
-       current_rank <= Y_MAX && current_rank >= Y_MIN;
-       current_rank += direction)
+  attack_sets.attacks = pawn_entry.pawn_attacks;
+  for (int color_index = 0; color_index < NUM_OF_COLORS; ++color_index)
   {
-    Piece &piece = *board_state.chess_board[x_file][current_rank];
-
-    // Decrease evaluation if there is a pawn in front of the pawn. This
-    // will also cover doubled pawns.
-    if (piece.piece_type == PieceType::PAWN &&
-        piece.piece_color == pawn_piece.piece_color)
+    // Pawn attacks come from the pawn hash entry.
+    for (bitboard::bitboard_type remaining_pieces =
+             board_state.color_bitboards[color_index] &
+             ~board_state.piece_bitboards[color_index][static_cast<uint8_t>(
+                 PieceType::PAWN)];
+         remaining_pieces != 0; remaining_pieces &= remaining_pieces - 1)
     {
-      eval -= MEDIUM_EVAL_VALUE;
+      int square = std::countr_zero(remaining_pieces);
+      bitboard::bitboard_type &piece_attacks =
+          attack_sets.piece_attacks[square];
+      switch (board_state
+                  .chess_board[square % BOARD_WIDTH][square / BOARD_WIDTH]
+                  ->piece_type)
+      {
+      case PieceType::KNIGHT:
+        piece_attacks = bitboard::KNIGHT_ATTACKS[square];
+        break;
+      case PieceType::BISHOP:
+        piece_attacks = bitboard::bishop_attacks(square, attack_sets.occupied);
+        break;
+      case PieceType::ROOK:
+        piece_attacks = bitboard::rook_attacks(square, attack_sets.occupied);
+        break;
+      case PieceType::QUEEN:
+        piece_attacks = bitboard::bishop_attacks(square, attack_sets.occupied) |
+                        bitboard::rook_attacks(square, attack_sets.occupied);
+        break;
+      default:
+        piece_attacks = bitboard::KING_ATTACKS[square];
+        break;
+      }
+      attack_sets.attacks[color_index] |= piece_attacks;
     }
+  }
+  return attack_sets;
+}
 
-    // If there is an enemy pawn in front of the pawn, it is not a passed
-    // pawn.
-    if (is_passed_pawn && piece.piece_color != pawn_piece.piece_color)
-    {
-      is_passed_pawn = false;
-    }
+auto evaluate_pawn_structure(const BoardState &board_state) -> PawnHashEntry
+{
+  const auto white_index = static_cast<uint8_t>(PieceColor::WHITE);
+  const auto black_index = static_cast<uint8_t>(PieceColor::BLACK);
+  const auto pawn_index = static_cast<uint8_t>(PieceType::PAWN);
+  const std::array<bitboard::bitboard_type, NUM_OF_COLORS> pawns = {
+      board_state.piece_bitboards[white_index][pawn_index],
+      board_state.piece_bitboards[black_index][pawn_index]};
+
+  PawnHashEntry entry;
+  entry.pawn_hash = board_state.pawn_hash;
+  evaluate_pawns<PieceColor::WHITE>(pawns[white_index], pawns[black_index],
+                                    entry);
+  evaluate_pawns<PieceColor::BLACK>(pawns[black_index], pawns[white_index],
+                                    entry);
+  return entry;
+}
+
+template <PieceColor piece_color>
+void evaluate_pawns(bitboard::bitboard_type own_pawns,
+                    bitboard::bitboard_type enemy_pawns,
+                    PawnHashEntry &entry)
+{
+  constexpr int direction = PAWN_DIRECTION<piece_color>;
+  const auto color_index = static_cast<uint8_t>(piece_color);
+
+  int eval = 0;
+  for (bitboard::bitboard_type remaining_pawns = own_pawns;
+       remaining_pawns != 0; remaining_pawns &= remaining_pawns - 1)
+  {
+    int square = std::countr_zero(remaining_pawns);
+    int x_file = square % BOARD_WIDTH;
+    int y_rank = square / BOARD_WIDTH;
 
-    if (!is_passed_pawn)
+    // Squares the pawn attacks.
+    int attack_rank = y_rank + direction;
+    for (int side_count = -1; side_count <= 1; side_count += 2)
     {
-      // If we know it is not a passed pawn, we no longer need to check for side
-      // pawns.
-      continue;
+      int attack_file = x_file + side_count;
+      if (attack_file >= X_MIN && attack_file <= X_MAX &&
+          attack_rank >= Y_MIN && attack_rank <= Y_MAX)
+      {
+        entry.pawn_attacks[color_index] |=
+            bitboard::square_bit(attack_file, attack_rank);
+      }
     }
 
-    // Check side pawns. If there are any, it is not a passed pawn.
-    for (int side_count = -1; side_count <= 1; side_count += 2)
+    bool is_passed_pawn = true;
+    for (int current_rank = y_rank + direction;
+         current_rank <= Y_MAX && current_rank >= Y_MIN;
+         current_rank += direction)
     {
-      // Check if the side pawn is in bounds.
-      if (x_file + side_count < X_MIN || x_file + side_count > X_MAX)
+      // Decrease evaluation if there is a pawn in front of the pawn. This
+      // will also cover doubled pawns.
+      if (bitboard::contains(own_pawns, x_file, current_rank))
       {
-        continue;
+        eval -= MEDIUM_EVAL_VALUE;
       }
 
-      Piece &side_piece =
-          *board_state.chess_board[x_file + side_count][current_rank];
-      if (side_piece.piece_type == PieceType::PAWN &&
-          side_piece.piece_color != pawn_piece.piece_color)
+      // If there is an enemy pawn in front of the pawn, or on a side file in
+      // front of it, it is not a passed pawn.
+      for (int side_count = -1; side_count <= 1; ++side_count)
       {
-        is_passed_pawn = false;
+        int current_file = x_file + side_count;
+        if (current_file >= X_MIN && current_file <= X_MAX &&
+            bitboard::contains(enemy_pawns, current_file, current_rank))
+        {
+          is_passed_pawn = false;
+        }
       }
     }
-  }
 
-  if (is_passed_pawn)
-  {
-    eval += MEDIUM_EVAL_VALUE;
+    if (is_passed_pawn)
+    {
+      eval += MEDIUM_EVAL_VALUE;
+      entry.passed_pawns[color_index] |= bitboard::square_bit(x_file, y_rank);
+    }
   }
+
+  // Entry scores are from white's perspective.
+  entry.score += (piece_color == PieceColor::WHITE) ? eval : -eval;
 }
 
+template <PieceColor piece_color>
 void evaluate_knight(const int x_file,
                      const int y_rank,
                      const Piece &knight_piece,
                      int &eval,
                      const BoardState &board_state)
 {
-  // Piece value.
-  eval += KNIGHT_VALUE;
-
   // Less value if knight has moved. Development is important.
   if (!knight_piece.piece_has_moved)
   {
     eval -= MEDIUM_EVAL_VALUE;
   }
 
-  // Check how many attacks the knight has. The more attacks, the better.
-  for (const auto &direction : KNIGHT_MOVES)
-  {
-    int new_x = x_file + direction[0];
-    int new_y = y_rank + direction[1];
-
-    // Check if still within bounds.
-    if (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN && new_y <= Y_MAX)
-    {
-      eval += KNIGHT_POSITION_EVAL_MAP[new_y];
-      eval += KNIGHT_POSITION_EVAL_MAP[new_x];
-    }
-    else
-    {
-      eval -= SMALL_EVAL_VALUE;
-    }
-  }
-
   // The closer a knight is to the enemy king, the better.
   // We check the knight's distance to the enemy king.
   int enemy_king_x;
   int enemy_king_y;
-  if (knight_piece.piece_color == PieceColor::WHITE)
+  if constexpr (piece_color == PieceColor::WHITE)
   {
     enemy_king_x = board_state.black_king_x_file;
     enemy_king_y = board_state.black_king_y_rank;
@@ -269,52 +344,23 @@ void evaluate_knight(const int x_file,
   }
 }
 
+template <PieceColor piece_color>
 void evaluate_bishop(const int x_file,
                      const int y_rank,
                      const Piece &bishop_piece,
                      int &eval,
-                     const BoardState &board_state)
+                     const BoardState &board_state,
+                     const AttackSets &attack_sets)
 {
-  // Piece value.
-  eval += BISHOP_VALUE;
   if (!bishop_piece.piece_has_moved)
   {
     eval -= MEDIUM_EVAL_VALUE;
   }
 
-  // We don't generally want bishops on the back rank. We want them to be
-  // developed. So we give a penalty if they are on the back rank. But not in
-  // the end game.
-  if (!board_state.is_end_game)
-  {
-    if (bishop_piece.piece_color == PieceColor::WHITE)
-    {
-      if (y_rank == Y1_RANK)
-      {
-        eval -= LARGE_EVAL_VALUE;
-      }
-    }
-    else
-    {
-      if (y_rank == Y8_RANK)
-      {
-        eval -= LARGE_EVAL_VALUE;
-      }
-    }
-  }
-
   // If bishop is blocking a pawn, decrease evaluation.
   // When I play, I don't like it when my bishops block my pawns.
   // This is a personal preference and is experimental.
-  int direction;
-  if (bishop_piece.piece_color == PieceColor::WHITE)
-  {
-    direction = POSITIVE_DIRECTION;
-  }
-  else
-  {
-    direction = NEGATIVE_DIRECTION;
-  }
+  constexpr int direction = PAWN_DIRECTION<piece_color>;
   if (y_rank - direction >= Y_MIN && y_rank - direction <= Y_MAX)
   {
     if (board_state.chess_board[x_file][y_rank - direction]->piece_type ==
@@ -325,106 +371,48 @@ void evaluate_bishop(const int x_file,
   }
 
   // The more moves a bishop has, the better.
-  int new_x;
-  int new_y;
-  for (const auto &direction : BISHOP_DIRECTIONS)
-  {
-    // Increase evaluation based on the number of moves.
-    new_x = x_file + direction[0];
-    new_y = y_rank + direction[1];
-
-    // Check if still within bounds.
-    while (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN && new_y <= Y_MAX)
-    {
-      if (board_state.chess_board[new_x][new_y]->piece_type != PieceType::EMPTY)
-      {
-        break;
-      }
-
-      eval += EXTREMELY_SMALL_EVAL_VALUE;
-
-      new_x += direction[0];
-      new_y += direction[1];
-    }
-  }
+  bitboard::bitboard_type moves =
+      attack_sets.piece_attacks[(y_rank * BOARD_WIDTH) + x_file] &
+      ~attack_sets.occupied;
+  eval += std::popcount(moves) * EXTREMELY_SMALL_EVAL_VALUE;
 }
 
+template <PieceColor piece_color>
 void evaluate_rook(const int x_file,
                    const int y_rank,
                    const Piece &rook_piece,
                    int &eval,
-                   const BoardState &board_state)
+                   const BoardState &board_state,
+                   const AttackSets &attack_sets)
 {
-  // Piece value.
-  eval += ROOK_VALUE;
-
   if (board_state.is_end_game)
   {
     // The more moves a rook has, the better.
-    int new_x;
-    int new_y;
-    for (const auto &direction : ROOK_DIRECTIONS)
-    {
-      // Increase evaluation based on the number of moves.
-      new_x = x_file + direction[0];
-      new_y = y_rank + direction[1];
-
-      // Check if still within bounds.
-      while (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN &&
-             new_y <= Y_MAX)
-      {
-        if (board_state.chess_board[new_x][new_y]->piece_type !=
-            PieceType::EMPTY)
-        {
-          break;
-        }
-
-        eval += EXTREMELY_SMALL_EVAL_VALUE;
-
-        new_x += direction[0];
-        new_y += direction[1];
-      }
-    }
+    bitboard::bitboard_type moves =
+        attack_sets.piece_attacks[(y_rank * BOARD_WIDTH) + x_file] &
+        ~attack_sets.occupied;
+    eval += std::popcount(moves) * EXTREMELY_SMALL_EVAL_VALUE;
   }
 }
 
+template <PieceColor piece_color>
 void evaluate_queen(const int x_file,
                     const int y_rank,
-                    const Piece &queen_piece,
                     int &eval,
-                    const BoardState &board_state)
+                    const BoardState &board_state,
+                    const AttackSets &attack_sets)
 {
-  // Piece value.
-  eval += QUEEN_VALUE;
-
   // The more moves a queen has, the better.
-  int new_x;
-  int new_y;
-  for (const auto &direction : QUEEN_DIRECTIONS)
-  {
-    // Increase evaluation based on the number of moves.
-    new_x = x_file + direction[0];
-    new_y = y_rank + direction[1];
-
-    // Check if still within bounds.
-    while (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN && new_y <= Y_MAX)
-    {
-      if (board_state.chess_board[new_x][new_y]->piece_type != PieceType::EMPTY)
-      {
-        break;
-      }
-
-      eval += EXTREMELY_SMALL_EVAL_VALUE;
+  bitboard::bitboard_type moves =
+      attack_sets.piece_attacks[(y_rank * BOARD_WIDTH) + x_file] &
+      ~attack_sets.occupied;
+  eval += std::popcount(moves) * EXTREMELY_SMALL_EVAL_VALUE;
 
-      new_x += direction[0];
-      new_y += direction[1];
-    }
-  }
   // The closer a queen is to the enemy king, the better.
   // We check the queen's distance to the enemy king.
   int enemy_king_x;
   int enemy_king_y;
-  if (queen_piece.piece_color == PieceColor::WHITE)
+  if constexpr (piece_color == PieceColor::WHITE)
   {
     enemy_king_x = board_state.black_king_x_file;
     enemy_king_y = board_state.black_king_y_rank;
@@ -443,77 +431,56 @@ void evaluate_queen(const int x_file,
   }
 }
 
+template <PieceColor piece_color>
 void evaluate_king(const int x_file,
                    const int y_rank,
-                   const Piece &king_piece,
                    int &eval,
-                   const BoardState &board_state)
+                   const BoardState &board_state,
+                   const AttackSets &attack_sets)
 {
-  // Piece value.
-  eval += KING_VALUE;
-
   if (!board_state.is_end_game)
   {
     // Give eval points if the king has castled, but not in the end game where
     // it doesn't matter anymore.
-    if ((king_piece.piece_color == PieceColor::WHITE &&
-         board_state.white_has_castled) ||
-        (king_piece.piece_color == PieceColor::BLACK &&
-         board_state.black_has_castled))
+    bool has_castled = (piece_color == PieceColor::WHITE)
+                           ? board_state.white_has_castled
+                           : board_state.black_has_castled;
+    if (has_castled)
     {
       eval += LARGE_EVAL_VALUE;
     }
   }
 
-  // Position value - x coordinate.
   if (!board_state.is_end_game)
   {
-    evaluate_king_safety(x_file, y_rank, king_piece, eval, board_state);
-
-    // Give points if the king is far away from the center of the board.
-    // But not in the end game where it king needs to be active.
-    eval += KING_POSITION_EVAL_MAP[x_file];
+    evaluate_king_safety<piece_color>(x_file, y_rank, eval, attack_sets);
   }
 }
 
+template <PieceColor piece_color>
 void evaluate_king_safety(const int x_file,
                           const int y_rank,
-                          const Piece &king_piece,
                           int &eval,
-                          const BoardState &board_state)
+                          const AttackSets &attack_sets)
 {
-  {
-    int new_x;
-    int new_y;
-    // King has same directions as queen.
-    for (const auto &direction : QUEEN_DIRECTIONS)
-    {
-      if (direction[1] == 0)
-      {
-        // Skip horizontal moves.
-        // This allows the rook, when castled, to move freely in the back rank.
-        continue;
-      }
-
-      new_x = x_file + direction[0];
-      new_y = y_rank + direction[1];
-      while (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN &&
-             new_y <= Y_MAX)
-      {
-        // Decrease evaluation based on the number of moves as it means king
-        // is less safe.
-        if (board_state.chess_board[new_x][new_y]->piece_type !=
-            PieceType::EMPTY)
-        {
-          break;
-        }
-
-        eval -= SMALL_EVAL_VALUE;
-
-        new_x += direction[0];
-        new_y += direction[1];
-      }
-    }
-  }
+  const int square = (y_rank * BOARD_WIDTH) + x_file;
+
+  // Decrease evaluation based on the number of moves a queen would have from
+  // the king's square as it means king is less safe. Horizontal moves are
+  // skipped. This allows the rook, when castled, to move freely in the back
+  // rank.
+  bitboard::bitboard_type open_lines =
+      bitboard::bishop_attacks(square, attack_sets.occupied) |
+      bitboard::line_attacks(bitboard::FILE_LINE_MASKS[square], square,
+                             attack_sets.occupied);
+  eval -= std::popcount(open_lines & ~attack_sets.occupied) * SMALL_EVAL_VALUE;
+
+  // Decrease evaluation for every square around the king the enemy attacks.
+  bitboard::bitboard_type king_zone =
+      bitboard::KING_ATTACKS[square] | bitboard::square_bit(x_file, y_rank);
+  eval -= std::popcount(king_zone &
+                        attack_sets.attacks[static_cast<uint8_t>(
+                            OPPOSITE_COLOR<piece_color>)]) *
+          VERY_SMALL_EVAL_VALUE;
 }
 } // namespace engine::parts::position_evaluator
@@ -1,68 +1,161 @@
 #ifndef POSITION_EVALUATOR_H
 #define POSITION_EVALUATOR_H
 
+#include "bitboard.h"
 #include "board_state.h"
+#include "pawn_hash_table.h"
 
 /**
  * @brief Namespace for position evaluator functions.
  */
 namespace engine::parts::position_evaluator
 {
+/**
+ * @brief Attack sets of both colors, computed once per evaluation and shared
+ * by the mobility, king safety and hanging piece terms.
+ */
+struct AttackSets
+{
+  // PROPERTIES
+
+  /// @brief All pieces on the board.
+  bitboard::bitboard_type occupied = 0;
+
+  /// @brief Knights, bishops, rooks and queens of each color, the pieces that
+  /// can be left hanging.
+  std::array<bitboard::bitboard_type, NUM_OF_COLORS> hangable_pieces{};
+
+  /// @brief Squares attacked by each color, including pawn and king attacks.
+  std::array<bitboard::bitboard_type, NUM_OF_COLORS> attacks{};
+
+  /// @brief Squares attacked by the knight, bishop, rook, queen or king on
+  /// each square.
+  bitboard::square_table_type piece_attacks{};
+};
 
 /**
  * @brief Evaluates the current position using chess heuristics.
  *
+ * @details Material and piece-square terms come from the incrementally
+ * updated BoardState::piece_square_scores. The per-piece evaluators only add
+ * the terms that depend on other pieces or on piece state. The pawn structure
+ * only depends on the pawns, so it is cached in the pawn hash table when one is
+ * given.
+ *
  * @note Positive score is good for white, negative score is good for black, and
  * 0 means the position is equal.
  *
  * @param board_state BoardState object to evaluate.
+ * @param pawn_hash_table Pawn hash table of the calling thread, or nullptr to
+ * always evaluate the pawn structure.
  *
  * @return Score of the given position.
  */
-auto evaluate_position(const BoardState &board_state) -> int;
+auto evaluate_position(const BoardState &board_state,
+                       PawnHashTable *pawn_hash_table = nullptr) -> int;
 
 /**
- * @brief Evaluates a pawn at the given position.
+ * @brief Evaluates the current position in two stages, skipping the expensive
+ * terms when the position is clearly outside the alpha beta window.
+ *
+ * @details The first stage is the material and piece-square score, which
+ * BoardState keeps up to date. If it is more than lazy_eval_margin above beta
+ * or below alpha, the remaining terms are assumed unable to bring it back into
+ * the window and the first stage score is returned. Otherwise the position is
+ * fully evaluated with evaluate_position.
  *
- * @param x_file The x-coordinate (file) of the pawn.
- * @param y_rank The y-coordinate (rank) of the pawn.
- * @param pawn_piece The pawn piece object to evaluate.
- * @param eval Reference to the evaluation score to update.
  * @param board_state BoardState object to evaluate.
+ * @param alpha Alpha of the node, from the perspective of the side to move.
+ * @param beta Beta of the node, from the perspective of the side to move.
+ * @param lazy_eval_margin Margin outside the window to return early at.
+ * @param pawn_hash_table Pawn hash table of the calling thread, or nullptr to
+ * always evaluate the pawn structure.
+ * @param is_lazy Set to true if the first stage score was returned, false
+ * otherwise.
+ *
+ * @return Score of the given position, from the perspective of the side to
+ * move.
  */
-static void evaluate_pawn(int x_file,
-                          int y_rank,
-                          const Piece &pawn_piece,
-                          int &eval,
-                          const BoardState &board_state);
+auto evaluate_position_lazily(const BoardState &board_state,
+                              int alpha,
+                              int beta,
+                              int lazy_eval_margin,
+                              PawnHashTable *pawn_hash_table,
+                              bool &is_lazy) -> int;
 
 /**
- * @brief Evaluates the quality of a pawn's file.
+ * @brief Evaluates all live pieces of the given color.
  *
- * @details This function evaluates if the is a double pawn or if the pawn is a
- * passed pawn.
+ * @details Also gives a penalty for every hanging piece, a piece the enemy
+ * attacks that no own piece or pawn defends.
+ *
+ * @tparam piece_color Color of the pieces to evaluate.
  *
- * @param x_file The x-coordinate (file) of the pawn.
- * @param y_rank The y-coordinate (rank) of the pawn.
- * @param pawn_piece The pawn piece object to evaluate.
- * @param eval Reference to the evaluation score to update.
  * @param board_state BoardState object to evaluate.
+ * @param attack_sets Attack sets of the position.
+ *
+ * @return Score of the given color's pieces, positive is good for that color.
+ */
+template <PieceColor piece_color>
+static auto evaluate_pieces(const BoardState &board_state,
+                            const AttackSets &attack_sets) -> int;
+
+/**
+ * @brief Computes the attack sets of both colors.
+ *
+ * @details Copies the board's attack tables when they are enabled, otherwise
+ * computes the piece attacks from the board's bitboards.
+ *
+ * @param board_state BoardState object to evaluate.
+ * @param pawn_entry Pawn hash entry of the position, for the pawn attacks.
+ *
+ * @return Attack sets of the position.
  */
-static void evaluate_pawn_file_quality(int x_file,
-                                       int y_rank,
-                                       const Piece &pawn_piece,
-                                       int &eval,
-                                       const BoardState &board_state);
+static auto compute_attack_sets(const BoardState &board_state,
+                                const PawnHashEntry &pawn_entry) -> AttackSets;
+
+/**
+ * @brief Evaluates the pawn structure of both colors.
+ *
+ * @details Only reads the pawns, so the result can be cached by pawn hash.
+ *
+ * @param board_state BoardState object to evaluate.
+ *
+ * @return Pawn hash entry with the score and the pawn masks.
+ */
+static auto evaluate_pawn_structure(const BoardState &board_state)
+    -> PawnHashEntry;
+
+/**
+ * @brief Evaluates the pawns of the given color.
+ *
+ * @details Gives a penalty for every own pawn in front of a pawn (doubled
+ * pawns) and a bonus for passed pawns, and records the squares the pawns
+ * attack and the passed pawns in the entry.
+ *
+ * @tparam piece_color Color of the pawns being evaluated.
+ *
+ * @param own_pawns Pawns of the color being evaluated.
+ * @param enemy_pawns Pawns of the other color.
+ * @param entry Pawn hash entry to update.
+ */
+template <PieceColor piece_color>
+static void evaluate_pawns(bitboard::bitboard_type own_pawns,
+                           bitboard::bitboard_type enemy_pawns,
+                           PawnHashEntry &entry);
 
 /**
  * @brief Evaluates a knight at the given position.
  *
+ * @tparam piece_color Color of the piece being evaluated.
+ *
  * @param x_file The x-coordinate (file) of the knight.
  * @param y_rank The y-coordinate (rank) of the knight.
  * @param knight_piece The knight piece object to evaluate.
  * @param eval Reference to the evaluation score to update.
  * @param board_state BoardState object to evaluate.
  */
+template <PieceColor piece_color>
 static void evaluate_knight(int x_file,
                             int y_rank,
                             const Piece &knight_piece,
@@ -72,77 +165,97 @@ static void evaluate_knight(int x_file,
 /**
  * @brief Evaluates a bishop at the given position.
  *
+ * @tparam piece_color Color of the piece being evaluated.
+ *
  * @param x_file The x-coordinate (file) of the bishop.
  * @param y_rank The y-coordinate (rank) of the bishop.
  * @param bishop_piece The bishop piece object to evaluate.
  * @param eval Reference to the evaluation score to update.
  * @param board_state BoardState object to evaluate.
+ * @param attack_sets Attack sets of the position.
  */
+template <PieceColor piece_color>
 static void evaluate_bishop(int x_file,
                             int y_rank,
                             const Piece &bishop_piece,
                             int &eval,
-                            const BoardState &board_state);
+                            const BoardState &board_state,
+                            const AttackSets &attack_sets);
 
 /**
  * @brief Evaluates a rook at the given position.
  *
+ * @tparam piece_color Color of the piece being evaluated.
+ *
  * @param x_file The x-coordinate (file) of the rook.
  * @param y_rank The y-coordinate (rank) of the rook.
  * @param rook_piece The rook piece object to evaluate.
  * @param eval Reference to the evaluation score to update.
  * @param board_state BoardState object to evaluate.
+ * @param attack_sets Attack sets of the position.
  */
+template <PieceColor piece_color>
 static void evaluate_rook(int x_file,
                           int y_rank,
                           const Piece &rook_piece,
                           int &eval,
-                          const BoardState &board_state);
+                          const BoardState &board_state,
+                          const AttackSets &attack_sets);
 
 /**
  * @brief Evaluates a queen at the given position.
  *
+ * @tparam piece_color Color of the piece being evaluated.
+ *
  * @param x_file The x-coordinate (file) of the queen.
  * @param y_rank The y-coordinate (rank) of the queen.
- * @param queen_piece The queen piece object to evaluate.
  * @param eval Reference to the evaluation score to update.
  * @param board_state BoardState object to evaluate.
+ * @param attack_sets Attack sets of the position.
  */
+template <PieceColor piece_color>
 static void evaluate_queen(int x_file,
                            int y_rank,
-                           const Piece &queen_piece,
                            int &eval,
-                           const BoardState &board_state);
+                           const BoardState &board_state,
+                           const AttackSets &attack_sets);
 
 /**
  * @brief Evaluates a king at the given position.
  *
+ * @tparam piece_color Color of the piece being evaluated.
+ *
  * @param x_file The x-coordinate (file) of the king.
  * @param y_rank The y-coordinate (rank) of the king.
- * @param king_piece The king piece object to evaluate.
  * @param eval Reference to the evaluation score to update.
  * @param board_state BoardState object to evaluate.
+ * @param attack_sets Attack sets of the position.
  */
+template <PieceColor piece_color>
 static void evaluate_king(int x_file,
                           int y_rank,
-                          const Piece &king_piece,
                           int &eval,
-                          const BoardState &board_state);
+                          const BoardState &board_state,
+                          const AttackSets &attack_sets);
 
 /**
  * @brief Evaluates the safety of a king at the given position.
  *
+ * @details Gives a penalty for every open square on the king's file and
+ * diagonals, and for every square around the king the enemy attacks.
+ *
+ * @tparam piece_color Color of the piece being evaluated.
+ *
  * @param x_file The x-coordinate (file) of the king.
  * @param y_rank The y-coordinate (rank) of the king.
- * @param king_piece The king piece object to evaluate.
  * @param eval Reference to the evaluation score to update.
- * @param board_state BoardState object to evaluate.
+ * @param attack_sets Attack sets of the position.
  */
+template <PieceColor piece_color>
 static void evaluate_king_safety(int x_file,
                                  int y_rank,
-                                 const Piece &king_piece,
                                  int &eval,
-                                 const BoardState &board_state);
+                                 const AttackSets &attack_sets);
 } // namespace engine::parts::position_evaluator
 
 #endif // POSITION_EVALUATOR_H
@@ -2,10 +2,12 @@
 #include "attack_check.h"
 #include "board_state.h"
 #include "engine_constants.h"
+#include "fen_interface.h"
 #include "move_generator.h"
 #include "move_interface.h"
 #include "node_context.h"
 #include "position_evaluator.h"
+#include "static_exchange.h"
 
 #include <algorithm>
 #include <cmath>
@@ -17,8 +19,11 @@ namespace engine::parts
 
 SearchEngine::SearchEngine(BoardState &board_state, bool is_uci)
     : game_board_state(board_state),
-      transposition_table(MAX_TRANSPOSITION_TABLE_SIZE), is_uci(is_uci)
+      transposition_table(MAX_TRANSPOSITION_TABLE_SIZE),
+      eval_cache(EVAL_CACHE_SIZE), is_uci(is_uci)
 {
+  set_search_thread_count(
+      static_cast<int>(std::thread::hardware_concurrency()));
 } // Initialize with a max size
 
 // PUBLIC FUNCTIONS
@@ -29,7 +34,9 @@ void SearchEngine::start_engine_search()
   {
     return;
   }
-  search_thread_handler.start_thread(max_search_time_milliseconds);
+  // A deterministic search must not depend on the clock.
+  search_thread_handler.start_thread(
+      deterministic_search ? INF : max_search_time_milliseconds);
 }
 
 void SearchEngine::stop_engine_search() { search_thread_handler.stop_thread(); }
@@ -42,7 +49,8 @@ auto SearchEngine::wait_for_search_and_get_best_move() -> std::string
 
 void SearchEngine::start_engine_pondering()
 {
-  if (engine_is_pondering)
+  // Pondering changes the tables the next search starts from.
+  if (engine_is_pondering || deterministic_search)
   {
     return;
   }
@@ -88,11 +96,139 @@ auto SearchEngine::engine_is_searching() -> bool
 
 void SearchEngine::clear_transposition_table() { transposition_table.clear(); }
 
+void SearchEngine::clear_eval_cache() { eval_cache.clear(); }
+
+auto SearchEngine::run_bench(int depth) -> size_t
+{
+  bool previous_show_performance = show_performance;
+  int previous_max_search_depth = max_search_depth;
+  size_t previous_max_search_nodes = max_search_nodes;
+  show_performance = false;
+  max_search_depth = depth;
+  max_search_nodes = 0;
+
+  // Start from empty tables so the node count only depends on the positions
+  // and the depth.
+  clear_search_tables();
+  // A stopped search leaves the counters of its last iteration behind.
+  thread_counters[0].nodes_visited = 0;
+
+  size_t total_nodes = 0;
+  auto start_time = std::chrono::steady_clock::now();
+  for (size_t position_index = 0; position_index < BENCH_POSITIONS.size();
+       ++position_index)
+  {
+    BoardState board_state;
+    fen_interface::setup_custom_board(board_state,
+                                      BENCH_POSITIONS[position_index]);
+    board_state.set_attack_tables_enabled(
+        game_board_state.attack_tables_are_enabled());
+    board_state.set_nnue_network(game_board_state.nnue_network);
+
+    // Killer moves are only relevant to the position being searched.
+    killer_tables[0] = {};
+    completed_iteration_nodes = 0;
+    running_search_flag = true;
+    (void)run_iterative_deepening_search(0, board_state);
+    running_search_flag = false;
+
+    printf("Position %zu/%zu: %zu nodes\n", position_index + 1,
+           BENCH_POSITIONS.size(), completed_iteration_nodes);
+    total_nodes += completed_iteration_nodes;
+  }
+  auto elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - start_time)
+                          .count();
+
+  printf("Nodes: %zu, Time: %lld ms, NPS: %lld\n", total_nodes,
+         static_cast<long long>(elapsed_time),
+         static_cast<long long>(total_nodes * 1000 / (elapsed_time + 1)));
+
+  show_performance = previous_show_performance;
+  max_search_depth = previous_max_search_depth;
+  max_search_nodes = previous_max_search_nodes;
+  return total_nodes;
+}
+
+auto SearchEngine::search_to_depth(int depth, size_t &nodes) -> std::string
+{
+  int previous_max_search_depth = max_search_depth;
+  size_t previous_max_search_nodes = max_search_nodes;
+  max_search_depth = depth;
+  max_search_nodes = 0;
+  completed_iteration_nodes_all_threads = 0;
+
+  running_search_flag = true;
+  std::vector<std::pair<Move, int>> move_scores =
+      run_lazy_smp_search(game_board_state);
+  running_search_flag = false;
+
+  // Helper threads keep counting after the main thread's last iteration.
+  nodes = completed_iteration_nodes_all_threads;
+  for (auto &counters : thread_counters)
+  {
+    nodes += counters.nodes_visited.exchange(0);
+  }
+
+  max_search_depth = previous_max_search_depth;
+  max_search_nodes = previous_max_search_nodes;
+  if (move_scores.empty())
+  {
+    return "";
+  }
+  std::vector<Move> possible_moves = move_generator::calculate_possible_moves(
+      game_board_state, false, nullptr, false);
+  return move_interface::move_to_string(
+      possible_moves[move_scores[0].first.list_index]);
+}
+
+void SearchEngine::clear_search_tables()
+{
+  clear_transposition_table();
+  clear_eval_cache();
+  history_tables = {};
+  killer_tables = {};
+  counter_move_tables = {};
+}
+
+void SearchEngine::set_search_thread_count(int thread_count)
+{
+  num_of_search_threads = std::clamp(thread_count, 1, MAX_SEARCH_THREADS);
+}
+
+auto SearchEngine::search_thread_count() const -> int
+{
+  return deterministic_search ? 1 : num_of_search_threads;
+}
+
+auto SearchEngine::set_search_stats_output(const std::string &destination)
+    -> bool
+{
+  search_stats_file.reset();
+  search_stats_to_stderr = false;
+  if constexpr (!SEARCH_STATS_ENABLED)
+  {
+    return destination.empty();
+  }
+
+  if (destination == "stderr")
+  {
+    search_stats_to_stderr = true;
+  }
+  else if (!destination.empty())
+  {
+    search_stats_file.reset(fopen(destination.c_str(), "a"));
+    return search_stats_file != nullptr;
+  }
+  return true;
+}
+
 // PRIVATE FUNCTIONS
 
 auto SearchEngine::search_and_execute_best_move() -> bool
 {
-  std::vector<std::pair<Move, int>> move_scores = run_lazy_smp_search();
+  std::vector<std::pair<Move, int>> move_scores =
+      run_lazy_smp_search(game_board_state);
   std::vector<Move> possible_moves = move_generator::calculate_possible_moves(
       game_board_state, false, nullptr, false);
 
@@ -155,13 +291,25 @@ auto SearchEngine::search_and_execute_best_move() -> bool
   return true;
 }
 
-auto SearchEngine::run_lazy_smp_search() -> std::vector<std::pair<Move, int>>
+auto SearchEngine::run_lazy_smp_search(const BoardState &board_state)
+    -> std::vector<std::pair<Move, int>>
 {
   std::vector<std::pair<Move, int>> move_scores;
 
   std::vector<std::thread> search_threads;
-  std::vector<BoardState> thread_board_states(MAX_SEARCH_THREADS,
-                                              BoardState(game_board_state));
+  int thread_count = search_thread_count();
+  std::vector<BoardState> thread_board_states(thread_count,
+                                              BoardState(board_state));
+
+  // A stopped search leaves the counters of its last iteration behind.
+  reset_thread_counters();
+  search_start_nodes = completed_iteration_nodes;
+
+  // Killer moves are only relevant to the position being searched.
+  for (auto &killer_table : killer_tables)
+  {
+    killer_table = {};
+  }
 
   // Start main thread.
   search_threads.emplace_back(
@@ -170,7 +318,7 @@ auto SearchEngine::run_lazy_smp_search() -> std::vector<std::pair<Move, int>>
       });
 
   // Start helper threads.
-  for (int thread_index = 1; thread_index < MAX_SEARCH_THREADS; ++thread_index)
+  for (int thread_index = 1; thread_index < thread_count; ++thread_index)
   {
     BoardState &thread_board_state = thread_board_states[thread_index];
     {
@@ -206,9 +354,18 @@ auto SearchEngine::run_iterative_deepening_search(int thread_index,
   std::vector<std::pair<Move, int>> final_move_scores;
   int iterative_depth_start = 1;
 
+  // Only the main thread's counters are reported, so only it is sampled.
+  bool sample_phases =
+      PERF_COUNTERS_ENABLED && use_perf_counters && thread_index == 0;
+  if (sample_phases)
+  {
+    phase_sampler.reset();
+    (void)phase_sampler.start();
+  }
+
   // This adds varience to helper thread search trees which is essential for
   // Lazy SMP.
-  if (thread_index > MAX_SEARCH_THREADS / 2)
+  if (thread_index > search_thread_count() / 2)
   {
     iterative_depth_start = 2;
   }
@@ -249,6 +406,10 @@ auto SearchEngine::run_iterative_deepening_search(int thread_index,
     }
   }
 
+  if (sample_phases)
+  {
+    phase_sampler.stop();
+  }
   return final_move_scores;
 }
 
@@ -262,11 +423,15 @@ auto SearchEngine::run_search_with_aspiration_window(int thread_index,
 
   for (int aspiration_window : ASPIRATION_WINDOWS)
   {
+    if (aspiration_window != ASPIRATION_WINDOWS[0])
+    {
+      increment_stat(thread_stats[thread_index].aspiration_researches);
+    }
     int alpha = previous_eval - aspiration_window;
     int beta = previous_eval + aspiration_window;
-    move_scores = root_negamax_alpha_beta_search(
-        new_context(board_state, alpha, beta, depth, false, false, 0,
-                    thread_index, false, depth));
+    move_scores = root_negamax_alpha_beta_search(new_context(
+        board_state, alpha, beta, depth, false, 0, thread_index, nullptr,
+        depth));
     if (!running_search_flag || move_scores.empty() ||
         (move_scores[0].second > alpha && move_scores[0].second < beta))
     {
@@ -280,145 +445,14 @@ auto SearchEngine::root_negamax_alpha_beta_search(NodeContext context)
     -> std::vector<std::pair<Move, int>>
 {
   std::vector<std::pair<Move, int>> move_scores;
+  context.root_move_scores = &move_scores;
 
-  // Check if the engine wants to stop searching.
-  // Check if the current state has been repeated three times. If it has, the
-  // game is drawn. Evaluation for a draw is 0.
-  if (!running_search_flag ||
-      context.board_state.current_state_has_been_repeated_three_times())
-  {
-    return move_scores;
-  }
-
-  if (context.thread_index == 0)
-  {
-    nodes_visited.fetch_add(1, std::memory_order_relaxed);
-  }
-  nodes_visited_all_threads.fetch_add(1, std::memory_order_relaxed);
-
-  // TRANSPOSITION TABLE LOOKUP
-
-  transposition_table.retrieve(context.hash, context.tt_entry_search_depth,
-                               context.tt_eval, context.tt_flag,
-                               context.tt_best_move_index);
-
-  // CHECK IF IN CHECK
-  context.king_in_check =
-      (context.board_state.color_to_move == PieceColor::WHITE)
-          ? attack_check::king_is_checked(context.board_state,
-                                          PieceColor::WHITE)
-          : attack_check::king_is_checked(context.board_state,
-                                          PieceColor::BLACK);
-
-  // PRINCIPAL VARIATION HEURISTIC
-
-  std::vector<Move> possible_moves = move_generator::calculate_possible_moves(
-      context.board_state, true, &history_tables[context.thread_index], false);
-
-  put_best_move_at_front(possible_moves, context.tt_best_move_index);
-
-  // NEGAMAX SEARCH
-
-  context.max_eval = -INF;
-
-  // SEARCH
-  int quiet_move_index = 0;
-  for (int move_index = 0; move_index < possible_moves.size(); ++move_index)
-  {
-    if (possible_moves[move_index].captured_piece == nullptr)
-    {
-      ++quiet_move_index;
-    }
-
-    // Check if the engine wants to stop searching.
-    if (!running_search_flag)
-    {
-      break;
-    }
-
-    context.board_state.apply_move(possible_moves[move_index]);
-
-    int search_depth = context.depth;
-
-    // LMR HEURISTIC
-    if (quiet_move_index > LMR_THRESHOLD * 3 &&
-        context.depth >= MIN_LMR_DEPTH && !context.king_in_check &&
-        (context.depth + context.ply) > MIN_LMR_ITERATION_DEPTH &&
-        context.board_state.previous_move_stack.top().promotion_piece_type ==
-            PieceType::EMPTY)
-    {
-      search_depth -= LATE_MOVE_REDUCTION - 1;
-    }
-
-    int alpha_search = context.alpha;
-    if (context.thread_index == 0)
-    {
-      alpha_search = context.alpha - 2;
-    }
-    // Do a null window search around alpha. We just want to know
-    // if there is an eval that is greater than alpha. If there is, we do a full
-    // search.
-    if (move_index != 0)
-    {
-      int beta_search = alpha_search + 1;
-      context.eval = -negamax_alpha_beta_search(
-          new_context(context.board_state, -beta_search, -alpha_search,
-                      search_depth - 1, context.is_forward_pruning_line,
-                      move_index == 0, context.ply + 1, context.thread_index,
-                      context.king_in_check, context.iteration_depth));
-    }
-    if (move_index == 0 || context.eval > alpha_search)
-    {
-      context.eval = -negamax_alpha_beta_search(
-          new_context(context.board_state, -context.beta, -alpha_search,
-                      search_depth - 1, context.is_forward_pruning_line,
-                      move_index == 0, context.ply + 1, context.thread_index,
-                      context.king_in_check, context.iteration_depth));
-    }
-
-    move_scores.emplace_back(possible_moves[move_index], context.eval);
-
-    context.board_state.undo_move();
-
-    if (context.eval > context.max_eval)
-    {
-      context.max_eval = context.eval;
-      context.tt_best_move_index = possible_moves[move_index].list_index;
-    }
-
-    context.max_eval = std::max(context.eval, context.max_eval);
-    context.alpha = std::max(context.eval, context.alpha);
-
-    update_history_table(possible_moves[move_index], context.eval, search_depth,
-                         move_index, context.alpha, context.beta,
-                         history_tables[context.thread_index]);
-
-    if (context.alpha >= context.beta)
-    {
-      break;
-    }
-  }
-
-  // If search has stopped, don't save the states in the transposition
-  // table. This will cause invalid states to be stored with eval scores of 0.
-  // This may be saved as exact values in the transposition table, causing
-  // incorrect cutoffs in future searches.
-  if (!running_search_flag)
-  {
-    return move_scores;
-  }
-
-  // AFTER SEARCH PROCEDURE
-
-  // Handle checkmate evals and correct stalemate evals before saving
-  // the state into the transposition table.
-  handle_eval_adjustments(context.max_eval, context.board_state);
-
-  store_state_in_transposition_table(context);
+  (void)negamax_alpha_beta_search<NodeType::ROOT>(context);
 
   return move_scores;
 }
 
+template <NodeType node_type>
 auto SearchEngine::negamax_alpha_beta_search(NodeContext context) -> int
 {
   // Return if the engine wants to stop searching.
@@ -437,72 +471,73 @@ auto SearchEngine::negamax_alpha_beta_search(NodeContext context) -> int
     printf("BREAKPOINT negamax_alpha_beta_search; depth < 0\n");
   }
 
-  if (context.thread_index == 0)
-  {
-    nodes_visited.fetch_add(1, std::memory_order_relaxed);
-  }
-  nodes_visited_all_threads.fetch_add(1, std::memory_order_relaxed);
+  thread_counters[context.thread_index].nodes_visited.fetch_add(
+      1, std::memory_order_relaxed);
+  record_node_stats(context);
+  check_node_limit(context.thread_index);
 
   context.hash = context.board_state.get_current_state_hash();
   context.max_eval = -INF;
 
-  if (handle_tt_entry(context))
+  if constexpr (node_type == NodeType::ROOT)
+  {
+    // The root never returns a TT eval since every root move needs a score.
+    // We only use the TT best move for move ordering.
+    (void)probe_transposition_table(context, false);
+  }
+  else
   {
-    return context.tt_eval;
+    if (handle_tt_entry(context))
+    {
+      return context.tt_eval;
+    }
   }
 
   // If previous color to move is in check, return INF because they are in
   // checkmate.
-  if ((context.board_state.color_to_move == PieceColor::WHITE)
-          ? attack_check::king_is_checked(context.board_state,
-                                          PieceColor::BLACK)
-          : attack_check::king_is_checked(context.board_state,
-                                          PieceColor::WHITE))
+  if (!compute_check_state(context))
   {
     return INF;
   }
 
-  context.king_in_check =
-      (context.board_state.color_to_move == PieceColor::WHITE)
-          ? attack_check::king_is_checked(context.board_state,
-                                          PieceColor::WHITE)
-          : attack_check::king_is_checked(context.board_state,
-                                          PieceColor::BLACK);
-
-  // NOTE: Limit extension to 2 plys to avoid stalling the search.
-  if (context.depth <= 0 &&
-      (context.king_in_check || context.previous_state_in_check) &&
-      (context.ply + 2) <= context.iteration_depth)
+  if constexpr (node_type != NodeType::ROOT)
   {
-    ++context.depth;
-  }
+    // NOTE: Limit extension to 2 plys to avoid stalling the search.
+    if (context.depth <= 0 &&
+        (context.king_in_check || context.previous_state_in_check) &&
+        (context.ply + 2) <= context.iteration_depth)
+    {
+      ++context.depth;
+    }
 
-  // HANDLE LEAF NODE
+    // HANDLE LEAF NODE
 
-  // There is a scnario where the depth is less than 0. This can happen if the
-  // null move heuristic is used when the depth is 1. Null move calls negamax
-  // with depth - 2 since it is skipping a turn.
-  if (context.depth <= 0)
-  {
-    if (context.thread_index == 0)
+    // There is a scnario where the depth is less than 0. This can happen if
+    // the null move heuristic is used when the depth is 1. Null move calls
+    // negamax with depth - 2 since it is skipping a turn.
+    if (context.depth <= 0)
     {
-      leaf_nodes_visited.fetch_add(1, std::memory_order_relaxed);
+      thread_counters[context.thread_index].leaf_nodes_visited.fetch_add(
+          1, std::memory_order_relaxed);
+      NodeContext quiescence_context = new_context(
+          context.board_state, context.alpha, context.beta, 0,
+          context.is_forward_pruning_line, context.ply, context.thread_index,
+          context.previous_check_info, context.iteration_depth);
+      quiescence_context.check_info = context.check_info;
+      quiescence_context.check_state_is_known = true;
+      return quiescence_search(quiescence_context);
     }
-    return quiescence_search(
-        new_context(context.board_state, context.alpha, context.beta, 0,
-                    context.is_forward_pruning_line, context.is_pvs_line,
-                    context.ply, context.thread_index, context.king_in_check,
-                    context.iteration_depth, true));
-  }
 
-  context.static_eval =
-      position_evaluator::evaluate_position(context.board_state);
+    context.static_eval = get_static_eval(context);
+  }
 
   // NULL MOVE PRUNING HEURISTIC
 
-  if (!do_null_move_search(context))
+  // NOTE: Only null window nodes try a null move. The ROOT and PV nodes need an
+  // exact score.
+  if (node_type != NodeType::NON_PV || !do_null_move_search(context))
   {
-    run_negamax_procedure(context);
+    run_negamax_procedure<node_type>(context);
   }
 
   // NOTE: If search has stopped, don't save the states in the transposition
@@ -518,7 +553,7 @@ auto SearchEngine::negamax_alpha_beta_search(NodeContext context) -> int
   // the state into the transposition table.
   handle_eval_adjustments(context.max_eval, context.board_state);
 
-  store_state_in_transposition_table(context);
+  store_state_in_transposition_table<false>(context);
 
   return context.max_eval;
 }
@@ -531,13 +566,18 @@ void SearchEngine::sort_moves(std::vector<std::pair<Move, int>> &move_scores)
       { return move_a.second > move_b.second; });
 }
 
+template <NodeType node_type>
 void SearchEngine::run_negamax_procedure(NodeContext &context)
 {
   std::vector<Move> possible_moves = move_generator::calculate_possible_moves(
       context.board_state, true, &history_tables[context.thread_index], false);
 
+  order_moves(context, possible_moves);
   put_best_move_at_front(possible_moves, context.tt_best_move_index);
 
+  const attack_check::CheckSquares check_squares =
+      attack_check::compute_check_squares(context.board_state);
+
   int quiet_move_index = 0;
   bool is_capture_move = false;
   for (int move_index = 0; move_index < possible_moves.size(); ++move_index)
@@ -558,17 +598,46 @@ void SearchEngine::run_negamax_procedure(NodeContext &context)
       return;
     }
 
-    context.board_state.apply_move(possible_moves[move_index]);
-
-    // FUTILITY PRUNING HEURISTIC
+    // Only quiet moves are exempted from pruning and reductions by giving
+    // check, so captures skip the query.
+    bool gives_check =
+        !is_capture_move &&
+        attack_check::gives_check(context.board_state,
+                                  possible_moves[move_index], check_squares);
 
-    if (!futility_prune_move(context, quiet_move_index,
-                             possible_moves[move_index], is_capture_move))
+    if constexpr (node_type == NodeType::ROOT)
     {
-      run_pvs_search(context, move_index, quiet_move_index, is_capture_move);
+      // Every root move is searched and scored.
+      BoardState &child_board_state =
+          make_move(context, possible_moves[move_index]);
+      run_pvs_search<node_type>(context, child_board_state, move_index,
+                                quiet_move_index, is_capture_move,
+                                gives_check);
+      unmake_move(context, child_board_state);
+      context.root_move_scores->emplace_back(possible_moves[move_index],
+                                             context.eval);
     }
+    else
+    {
+      // FUTILITY PRUNING HEURISTIC
+      // Decided before making the move, so pruned moves are never applied.
 
-    context.board_state.undo_move();
+      if (!futility_prune_move(context, quiet_move_index,
+                               possible_moves[move_index], is_capture_move,
+                               gives_check))
+      {
+        BoardState &child_board_state =
+            make_move(context, possible_moves[move_index]);
+        run_pvs_search<node_type>(context, child_board_state, move_index,
+                                  quiet_move_index, is_capture_move,
+                                  gives_check);
+        unmake_move(context, child_board_state);
+      }
+      else
+      {
+        increment_stat(thread_stats[context.thread_index].futility_prunes);
+      }
+    }
 
     if (context.eval > context.max_eval)
     {
@@ -585,16 +654,64 @@ void SearchEngine::run_negamax_procedure(NodeContext &context)
 
     if (context.alpha >= context.beta)
     {
+      record_beta_cutoff(context, possible_moves[move_index], move_index,
+                         is_capture_move);
       break;
     }
   }
 }
 
+template <NodeType node_type>
 void SearchEngine::run_pvs_search(NodeContext &context,
+                                  BoardState &child_board_state,
                                   int move_index,
                                   int quiet_move_index,
-                                  bool is_capture_move)
+                                  bool is_capture_move,
+                                  bool gives_check)
 {
+  if constexpr (node_type == NodeType::ROOT)
+  {
+    int search_depth = context.depth;
+
+    // LMR HEURISTIC
+    if (quiet_move_index > LMR_THRESHOLD * 3 &&
+        context.depth >= MIN_LMR_DEPTH && !context.king_in_check &&
+        !gives_check &&
+        (context.depth + context.ply) > MIN_LMR_ITERATION_DEPTH &&
+        child_board_state.state_history.back().move.promotion_piece_type ==
+            PieceType::EMPTY)
+    {
+      search_depth -= LATE_MOVE_REDUCTION - 1;
+    }
+
+    int alpha_search = context.alpha;
+    if (context.thread_index == 0)
+    {
+      alpha_search = context.alpha - 2;
+    }
+    // Do a null window search around alpha. We just want to know
+    // if there is an eval that is greater than alpha. If there is, we do a full
+    // search.
+    if (move_index != 0)
+    {
+      int beta_search = alpha_search + 1;
+      context.eval = -negamax_alpha_beta_search<NodeType::NON_PV>(new_context(
+          child_board_state, -beta_search, -alpha_search, search_depth - 1,
+          context.is_forward_pruning_line, context.ply + 1,
+          context.thread_index, &context.check_info,
+          context.iteration_depth));
+    }
+    if (move_index == 0 || context.eval > alpha_search)
+    {
+      context.eval = -negamax_alpha_beta_search<NodeType::PV>(new_context(
+          child_board_state, -context.beta, -alpha_search, search_depth - 1,
+          context.is_forward_pruning_line, context.ply + 1,
+          context.thread_index, &context.check_info,
+          context.iteration_depth));
+    }
+    return;
+  }
+
   int new_search_depth = context.depth - 1;
 
   // LATE MOVE REDUCTION HEURISTIC
@@ -602,13 +719,14 @@ void SearchEngine::run_pvs_search(NodeContext &context,
   bool lmr_line = context.is_forward_pruning_line;
   if (quiet_move_index > LMR_THRESHOLD && context.depth >= MIN_LMR_DEPTH &&
       !context.king_in_check && !context.previous_state_in_check &&
-      !is_capture_move && !context.is_forward_pruning_line &&
+      !is_capture_move && !gives_check && !context.is_forward_pruning_line &&
       (context.depth + context.ply) > MIN_LMR_ITERATION_DEPTH &&
-      context.board_state.previous_move_stack.top().promotion_piece_type ==
+      child_board_state.state_history.back().move.promotion_piece_type ==
           PieceType::EMPTY)
   {
     lmr_line = true;
     new_search_depth -= LATE_MOVE_REDUCTION;
+    increment_stat(thread_stats[context.thread_index].lmr_reductions);
 
     if (quiet_move_index > EXTREME_LMR_THRESHOLD)
     {
@@ -618,7 +736,7 @@ void SearchEngine::run_pvs_search(NodeContext &context,
           (quiet_move_index / LMR_EXTREME_REDUCTION_INDEX_DIVISOR);
     }
     // If position is equal, search quiet moves deeper.
-    if (context.board_state.is_end_game ||
+    if (child_board_state.is_end_game ||
         (context.static_eval > -PAWN_VALUE && context.static_eval < PAWN_VALUE))
     {
       new_search_depth += 1;
@@ -638,40 +756,80 @@ void SearchEngine::run_pvs_search(NodeContext &context,
   // Do a null window search around alpha. We just want to know
   // if there is an eval that is greater than alpha. If there is, we do a full
   // search.
-  context.eval = -negamax_alpha_beta_search(new_context(
-      context.board_state, -context.alpha - 1, -context.alpha, new_search_depth,
-      lmr_line, (move_index == 0 && context.is_pvs_line), context.ply + 1,
-      context.thread_index, context.king_in_check, context.iteration_depth));
+  context.eval = -negamax_alpha_beta_search<NodeType::NON_PV>(new_context(
+      child_board_state, -context.alpha - 1, -context.alpha, new_search_depth,
+      lmr_line, context.ply + 1, context.thread_index, &context.check_info,
+      context.iteration_depth));
 
   if (context.eval > context.alpha && context.depth - 1 > new_search_depth)
   {
-    context.eval = -negamax_alpha_beta_search(new_context(
-        context.board_state, -context.alpha - 1, -context.alpha,
-        context.depth - 1, context.is_forward_pruning_line,
-        (move_index == 0 && context.is_pvs_line), context.ply + 1,
-        context.thread_index, context.king_in_check, context.iteration_depth));
+    increment_stat(thread_stats[context.thread_index].lmr_researches);
+    context.eval = -negamax_alpha_beta_search<NodeType::NON_PV>(new_context(
+        child_board_state, -context.alpha - 1, -context.alpha,
+        context.depth - 1, context.is_forward_pruning_line, context.ply + 1,
+        context.thread_index, &context.check_info, context.iteration_depth));
   }
 
   // Check if eval is greater than alpha. If it is, do a full search.
-  // If window is already null, don't do a redundant search. This means parent
-  // nodes are doing a null window search, and we just did a null window
-  // search above.
-  if (context.eval > context.alpha && context.beta - context.alpha > 1)
+  // NON_PV nodes always have a null window, so they never do this redundant
+  // search. For PV nodes, if the window has closed down to a null window, we
+  // also skip it since we just did a null window search above.
+  if constexpr (node_type == NodeType::PV)
   {
-    context.eval = -negamax_alpha_beta_search(new_context(
-        context.board_state, -context.beta, -context.alpha, context.depth - 1,
-        context.is_forward_pruning_line,
-        (move_index == 0 && context.is_pvs_line), context.ply + 1,
-        context.thread_index, context.king_in_check, context.iteration_depth));
+    if (context.eval > context.alpha && context.beta - context.alpha > 1)
+    {
+      context.eval = -negamax_alpha_beta_search<NodeType::PV>(new_context(
+          child_board_state, -context.beta, -context.alpha,
+          context.depth - 1, context.is_forward_pruning_line, context.ply + 1,
+          context.thread_index, &context.check_info,
+          context.iteration_depth));
+    }
+  }
+}
+
+auto SearchEngine::make_move(NodeContext &context, Move &move) -> BoardState &
+{
+  perf_counters::ScopedPhase phase(perf_counters::SearchPhase::MAKE_UNMAKE);
+  if (!use_copy_make)
+  {
+    context.board_state.apply_move(move);
+    return context.board_state;
+  }
+
+  // The board states of a thread form a stack along the searched line, so the
+  // next one is free for the child node.
+  std::deque<BoardState> &board_states =
+      copy_make_board_states[context.thread_index];
+  int &depth = copy_make_depths[context.thread_index];
+  if (depth == static_cast<int>(board_states.size()))
+  {
+    board_states.emplace_back();
+  }
+  BoardState &child_board_state = board_states[depth];
+  ++depth;
+
+  child_board_state.copy_make(context.board_state, move);
+  return child_board_state;
+}
+
+void SearchEngine::unmake_move(NodeContext &context,
+                               BoardState &child_board_state)
+{
+  perf_counters::ScopedPhase phase(perf_counters::SearchPhase::MAKE_UNMAKE);
+  if (&child_board_state == &context.board_state)
+  {
+    context.board_state.undo_move();
+  }
+  else
+  {
+    --copy_make_depths[context.thread_index];
   }
 }
 
 auto SearchEngine::handle_tt_entry(NodeContext &context) -> bool
 {
   // Check transposition table if position has been searched before.
-  if (transposition_table.retrieve(context.hash, context.tt_entry_search_depth,
-                                   context.tt_eval, context.tt_flag,
-                                   context.tt_best_move_index) &&
+  if (probe_transposition_table(context, false) &&
       !(context.board_state.is_end_game &&
         context.board_state.current_state_has_been_visited()))
   {
@@ -715,9 +873,45 @@ auto SearchEngine::handle_tt_entry(NodeContext &context) -> bool
   return false;
 }
 
+auto SearchEngine::compute_check_state(NodeContext &context) -> bool
+{
+  if (context.check_state_is_known)
+  {
+    context.king_in_check = context.check_info.in_check();
+    return true;
+  }
+
+  BoardState &board_state = context.board_state;
+
+  // Only verify the previous move with an attack scan if the previous node
+  // could not prove it legal from its own check state.
+  if (context.previous_check_info != nullptr)
+  {
+    bool previous_move_is_known_legal =
+        context.previous_move_is_null
+            ? !context.previous_check_info->in_check()
+            : context.previous_check_info->move_is_known_legal(
+                  board_state.state_history.back().move);
+
+    if (!previous_move_is_known_legal &&
+        attack_check::king_is_checked(
+            board_state, board_state.color_to_move == PieceColor::WHITE
+                             ? PieceColor::BLACK
+                             : PieceColor::WHITE))
+    {
+      return false;
+    }
+  }
+
+  context.check_info =
+      attack_check::compute_check_info(board_state, board_state.color_to_move);
+  context.king_in_check = context.check_info.in_check();
+  return true;
+}
+
 auto SearchEngine::do_null_move_search(NodeContext &context) -> bool
 {
-  if (context.is_forward_pruning_line || context.is_pvs_line ||
+  if (context.is_forward_pruning_line ||
       (context.depth + context.ply) <= MIN_NULL_MOVE_ITERATION_DEPTH ||
       context.board_state.is_end_game || context.king_in_check ||
       context.depth < MIN_NULL_MOVE_DEPTH ||
@@ -726,19 +920,24 @@ auto SearchEngine::do_null_move_search(NodeContext &context) -> bool
     return false;
   }
 
+  increment_stat(thread_stats[context.thread_index].null_move_attempts);
   context.board_state.apply_null_move();
 
   int reduction = context.depth / NULL_MOVE_ADDITIONAL_DEPTH_DIVISOR;
 
-  context.eval = -negamax_alpha_beta_search(new_context(
+  NodeContext null_move_context = new_context(
       context.board_state, -context.beta, -(context.beta - 1),
-      context.depth - reduction, true, false, context.ply + 1,
-      context.thread_index, context.king_in_check, context.iteration_depth));
+      context.depth - reduction, true, context.ply + 1, context.thread_index,
+      &context.check_info, context.iteration_depth);
+  null_move_context.previous_move_is_null = true;
+  context.eval =
+      -negamax_alpha_beta_search<NodeType::NON_PV>(null_move_context);
 
   context.board_state.undo_null_move();
 
   if (context.eval >= context.beta)
   {
+    increment_stat(thread_stats[context.thread_index].null_move_cutoffs);
     context.max_eval = context.eval;
     return true;
   }
@@ -773,8 +972,10 @@ void SearchEngine::handle_eval_adjustments(int &eval, BoardState &board_state)
   }
 }
 
+template <bool is_quiescence>
 void SearchEngine::store_state_in_transposition_table(NodeContext &context)
 {
+  perf_counters::ScopedPhase phase(perf_counters::SearchPhase::TT_PROBE);
   // Store in transposition table.
   int tt_flag_to_store;
   if (context.max_eval >= context.beta)
@@ -789,9 +990,11 @@ void SearchEngine::store_state_in_transposition_table(NodeContext &context)
   {
     tt_flag_to_store = EXACT;
   }
-  transposition_table.store(context.hash, context.depth, context.max_eval,
-                            tt_flag_to_store, context.tt_best_move_index,
-                            context.is_quiescence);
+  transposition_table.store(
+      context.hash, context.depth, context.max_eval, tt_flag_to_store,
+      context.tt_best_move_index,
+      context.static_eval_is_lazy ? NO_STATIC_EVAL : context.static_eval,
+      is_quiescence);
 }
 
 void SearchEngine::reset_and_print_performance_matrix(
@@ -800,6 +1003,36 @@ void SearchEngine::reset_and_print_performance_matrix(
     const std::chrono::time_point<std::chrono::steady_clock> &search_end_time,
     const std::vector<std::pair<Move, int>> &move_scores)
 {
+  // Collect the node counters. The main thread's counters are reported on
+  // their own, and the sum of all threads is reported separately.
+  size_t nodes_visited = thread_counters[0].nodes_visited.load();
+  size_t leaf_nodes_visited = thread_counters[0].leaf_nodes_visited.load();
+  size_t quiescence_nodes_visited =
+      thread_counters[0].quiescence_nodes_visited.load();
+  size_t see_pruned_quiescence_moves =
+      thread_counters[0].see_pruned_quiescence_moves.load();
+  size_t tt_static_eval_hits = thread_counters[0].tt_static_eval_hits.load();
+  size_t eval_cache_hits = thread_counters[0].eval_cache_hits.load();
+  size_t eval_cache_probes =
+      eval_cache_hits + thread_counters[0].eval_cache_misses.load();
+  size_t lazy_eval_attempts = thread_counters[0].lazy_eval_attempts.load();
+  size_t lazy_eval_exits = thread_counters[0].lazy_eval_exits.load();
+  size_t beta_cutoffs = thread_counters[0].beta_cutoffs.load();
+  size_t first_move_beta_cutoffs =
+      thread_counters[0].first_move_beta_cutoffs.load();
+  size_t killer_move_beta_cutoffs =
+      thread_counters[0].killer_move_beta_cutoffs.load();
+  size_t counter_move_beta_cutoffs =
+      thread_counters[0].counter_move_beta_cutoffs.load();
+  // The pawn hash table counters are only written by their own thread.
+  size_t pawn_hash_hits = pawn_hash_tables[0].hits;
+  size_t pawn_hash_probes = pawn_hash_hits + pawn_hash_tables[0].misses;
+  size_t nodes_visited_all_threads = 0;
+  for (const auto &counters : thread_counters)
+  {
+    nodes_visited_all_threads += counters.nodes_visited.load();
+  }
+
   // Print performance metrics to user.
   if (!is_uci && ((show_performance && !engine_is_pondering) ||
                   (show_ponder_performance && engine_is_pondering)))
@@ -837,6 +1070,38 @@ void SearchEngine::reset_and_print_performance_matrix(
           PERCENTAGE);
     }
 
+    int first_move_cutoff_percentage = 0;
+    if (beta_cutoffs != 0)
+    {
+      first_move_cutoff_percentage = static_cast<int>(
+          (static_cast<double>(first_move_beta_cutoffs) / beta_cutoffs) *
+          PERCENTAGE);
+    }
+
+    int eval_cache_hit_percentage = 0;
+    if (eval_cache_probes != 0)
+    {
+      eval_cache_hit_percentage = static_cast<int>(
+          (static_cast<double>(eval_cache_hits) / eval_cache_probes) *
+          PERCENTAGE);
+    }
+
+    int lazy_eval_exit_percentage = 0;
+    if (lazy_eval_attempts != 0)
+    {
+      lazy_eval_exit_percentage = static_cast<int>(
+          (static_cast<double>(lazy_eval_exits) / lazy_eval_attempts) *
+          PERCENTAGE);
+    }
+
+    int pawn_hash_hit_percentage = 0;
+    if (pawn_hash_probes != 0)
+    {
+      pawn_hash_hit_percentage = static_cast<int>(
+          (static_cast<double>(pawn_hash_hits) / pawn_hash_probes) *
+          PERCENTAGE);
+    }
+
     // Branchind Factor
     auto branching_factor = std::pow(nodes_visited, 1.0 / iterative_depth);
 
@@ -846,27 +1111,256 @@ void SearchEngine::reset_and_print_performance_matrix(
            move_interface::move_to_string(move_scores[0].first).c_str(),
            move_scores[0].second);
     printf("Branching Factor: %.2f\n", branching_factor);
-    printf("Leaf Nodes Visited: %zu\n", leaf_nodes_visited.load());
-    printf("Quiessence Nodes Visited: %zu\n", quiescence_nodes_visited.load());
-    printf("Nodes Visited: %zu\n", nodes_visited.load());
-    printf("Nodes Visited - All Threads: %zu\n",
-           nodes_visited_all_threads.load());
+    printf("Leaf Nodes Visited: %zu\n", leaf_nodes_visited);
+    printf("Quiessence Nodes Visited: %zu\n", quiescence_nodes_visited);
+    printf("Nodes Visited: %zu\n", nodes_visited);
+    printf("Nodes Visited - All Threads: %zu\n", nodes_visited_all_threads);
     printf("Normal Node Percentage: %d%%\n", normal_node_percentage);
     printf("Quiescence Node Percentage: %d%%\n", quiescence_node_percentage);
+    printf("SEE Pruned Quiescence Moves: %zu\n", see_pruned_quiescence_moves);
+    printf("Beta Cutoffs: %zu\n", beta_cutoffs);
+    printf("First Move Cutoff Rate: %d%%\n", first_move_cutoff_percentage);
+    printf("Killer Move Cutoffs: %zu\n", killer_move_beta_cutoffs);
+    printf("Countermove Cutoffs: %zu\n", counter_move_beta_cutoffs);
+    printf("TT Static Eval Hits: %zu\n", tt_static_eval_hits);
+    printf("Eval Cache Hits: %zu\n", eval_cache_hits);
+    printf("Eval Cache Hit Rate: %d%%\n", eval_cache_hit_percentage);
+    printf("Lazy Eval Exits: %zu\n", lazy_eval_exits);
+    printf("Lazy Eval Exit Rate: %d%%\n", lazy_eval_exit_percentage);
+    printf("Pawn Hash Hit Rate: %d%%\n", pawn_hash_hit_percentage);
     printf("Nodes per second: %lu kN/s\n", kilo_nps);
     printf("Nodes per second - All Threads: %lu kN/s\n\n",
            kilo_nps_all_threads);
+
+    if (PERF_COUNTERS_ENABLED && use_perf_counters)
+    {
+      phase_sampler.print_report();
+    }
   }
 
+  if constexpr (SEARCH_STATS_ENABLED)
+  {
+    write_search_stats(iterative_depth, search_start_time, search_end_time,
+                       move_scores, nodes_visited_all_threads);
+  }
+
+  completed_iteration_nodes += nodes_visited;
+  completed_iteration_nodes_all_threads += nodes_visited_all_threads;
+
   // Reset performance metrics.
-  nodes_visited = 0;
-  leaf_nodes_visited = 0;
-  quiescence_nodes_visited = 0;
-  nodes_visited_all_threads = 0;
+  reset_thread_counters();
+  phase_sampler.reset();
+}
+
+void SearchEngine::check_node_limit(int thread_index)
+{
+  if (max_search_nodes == 0 || thread_index != 0 || engine_is_pondering ||
+      completed_iteration_nodes == search_start_nodes)
+  {
+    return;
+  }
+  size_t search_nodes = completed_iteration_nodes - search_start_nodes +
+                        thread_counters[0].nodes_visited.load(
+                            std::memory_order_relaxed);
+  if (search_nodes >= max_search_nodes)
+  {
+    running_search_flag = false;
+  }
+}
+
+void SearchEngine::reset_thread_counters()
+{
+  for (auto &counters : thread_counters)
+  {
+    counters.nodes_visited = 0;
+    counters.leaf_nodes_visited = 0;
+    counters.quiescence_nodes_visited = 0;
+    counters.see_pruned_quiescence_moves = 0;
+    counters.tt_static_eval_hits = 0;
+    counters.eval_cache_hits = 0;
+    counters.eval_cache_misses = 0;
+    counters.lazy_eval_attempts = 0;
+    counters.lazy_eval_exits = 0;
+    counters.beta_cutoffs = 0;
+    counters.first_move_beta_cutoffs = 0;
+    counters.killer_move_beta_cutoffs = 0;
+    counters.counter_move_beta_cutoffs = 0;
+  }
+  for (auto &stats : thread_stats)
+  {
+    stats.selective_depth = 0;
+    stats.tt_probes = 0;
+    stats.tt_hits = 0;
+    stats.tt_checksum_rejections = 0;
+    stats.null_move_attempts = 0;
+    stats.null_move_cutoffs = 0;
+    stats.lmr_reductions = 0;
+    stats.lmr_researches = 0;
+    stats.futility_prunes = 0;
+    stats.delta_prunes = 0;
+    stats.aspiration_researches = 0;
+    for (auto &ply_nodes : stats.nodes_per_ply)
+    {
+      ply_nodes = 0;
+    }
+  }
+  pawn_hash_tables[0].reset_counters();
+}
+
+void SearchEngine::increment_stat(std::atomic<size_t> &stat)
+{
+  if constexpr (SEARCH_STATS_ENABLED)
+  {
+    stat.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void SearchEngine::record_node_stats(const NodeContext &context)
+{
+  if constexpr (SEARCH_STATS_ENABLED)
+  {
+    SearchThreadStats &stats = thread_stats[context.thread_index];
+    auto ply = static_cast<size_t>(context.ply);
+    stats.nodes_per_ply[std::min<size_t>(ply, SEARCH_STATS_MAX_PLY - 1)]
+        .fetch_add(1, std::memory_order_relaxed);
+    // Only this thread writes its selective depth.
+    if (ply > stats.selective_depth.load(std::memory_order_relaxed))
+    {
+      stats.selective_depth.store(ply, std::memory_order_relaxed);
+    }
+  }
+}
+
+auto SearchEngine::probe_transposition_table(NodeContext &context,
+                                             bool is_quiescence) -> bool
+{
+  perf_counters::ScopedPhase phase(perf_counters::SearchPhase::TT_PROBE);
+  bool checksum_rejected = false;
+  bool found = transposition_table.retrieve(
+      context.hash, context.tt_entry_search_depth, context.tt_eval,
+      context.tt_flag, context.tt_best_move_index, context.tt_static_eval,
+      is_quiescence, SEARCH_STATS_ENABLED ? &checksum_rejected : nullptr);
+
+  if constexpr (SEARCH_STATS_ENABLED)
+  {
+    SearchThreadStats &stats = thread_stats[context.thread_index];
+    stats.tt_probes.fetch_add(1, std::memory_order_relaxed);
+    if (found)
+    {
+      stats.tt_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (checksum_rejected)
+    {
+      stats.tt_checksum_rejections.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  return found;
+}
+
+void SearchEngine::write_search_stats(
+    int iterative_depth,
+    const std::chrono::time_point<std::chrono::steady_clock> &search_start_time,
+    const std::chrono::time_point<std::chrono::steady_clock> &search_end_time,
+    const std::vector<std::pair<Move, int>> &move_scores,
+    size_t nodes_visited_all_threads)
+{
+  FILE *output = search_stats_to_stderr ? stderr : search_stats_file.get();
+  if (output == nullptr || move_scores.empty())
+  {
+    return;
+  }
+
+  const SearchThreadCounters &counters = thread_counters[0];
+  const SearchThreadStats &stats = thread_stats[0];
+  auto rate = [](size_t count, size_t total) {
+    return total == 0 ? 0.0
+                      : static_cast<double>(count) /
+                            static_cast<double>(total);
+  };
+
+  size_t tt_probes = stats.tt_probes.load();
+  size_t tt_checksum_rejections = stats.tt_checksum_rejections.load();
+  size_t beta_cutoffs = counters.beta_cutoffs.load();
+  size_t null_move_attempts = stats.null_move_attempts.load();
+  size_t lmr_reductions = stats.lmr_reductions.load();
+  auto time_ms = static_cast<long long>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(search_end_time -
+                                                            search_start_time)
+          .count());
+
+  fprintf(output,
+          "{\"depth\":%d,\"seldepth\":%zu,\"time_ms\":%lld,\"nodes\":%zu,"
+          "\"nodes_all_threads\":%zu,\"pondering\":%s,\"best_move\":\"%s\","
+          "\"score\":%d,",
+          iterative_depth, stats.selective_depth.load(), time_ms,
+          counters.nodes_visited.load(), nodes_visited_all_threads,
+          engine_is_pondering ? "true" : "false",
+          move_interface::move_to_string(move_scores[0].first).c_str(),
+          move_scores[0].second);
+  fprintf(output,
+          "\"tt_probes\":%zu,\"tt_hit_rate\":%.4f,"
+          "\"tt_checksum_rejections\":%zu,"
+          "\"tt_checksum_rejection_rate\":%.4f,",
+          tt_probes, rate(stats.tt_hits.load(), tt_probes),
+          tt_checksum_rejections, rate(tt_checksum_rejections, tt_probes));
+  fprintf(output,
+          "\"beta_cutoffs\":%zu,\"first_move_cutoff_rate\":%.4f,"
+          "\"null_move_attempts\":%zu,\"null_move_success_rate\":%.4f,"
+          "\"lmr_reductions\":%zu,\"lmr_research_rate\":%.4f,",
+          beta_cutoffs,
+          rate(counters.first_move_beta_cutoffs.load(), beta_cutoffs),
+          null_move_attempts,
+          rate(stats.null_move_cutoffs.load(), null_move_attempts),
+          lmr_reductions, rate(stats.lmr_researches.load(), lmr_reductions));
+  fprintf(output,
+          "\"futility_prunes\":%zu,\"delta_prunes\":%zu,\"see_prunes\":%zu,"
+          "\"aspiration_researches\":%zu,\"nodes_per_ply\":[",
+          stats.futility_prunes.load(), stats.delta_prunes.load(),
+          counters.see_pruned_quiescence_moves.load(),
+          stats.aspiration_researches.load());
+
+  // Leave out the empty plies past the selective depth.
+  size_t num_of_plies = std::min<size_t>(stats.selective_depth.load() + 1,
+                                         SEARCH_STATS_MAX_PLY);
+  for (size_t ply = 0; ply < num_of_plies; ++ply)
+  {
+    fprintf(output, "%s%zu", ply == 0 ? "" : ",",
+            stats.nodes_per_ply[ply].load());
+  }
+  fprintf(output, "]");
+
+  // Estimated hardware events of each search phase, see perf_counters.
+  if (phase_sampler.is_running())
+  {
+    fprintf(output, ",\"perf\":{");
+    for (int phase = 0; phase < perf_counters::NUM_OF_SEARCH_PHASES; ++phase)
+    {
+      fprintf(output, "%s\"%s\":{", phase == 0 ? "" : ",",
+              perf_counters::SEARCH_PHASE_NAMES[phase]);
+      bool is_first_event = true;
+      for (int event = 0; event < perf_counters::NUM_OF_PERF_EVENTS; ++event)
+      {
+        if (!phase_sampler.event_is_available(event))
+        {
+          continue;
+        }
+        fprintf(output, "%s\"%s\":%llu", is_first_event ? "" : ",",
+                perf_counters::PERF_EVENT_NAMES[event],
+                static_cast<unsigned long long>(phase_sampler.estimated_count(
+                    static_cast<perf_counters::SearchPhase>(phase), event)));
+        is_first_event = false;
+      }
+      fprintf(output, "}");
+    }
+    fprintf(output, "}");
+  }
+  fprintf(output, "}\n");
+  fflush(output);
 }
 
 auto SearchEngine::quiescence_search(NodeContext context) -> int
 {
+  perf_counters::ScopedPhase phase(perf_counters::SearchPhase::QUIESCENCE);
   // Check if the engine wants to stop searching.
   if (!running_search_flag)
   {
@@ -881,41 +1375,26 @@ auto SearchEngine::quiescence_search(NodeContext context) -> int
   }
 
   // Increment nodes visited.
-  if (context.thread_index == 0)
-  {
-    nodes_visited.fetch_add(1, std::memory_order_relaxed);
-    quiescence_nodes_visited.fetch_add(1, std::memory_order_relaxed);
-  }
-  nodes_visited_all_threads.fetch_add(1, std::memory_order_relaxed);
+  SearchThreadCounters &counters = thread_counters[context.thread_index];
+  counters.nodes_visited.fetch_add(1, std::memory_order_relaxed);
+  counters.quiescence_nodes_visited.fetch_add(1, std::memory_order_relaxed);
+  record_node_stats(context);
+  check_node_limit(context.thread_index);
 
-  context.is_quiescence = true;
   context.original_alpha = context.alpha;
   context.hash = context.board_state.get_current_state_hash();
 
   // CHECKMATE DETECTION
 
   // CHECK WHICH SIDE IS IN CHECK
-  if ((context.board_state.color_to_move == PieceColor::WHITE)
-          ? attack_check::king_is_checked(context.board_state,
-                                          PieceColor::BLACK)
-          : attack_check::king_is_checked(context.board_state,
-                                          PieceColor::WHITE))
+  if (!compute_check_state(context))
   {
     return INF;
   }
 
-  context.king_in_check =
-      (context.board_state.color_to_move == PieceColor::WHITE)
-          ? attack_check::king_is_checked(context.board_state,
-                                          PieceColor::WHITE)
-          : attack_check::king_is_checked(context.board_state,
-                                          PieceColor::BLACK);
-
   // TRANSPOSITION TABLE LOOKUP
 
-  if (transposition_table.retrieve(context.hash, context.tt_entry_search_depth,
-                                   context.tt_eval, context.tt_flag,
-                                   context.tt_best_move_index, true))
+  if (probe_transposition_table(context, true))
   {
     int tt_alpha = context.alpha;
     int tt_beta = context.beta;
@@ -946,8 +1425,7 @@ auto SearchEngine::quiescence_search(NodeContext context) -> int
 
   // QUIESCENCE SEARCH PRE-PROCEDURE
 
-  context.static_eval =
-      position_evaluator::evaluate_position(context.board_state);
+  context.static_eval = get_static_eval(context, true);
 
   // If the eval is not within the alpha beta window, return the eval.
   // Otherwise, we will do too many unnecessary quiescence searches.
@@ -976,7 +1454,7 @@ auto SearchEngine::quiescence_search(NodeContext context) -> int
   }
 
   context.depth = 0;
-  store_state_in_transposition_table(context);
+  store_state_in_transposition_table<true>(context);
   return context.max_eval;
 }
 
@@ -993,17 +1471,29 @@ void SearchEngine::run_quiescence_search_procedure(NodeContext &context)
     // Check if the move can be delta pruned.
     if (!context.king_in_check && delta_prune_move(context, move))
     {
+      increment_stat(thread_stats[context.thread_index].delta_prunes);
       continue;
     }
 
-    context.board_state.apply_move(move);
+    // SEE PRUNING
+    // A capture that loses material in the exchange on its square is very
+    // unlikely to raise the stand pat score.
+    if (!context.king_in_check &&
+        !static_exchange::capture_is_not_losing(context.board_state, move))
+    {
+      thread_counters[context.thread_index]
+          .see_pruned_quiescence_moves.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
 
-    int eval = -quiescence_search(
-        new_context(context.board_state, -context.beta, -context.alpha, 0,
-                    false, false, context.ply, context.thread_index,
-                    context.king_in_check, context.iteration_depth, true));
+    BoardState &child_board_state = make_move(context, move);
 
-    context.board_state.undo_move();
+    int eval = -quiescence_search(new_context(
+        child_board_state, -context.beta, -context.alpha, 0, false,
+        context.ply + 1, context.thread_index, &context.check_info,
+        context.iteration_depth));
+
+    unmake_move(context, child_board_state);
 
     if (eval > context.max_eval)
     {
@@ -1039,14 +1529,14 @@ auto SearchEngine::delta_prune_move(NodeContext &context,
 auto SearchEngine::futility_prune_move(NodeContext &context,
                                        int quiet_move_index,
                                        Move &move,
-                                       bool is_capture_move) -> bool
+                                       bool is_capture_move,
+                                       bool gives_check) -> bool
 {
   if (quiet_move_index < MIN_FP_QUIET_MOVE_INDEX ||
       context.alpha < -INF_MINUS_1000 ||
       move.promotion_piece_type != PieceType::EMPTY || context.king_in_check ||
-      attack_check::king_is_checked(context.board_state,
-                                    context.board_state.color_to_move) ||
-      is_capture_move || context.ply < MIN_FUTILITY_PRUNING_PLY)
+      gives_check || is_capture_move ||
+      context.ply < MIN_FUTILITY_PRUNING_PLY)
   {
     return false;
   }
@@ -1126,6 +1616,186 @@ void SearchEngine::decay_history_table(history_table_type &history_table)
   }
 }
 
+void SearchEngine::order_moves(NodeContext &context,
+                               std::vector<Move> &possible_moves)
+{
+  // Captures come first, sorted by MVV-LVA. Keep the captures that do not lose
+  // material in front, the losing captures are moved to the back.
+  auto first_quiet_move = std::find_if(
+      possible_moves.begin(), possible_moves.end(),
+      [](const Move &move) { return move.captured_piece == nullptr; });
+  auto next_ordered_slot = std::stable_partition(
+      possible_moves.begin(), first_quiet_move,
+      [&context](const Move &move)
+      {
+        return static_exchange::capture_is_not_losing(context.board_state,
+                                                      move);
+      });
+
+  std::array<int, NUM_OF_KILLER_MOVES + 1> ordered_move_keys{};
+  if (context.ply < MAX_KILLER_MOVE_PLY)
+  {
+    const auto &killer_moves =
+        killer_tables[context.thread_index][context.ply];
+    std::copy(killer_moves.begin(), killer_moves.end(),
+              ordered_move_keys.begin());
+  }
+  if (int *counter_move = counter_move_slot(context))
+  {
+    ordered_move_keys[NUM_OF_KILLER_MOVES] = *counter_move;
+  }
+
+  for (int ordered_move_key : ordered_move_keys)
+  {
+    if (ordered_move_key == NO_MOVE_KEY)
+    {
+      continue;
+    }
+
+    auto ordered_move = std::find_if(
+        first_quiet_move, possible_moves.end(),
+        [ordered_move_key](const Move &move)
+        {
+          return move.promotion_piece_type == PieceType::EMPTY &&
+                 move_key(move) == ordered_move_key;
+        });
+    if (ordered_move == possible_moves.end())
+    {
+      continue;
+    }
+
+    // Shift the move in front of the losing captures and quiet moves, keeping
+    // their order.
+    std::rotate(next_ordered_slot, ordered_move, ordered_move + 1);
+    ++next_ordered_slot;
+    ++first_quiet_move;
+  }
+
+  // Losing captures are between next_ordered_slot and first_quiet_move. Move
+  // them behind the quiet moves.
+  std::rotate(next_ordered_slot, first_quiet_move, possible_moves.end());
+}
+
+auto SearchEngine::get_static_eval(NodeContext &context, bool allow_lazy_eval)
+    -> int
+{
+  perf_counters::ScopedPhase phase(perf_counters::SearchPhase::EVALUATION);
+  SearchThreadCounters &counters = thread_counters[context.thread_index];
+
+  // A TT entry that did not cause a cutoff still carries the static eval.
+  if (context.tt_static_eval != NO_STATIC_EVAL)
+  {
+    counters.tt_static_eval_hits.fetch_add(1, std::memory_order_relaxed);
+    return context.tt_static_eval;
+  }
+
+  uint64_t hash = context.board_state.get_current_state_hash();
+
+  int static_eval = 0;
+  if (eval_cache.probe(hash, static_eval))
+  {
+    counters.eval_cache_hits.fetch_add(1, std::memory_order_relaxed);
+    return static_eval;
+  }
+  counters.eval_cache_misses.fetch_add(1, std::memory_order_relaxed);
+
+  if (context.board_state.nnue_network != nullptr)
+  {
+    static_eval = context.board_state.nnue_network->evaluate(
+        context.board_state.nnue_accumulators.back(),
+        context.board_state.color_to_move);
+  }
+  else if (allow_lazy_eval && lazy_eval_margin > 0)
+  {
+    counters.lazy_eval_attempts.fetch_add(1, std::memory_order_relaxed);
+    static_eval = position_evaluator::evaluate_position_lazily(
+        context.board_state, context.alpha, context.beta, lazy_eval_margin,
+        &pawn_hash_tables[context.thread_index], context.static_eval_is_lazy);
+    if (context.static_eval_is_lazy)
+    {
+      counters.lazy_eval_exits.fetch_add(1, std::memory_order_relaxed);
+      return static_eval;
+    }
+  }
+  else
+  {
+    static_eval = position_evaluator::evaluate_position(
+        context.board_state, &pawn_hash_tables[context.thread_index]);
+  }
+  eval_cache.store(hash, static_eval);
+  return static_eval;
+}
+
+void SearchEngine::record_beta_cutoff(NodeContext &context,
+                                      const Move &move,
+                                      int move_index,
+                                      bool is_capture_move)
+{
+  SearchThreadCounters &counters = thread_counters[context.thread_index];
+  counters.beta_cutoffs.fetch_add(1, std::memory_order_relaxed);
+  if (move_index == 0)
+  {
+    counters.first_move_beta_cutoffs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (is_capture_move || move.promotion_piece_type != PieceType::EMPTY)
+  {
+    return;
+  }
+
+  int key = move_key(move);
+
+  if (context.ply < MAX_KILLER_MOVE_PLY)
+  {
+    auto &killer_moves = killer_tables[context.thread_index][context.ply];
+    if (std::find(killer_moves.begin(), killer_moves.end(), key) !=
+        killer_moves.end())
+    {
+      counters.killer_move_beta_cutoffs.fetch_add(1,
+                                                  std::memory_order_relaxed);
+    }
+    if (killer_moves[0] != key)
+    {
+      // Oldest killer move is dropped.
+      std::rotate(killer_moves.begin(), killer_moves.end() - 1,
+                  killer_moves.end());
+      killer_moves[0] = key;
+    }
+  }
+
+  if (int *counter_move = counter_move_slot(context))
+  {
+    if (*counter_move == key)
+    {
+      counters.counter_move_beta_cutoffs.fetch_add(1,
+                                                   std::memory_order_relaxed);
+    }
+    *counter_move = key;
+  }
+}
+
+auto SearchEngine::counter_move_slot(NodeContext &context) -> int *
+{
+  if (context.previous_move_is_null || context.board_state.game_ply() == 0)
+  {
+    return nullptr;
+  }
+
+  const Move &previous_move = context.board_state.state_history.back().move;
+  const Piece &previous_piece = *previous_move.moving_piece;
+  return &counter_move_tables[context.thread_index]
+                             [static_cast<int>(previous_piece.piece_color)]
+                             [static_cast<int>(previous_piece.piece_type)]
+                             [previous_move.to_x][previous_move.to_y];
+}
+
+auto SearchEngine::move_key(const Move &move) -> int
+{
+  int from_square = (move.from_y * BOARD_WIDTH) + move.from_x;
+  int to_square = (move.to_y * BOARD_WIDTH) + move.to_x;
+  return (from_square * NUM_OF_SQUARES) + to_square;
+}
+
 void SearchEngine::put_best_move_at_front(std::vector<Move> &possible_moves,
                                           int &best_move_index)
 {
@@ -1137,8 +1807,10 @@ void SearchEngine::put_best_move_at_front(std::vector<Move> &possible_moves,
     {
       if (possible_moves[move_idnex].list_index == best_move_index)
       {
-        std::swap(possible_moves[0],
-                  possible_moves[move_idnex]); // Swap the actual elements
+        // Rotate rather than swap so the rest of the ordering is kept.
+        std::rotate(possible_moves.begin(),
+                    possible_moves.begin() + move_idnex,
+                    possible_moves.begin() + move_idnex + 1);
         break;
       }
     }
@@ -2,22 +2,136 @@
 #define SEARCH_ENGINE_H
 
 #include "board_state.h"
+#include "eval_cache.h"
 #include "node_context.h"
+#include "pawn_hash_table.h"
+#include "perf_counters.h"
 #include "thread_handler.h"
 #include "transposition_table.h"
 
 #include <atomic>
 #include <chrono>
 #include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <stack>
 
 namespace engine::parts
 {
+/**
+ * @brief Node counters of a single search thread.
+ *
+ * @note Aligned to a cache line so that search threads never write to the same
+ * cache line when counting nodes.
+ */
+struct alignas(CACHE_LINE_SIZE) SearchThreadCounters
+{
+  /// @brief Number of nodes visited.
+  std::atomic<size_t> nodes_visited = 0;
+
+  /// @brief Number of leaf nodes visited.
+  std::atomic<size_t> leaf_nodes_visited = 0;
+
+  /// @brief Number of quiescence nodes visited.
+  std::atomic<size_t> quiescence_nodes_visited = 0;
+
+  /// @brief Number of quiescence captures pruned by static exchange
+  /// evaluation.
+  std::atomic<size_t> see_pruned_quiescence_moves = 0;
+
+  /// @brief Number of static evaluations reused from a transposition table
+  /// entry.
+  std::atomic<size_t> tt_static_eval_hits = 0;
+
+  /// @brief Number of static evaluations found in the eval cache.
+  std::atomic<size_t> eval_cache_hits = 0;
+
+  /// @brief Number of static evaluations not found in the eval cache.
+  std::atomic<size_t> eval_cache_misses = 0;
+
+  /// @brief Number of quiescence evaluations that tried the lazy evaluation.
+  std::atomic<size_t> lazy_eval_attempts = 0;
+
+  /// @brief Number of quiescence evaluations that returned the lazy score.
+  std::atomic<size_t> lazy_eval_exits = 0;
+
+  /// @brief Number of beta cutoffs in the main search.
+  std::atomic<size_t> beta_cutoffs = 0;
+
+  /// @brief Number of beta cutoffs caused by the first move searched.
+  std::atomic<size_t> first_move_beta_cutoffs = 0;
+
+  /// @brief Number of beta cutoffs caused by a killer move.
+  std::atomic<size_t> killer_move_beta_cutoffs = 0;
+
+  /// @brief Number of beta cutoffs caused by a countermove.
+  std::atomic<size_t> counter_move_beta_cutoffs = 0;
+};
+
+/**
+ * @brief Search statistics of a single search thread. Only collected when the
+ * engine is built with SEARCH_STATS.
+ *
+ * @note Aligned to a cache line for the same reason as SearchThreadCounters.
+ */
+struct alignas(CACHE_LINE_SIZE) SearchThreadStats
+{
+  /// @brief Deepest ply reached from the root, quiescence plies included.
+  std::atomic<size_t> selective_depth = 0;
+
+  /// @brief Number of transposition table probes.
+  std::atomic<size_t> tt_probes = 0;
+
+  /// @brief Number of transposition table probes that found a usable entry.
+  std::atomic<size_t> tt_hits = 0;
+
+  /// @brief Number of transposition table entries rejected by their checksum.
+  std::atomic<size_t> tt_checksum_rejections = 0;
+
+  /// @brief Number of null move searches.
+  std::atomic<size_t> null_move_attempts = 0;
+
+  /// @brief Number of null move searches that failed high.
+  std::atomic<size_t> null_move_cutoffs = 0;
+
+  /// @brief Number of moves searched with late move reduction.
+  std::atomic<size_t> lmr_reductions = 0;
+
+  /// @brief Number of reduced moves searched again at full depth.
+  std::atomic<size_t> lmr_researches = 0;
+
+  /// @brief Number of moves pruned by futility pruning.
+  std::atomic<size_t> futility_prunes = 0;
+
+  /// @brief Number of quiescence captures pruned by delta pruning.
+  std::atomic<size_t> delta_prunes = 0;
+
+  /// @brief Number of root searches repeated with a wider aspiration window.
+  std::atomic<size_t> aspiration_researches = 0;
+
+  /// @brief Nodes visited at each ply from the root. The last slot also counts
+  /// every deeper ply.
+  std::array<std::atomic<size_t>, SEARCH_STATS_MAX_PLY> nodes_per_ply{};
+};
+
 /// @brief Array to represent the history heuristic table.
 using history_table_type = std::array<
     std::array<std::array<std::array<int, BOARD_HEIGHT>, BOARD_WIDTH>,
                NUM_OF_PIECE_TYPES>,
     NUM_OF_COLORS>;
 
+/// @brief Array to represent the killer move slots of each ply.
+using killer_table_type =
+    std::array<std::array<int, NUM_OF_KILLER_MOVES>, MAX_KILLER_MOVE_PLY>;
+
+/// @brief Array to represent the countermove table, indexed by the color, type
+/// and destination of the previous move's piece.
+using counter_move_table_type = std::array<
+    std::array<std::array<std::array<int, BOARD_HEIGHT>, BOARD_WIDTH>,
+               NUM_OF_PIECE_TYPES>,
+    NUM_OF_COLORS>;
+
 /**
  * @brief Class to find the best move for the current board state using
  * various search algorithms and heuristics and apply it to the given board.
@@ -27,10 +141,8 @@ class SearchEngine
 
 public:
   // CONSTANTS
-  // TODO: Make this a runtime configurable constant - number of cores on the
-  // machine.
-  /// @brief Maximum number of search threads.
-  static constexpr int MAX_SEARCH_THREADS = 14;
+  /// @brief Maximum number of search threads, each one owns a set of tables.
+  static constexpr int MAX_SEARCH_THREADS = 32;
 
   /// @brief Aspiration windows for the search.
   static constexpr std::array<int, 3> ASPIRATION_WINDOWS = {
@@ -62,6 +174,27 @@ public:
   /// @brief Flag to run search with null move pruning.
   bool engine_is_pondering = false;
 
+  /// @brief Margin outside the alpha beta window at which quiescence search
+  /// skips the expensive evaluation terms. 0 disables lazy evaluation.
+  int lazy_eval_margin = LAZY_EVAL_MARGIN;
+
+  /// @brief Flag to search with copy-make: each child node searches a copy of
+  /// its parent's board state with the move applied, instead of applying and
+  /// undoing the move on one board state.
+  bool use_copy_make = COPY_MAKE_SEARCH;
+
+  /// @brief Max nodes the main search thread visits per search, 0 for no
+  /// limit. Pondering ignores it.
+  size_t max_search_nodes = 0;
+
+  /// @brief Flag to search reproducibly: one thread, no pondering and no time
+  /// limit, so a search only ends at its depth or node limit.
+  bool deterministic_search = false;
+
+  /// @brief Flag to sample the hardware performance counters of the main
+  /// search thread per search phase, see perf_counters.
+  bool use_perf_counters = false;
+
   // CONSTRUCTORS
   /**
    * @brief Default Constructor - takes a chess board state.
@@ -132,20 +265,97 @@ public:
    */
   void clear_transposition_table();
 
+  /**
+   * @brief Clears the eval cache, needed when the evaluator changes.
+   */
+  void clear_eval_cache();
+
+  /**
+   * @brief Searches every bench position to a fixed depth on one thread and
+   * prints the total node count, time and nodes per second.
+   *
+   * @details The search tables are cleared before the first position, so the
+   * node count is a signature of the search and evaluation: a change that
+   * alters it should be intentional. The game board state is left as is.
+   * @note The engine must not be searching or pondering.
+   *
+   * @param depth Depth to search each position to.
+   *
+   * @return Total number of nodes visited.
+   */
+  auto run_bench(int depth) -> size_t;
+
+  /**
+   * @brief Searches the game board state to a fixed depth with the Lazy SMP
+   * search, without applying the best move.
+   *
+   * @note The engine must not be searching or pondering.
+   *
+   * @param depth Depth to search to.
+   * @param nodes Number of nodes visited by all threads (output parameter).
+   *
+   * @return The best move string, empty if there are no moves.
+   */
+  auto search_to_depth(int depth, size_t &nodes) -> std::string;
+
+  /**
+   * @brief Clears the transposition table, eval cache and the move ordering
+   * tables of every thread, so the next search starts from scratch.
+   */
+  void clear_search_tables();
+
+  /**
+   * @brief Sets the number of Lazy SMP search threads.
+   *
+   * @param thread_count Number of threads, clamped to [1, MAX_SEARCH_THREADS].
+   */
+  void set_search_thread_count(int thread_count);
+
+  /**
+   * @brief Gets the number of Lazy SMP search threads.
+   *
+   * @return Number of search threads, 1 when searching deterministically.
+   */
+  [[nodiscard]] auto search_thread_count() const -> int;
+
+  /**
+   * @brief Sets where the search statistics are written: one JSON line for
+   * each iteration of the main search thread.
+   *
+   * @param destination "stderr", a file to append to, or empty to stop
+   * writing the statistics.
+   *
+   * @return False if the file could not be opened or the engine was built
+   * without SEARCH_STATS.
+   */
+  auto set_search_stats_output(const std::string &destination) -> bool;
+
 private:
   // PROPERTIES
 
-  /// @brief Number of leaf nodes visited.
-  std::atomic<size_t> leaf_nodes_visited = 0;
+  /// @brief Number of Lazy SMP search threads, defaults to the number of
+  /// cores.
+  int num_of_search_threads = 1;
 
-  /// @brief Number of nodes visited.
-  std::atomic<size_t> nodes_visited = 0;
+  /// @brief One set of node counters for each search thread.
+  std::array<SearchThreadCounters, MAX_SEARCH_THREADS> thread_counters{};
 
-  /// @brief Number of nodes visited.
-  std::atomic<size_t> nodes_visited_all_threads = 0;
+  /// @brief One set of search statistics for each search thread.
+  std::array<SearchThreadStats, MAX_SEARCH_THREADS> thread_stats{};
 
-  /// @brief Number of quiescence nodes visited.
-  std::atomic<size_t> quiescence_nodes_visited = 0;
+  /// @brief File the search statistics are written to, if any.
+  /// NOTE: Declared before the thread handlers so it outlives the search
+  /// threads that write to it.
+  std::unique_ptr<FILE, int (*)(FILE *)> search_stats_file{nullptr, fclose};
+
+  /// @brief Flag to write the search statistics to stderr.
+  bool search_stats_to_stderr = false;
+
+  /// @brief Samples the hardware performance counters of the main search
+  /// thread.
+  /// NOTE: Declared before the thread handlers so it outlives the search
+  /// threads.
+  perf_counters::PhaseSampler phase_sampler;
 
   /// @brief See BoardState.
   BoardState &game_board_state;
@@ -160,17 +370,39 @@ private:
   /// @brief Transposition Table object.
   TranspositionTable transposition_table;
 
+  /// @brief Static evaluations shared by all search threads.
+  EvalCache eval_cache;
+
   /// @brief Runs and handles the search thread.
   ThreadHandler search_thread_handler = ThreadHandler(
       running_search_flag, [this]() { this->search_and_execute_best_move(); });
 
   /// @brief Runs and handles the pondering thread.
   ThreadHandler ponder_thread_handler = ThreadHandler(
-      running_search_flag, [this]() { this->run_lazy_smp_search(); });
+      running_search_flag,
+      [this]() { this->run_lazy_smp_search(game_board_state); });
 
   /// @brief One History Heuristic Table for each search thread.
   std::array<history_table_type, MAX_SEARCH_THREADS> history_tables{};
 
+  /// @brief One Killer Move Table for each search thread.
+  std::array<killer_table_type, MAX_SEARCH_THREADS> killer_tables{};
+
+  /// @brief One Countermove Table for each search thread.
+  std::array<counter_move_table_type, MAX_SEARCH_THREADS> counter_move_tables{};
+
+  /// @brief One Pawn Hash Table for each search thread.
+  std::array<PawnHashTable, MAX_SEARCH_THREADS> pawn_hash_tables{};
+
+  /// @brief Board states of the child nodes of each search thread when
+  /// searching with copy-make, used as a stack along the searched line. A
+  /// deque keeps the board states in place as it grows.
+  std::array<std::deque<BoardState>, MAX_SEARCH_THREADS>
+      copy_make_board_states;
+
+  /// @brief Number of copy-make board states in use by each search thread.
+  std::array<int, MAX_SEARCH_THREADS> copy_make_depths{};
+
   /// @brief Best move found by the search.
   std::string best_move;
 
@@ -186,6 +418,18 @@ private:
   /// @brief Number of iterations the best move has been found in.
   int best_move_iteration_count = 0;
 
+  /// @brief Nodes visited by the main thread in completed iterations, kept
+  /// across searches until reset by the bench.
+  size_t completed_iteration_nodes = 0;
+
+  /// @brief Nodes visited by all threads in completed main thread iterations,
+  /// kept across searches until reset by search_to_depth.
+  size_t completed_iteration_nodes_all_threads = 0;
+
+  /// @brief Value of completed_iteration_nodes when the current search
+  /// started, the base of the node limit.
+  size_t search_start_nodes = 0;
+
   // FUNCTIONS
 
   /**
@@ -202,9 +446,12 @@ private:
    * @details The lazy SMP search is a search algorithm that uses multiple
    * threads to search the game tree in parallel.
    *
+   * @param board_state Board state to search, each thread searches a copy.
+   *
    * @return Vector of pairs of moves and their scores.
    */
-  auto run_lazy_smp_search() -> std::vector<std::pair<Move, int>>;
+  auto run_lazy_smp_search(const BoardState &board_state)
+      -> std::vector<std::pair<Move, int>>;
 
   /**
    * @brief Runs the iterative deepening search.
@@ -236,6 +483,9 @@ private:
   /**
    * @brief Runs the negamax alpha beta search for the root node.
    *
+   * @details Runs negamax_alpha_beta_search as a ROOT node and collects the
+   * score of every root move.
+   *
    * @param context Node context.
    *
    * @return Vector of pairs of moves and their scores.
@@ -251,10 +501,13 @@ private:
    * node is essentially the same as a maximizing node, but with the scores and
    * bounds negated.
    *
+   * @tparam node_type Type of the node (ROOT, PV or NON_PV).
+   *
    * @param context Node context.
    *
    * @return Evaluation score from search branch.
    */
+  template <NodeType node_type>
   auto negamax_alpha_beta_search(NodeContext context) -> int;
 
   /**
@@ -267,8 +520,11 @@ private:
   /**
    * @brief Searches all possible moves.
    *
+   * @tparam node_type Type of the node (ROOT, PV or NON_PV).
+   *
    * @param context Node context.
    */
+  template <NodeType node_type>
   void run_negamax_procedure(NodeContext &context);
 
   /**
@@ -291,16 +547,50 @@ private:
    * to be at the end of the list. We reduce the depth of the search for moves
    * that are 'late' in the list of moves.
    *
+   * @note The ROOT node uses its own, milder, late move reduction and records
+   * exact scores for the main thread by lowering alpha slightly.
+   *
+   * @tparam node_type Type of the node (ROOT, PV or NON_PV).
+   *
    * @param context Node context.
+   * @param child_board_state Board state with the move applied, see
+   * make_move.
    * @param move_index Index of the move to search.
    * @param quiet_move_index Index of the quiet move in the possible moves
    * vector.
    * @param is_capture_move Flag to indicate if the move is a capture move.
+   * @param gives_check Flag to indicate if the move gives check. Checking
+   * moves are never reduced.
    */
+  template <NodeType node_type>
   void run_pvs_search(NodeContext &context,
+                      BoardState &child_board_state,
                       int move_index,
                       int quiet_move_index,
-                      bool is_capture_move);
+                      bool is_capture_move,
+                      bool gives_check);
+
+  /**
+   * @brief Makes a move to search a child node.
+   *
+   * @details With use_copy_make, the move is applied to the next free
+   * copy-make board state of the thread, a copy of the node's board state.
+   * Otherwise the move is applied to the node's board state.
+   *
+   * @param context Node context.
+   * @param move Move to make.
+   *
+   * @return Board state of the child node.
+   */
+  auto make_move(NodeContext &context, Move &move) -> BoardState &;
+
+  /**
+   * @brief Takes back a move made with make_move.
+   *
+   * @param context Node context.
+   * @param child_board_state Board state returned by make_move.
+   */
+  void unmake_move(NodeContext &context, BoardState &child_board_state);
 
   /**
    * @brief Handles the transposition table entry.
@@ -316,6 +606,23 @@ private:
    */
   auto handle_tt_entry(NodeContext &context) -> bool;
 
+  /**
+   * @brief Computes the check state of the node and verifies that the
+   * previous move did not leave its own king in check.
+   *
+   * @details The checkers and pinned pieces of the side to move are computed
+   * once and stored in the node context, where they are reused by the
+   * extensions, pruning and the children of the node. A child uses the
+   * pinned pieces of its parent to prove most moves legal without scanning
+   * for attacks on the king that just moved away from danger.
+   *
+   * @param context Node context.
+   *
+   * @return False if the previous move left its own king in check, true
+   * otherwise.
+   */
+  auto compute_check_state(NodeContext &context) -> bool;
+
   /**
    * @brief Min search procedure for each possible move.
    *
@@ -329,6 +636,8 @@ private:
    * @note We currently only allow one null move per search line. Too many
    * null moves can make the search too shallow and return bad evaluations.
    *
+   * @note Only NON_PV nodes try a null move, see negamax_alpha_beta_search.
+   *
    * @param context Node context.
    *
    * @return True if eval failed high.
@@ -364,10 +673,77 @@ private:
   /**
    * @brief Stores the state in the transposition table.
    *
+   * @tparam is_quiescence Flag whether the node is a quiescence node.
+   *
    * @param context Node context.
    */
+  template <bool is_quiescence>
   void store_state_in_transposition_table(NodeContext &context);
 
+  /**
+   * @brief Stops the search once the main thread has visited max_search_nodes
+   * nodes.
+   *
+   * @details Only the main thread's nodes count, so where the search stops
+   * does not depend on how the helper threads are scheduled. The first
+   * iteration always completes, so the search has a best move.
+   *
+   * @param thread_index Index of the thread that visited a node.
+   */
+  void check_node_limit(int thread_index);
+
+  /**
+   * @brief Resets the node counters and search statistics of every search
+   * thread.
+   */
+  void reset_thread_counters();
+
+  /**
+   * @brief Adds one to a search statistic. Does nothing when the engine is
+   * built without SEARCH_STATS.
+   *
+   * @param stat Search statistic to increment.
+   */
+  static void increment_stat(std::atomic<size_t> &stat);
+
+  /**
+   * @brief Counts a visited node in the nodes per ply histogram and the
+   * selective depth of its thread.
+   *
+   * @param context Node context.
+   */
+  void record_node_stats(const NodeContext &context);
+
+  /**
+   * @brief Probes the transposition table for the node's position and counts
+   * the probe in the search statistics.
+   *
+   * @param context Node context, its TT properties are set on a hit.
+   * @param is_quiescence Flag to probe for a quiescence entry.
+   *
+   * @return True if the entry was found, false otherwise.
+   */
+  auto probe_transposition_table(NodeContext &context, bool is_quiescence)
+      -> bool;
+
+  /**
+   * @brief Writes the search statistics of the main thread's last iteration
+   * as one JSON line, if an output is set.
+   *
+   * @param iterative_depth Current iterative depth.
+   * @param search_start_time Start time of search.
+   * @param search_end_time End time of search.
+   * @param move_scores Root moves and their scores, best first.
+   * @param nodes_visited_all_threads Nodes visited by all search threads.
+   */
+  void write_search_stats(
+      int iterative_depth,
+      const std::chrono::time_point<std::chrono::steady_clock>
+          &search_start_time,
+      const std::chrono::time_point<std::chrono::steady_clock> &search_end_time,
+      const std::vector<std::pair<Move, int>> &move_scores,
+      size_t nodes_visited_all_threads);
+
   /**
    * @brief Resets and prints the performance matrix.
    *
@@ -435,13 +811,17 @@ private:
    * vector.
    * @param move Move to check.
    * @param is_capture_move Flag to indicate if the move is a capture move.
+   * @param gives_check Flag to indicate if the move gives check.
+   *
+   * @note Called before the move is applied to the board.
    *
    * @return True if the move can be futility pruned, false otherwise.
    */
   static auto futility_prune_move(NodeContext &context,
                                   int quiet_move_index,
                                   Move &move,
-                                  bool is_capture_move) -> bool;
+                                  bool is_capture_move,
+                                  bool gives_check) -> bool;
 
   /**
    * @brief Updates the history table.
@@ -474,6 +854,80 @@ private:
    */
   static void decay_history_table(history_table_type &history_table);
 
+  /**
+   * @brief Orders the captures that do not lose material first, followed by
+   * the killer moves and the countermove of the node, then the quiet moves
+   * and finally the losing captures.
+   *
+   * @details Killer moves are quiet moves that caused a beta cutoff in a
+   * sibling node at the same ply. The countermove is the quiet move that last
+   * refuted the previous move, indexed by the previous move's piece and
+   * destination. Both are likely to cause a cutoff again.
+   *
+   * @details Losing captures are found with static exchange evaluation. They
+   * rarely cause a cutoff, so they are searched last.
+   *
+   * @note Expects the captures to be at the front of the possible moves, as
+   * returned by calculate_possible_moves.
+   *
+   * @param context Node context.
+   * @param possible_moves Reference to the vector of possible moves.
+   */
+  void order_moves(NodeContext &context, std::vector<Move> &possible_moves);
+
+  /**
+   * @brief Gets the static evaluation of the node's board state.
+   *
+   * @details Reuses the static eval of the node's transposition table entry
+   * if there is one. Otherwise probes the eval cache and only evaluates the
+   * position on a miss, storing the result for the other nodes and threads
+   * that reach the same position.
+   *
+   * @details With allow_lazy_eval, a classical evaluation far outside the
+   * node's window returns the lazy score and sets context.static_eval_is_lazy.
+   * Lazy scores are not cached.
+   *
+   * @param context Node context.
+   * @param allow_lazy_eval Flag to allow the lazy evaluation.
+   *
+   * @return Static evaluation from the perspective of the side to move.
+   */
+  auto get_static_eval(NodeContext &context, bool allow_lazy_eval = false)
+      -> int;
+
+  /**
+   * @brief Records a beta cutoff in the node counters and, for quiet moves,
+   * in the killer and countermove tables.
+   *
+   * @param context Node context.
+   * @param move Move that caused the cutoff.
+   * @param move_index Index of the move in the ordered possible moves.
+   * @param is_capture_move Flag to indicate if the move is a capture move.
+   */
+  void record_beta_cutoff(NodeContext &context,
+                          const Move &move,
+                          int move_index,
+                          bool is_capture_move);
+
+  /**
+   * @brief Gets the countermove slot of the previous move.
+   *
+   * @param context Node context.
+   *
+   * @return Pointer to the countermove slot, or nullptr if there is no
+   * previous move to counter.
+   */
+  auto counter_move_slot(NodeContext &context) -> int *;
+
+  /**
+   * @brief Creates a compact key from the squares of a move.
+   *
+   * @param move Move to create the key from.
+   *
+   * @return Key of the move, never NO_MOVE_KEY.
+   */
+  static auto move_key(const Move &move) -> int;
+
   /**
    * @brief Puts the best move at the front of the possible moves vector.
    *
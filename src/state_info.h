@@ -0,0 +1,49 @@
+#ifndef STATE_INFO_H
+#define STATE_INFO_H
+
+#include "engine_constants.h"
+#include "move.h"
+
+#include <array>
+#include <cstdint>
+
+namespace engine::parts
+{
+/**
+ * @brief A structure to represent what a position needs to be undone and
+ * compared with earlier positions.
+ *
+ * @details BoardState keeps one StateInfo per game ply in a contiguous
+ * history, so making and unmaking a move touches a single record.
+ */
+struct StateInfo
+{
+  // PROPERTIES
+
+  /// @brief Move that led to this position.
+  /// @note The moving piece is nullptr for the initial position and null
+  /// moves.
+  Move move = Move(-1, -1, -1, -1, nullptr);
+
+  /// @brief Zobrist hash of the position.
+  uint64_t hash = 0;
+
+  /// @brief Material and piece-square score of each game phase, from white's
+  /// perspective.
+  std::array<int, NUM_OF_GAME_PHASES> piece_square_scores{};
+
+  /// @brief Zobrist hash of the pawns only.
+  uint64_t pawn_hash = 0;
+
+  /// @brief Castling rights left, a combination of the castling right flags.
+  int castling_rights = NO_CASTLING_RIGHTS;
+
+  /// @brief Square a pawn can capture en passant on, or NO_SQUARE.
+  int en_passant_square = NO_SQUARE;
+
+  /// @brief Number of moves since the last capture or pawn move.
+  int halfmove_clock = 0;
+};
+} // namespace engine::parts
+
+#endif // STATE_INFO_H
@@ -0,0 +1,223 @@
+#include "static_exchange.h"
+
+#include <algorithm>
+
+namespace engine::parts::static_exchange
+{
+// PUBLIC FUNCTIONS
+
+auto evaluate_capture(const BoardState &board_state, const Move &move) -> int
+{
+  const chess_board_type &chess_board = board_state.chess_board;
+
+  bitboard::bitboard_type occupied_squares = board_state.occupied;
+
+  // The capturing piece leaves its square. An en passant capture also removes
+  // the captured pawn, which is not on the target square.
+  occupied_squares &= ~bitboard::square_bit(move.from_x, move.from_y);
+  occupied_squares &= ~bitboard::square_bit(move.captured_piece->x_file,
+                                            move.captured_piece->y_rank);
+
+  // gains[depth] is the material balance, for the side capturing at that depth,
+  // if the exchange stops after that capture.
+  std::array<int, MAX_EXCHANGE_LENGTH> gains{};
+  gains[0] = piece_value(move.captured_piece->piece_type);
+
+  // Value of the piece now standing on the target square, which is the piece
+  // the next capture wins.
+  int piece_on_square_value = piece_value(move.moving_piece->piece_type);
+  if (move.promotion_piece_type != PieceType::EMPTY)
+  {
+    gains[0] += piece_value(move.promotion_piece_type) - PAWN_VALUE;
+    piece_on_square_value = piece_value(move.promotion_piece_type);
+  }
+
+  PieceColor side_to_capture =
+      (move.moving_piece->piece_color == PieceColor::WHITE) ? PieceColor::BLACK
+                                                            : PieceColor::WHITE;
+  int depth = 0;
+  int attacker_x_file;
+  int attacker_y_rank;
+  while (depth + 1 < MAX_EXCHANGE_LENGTH)
+  {
+    // Speculative gain if the piece on the square gets captured next.
+    ++depth;
+    gains[depth] = piece_on_square_value - gains[depth - 1];
+
+    // Neither side can improve their outcome by continuing the exchange.
+    if (std::max(-gains[depth - 1], gains[depth]) < 0)
+    {
+      break;
+    }
+
+    if (!least_valuable_attacker(board_state, move.to_x, move.to_y,
+                                 side_to_capture, occupied_squares,
+                                 attacker_x_file, attacker_y_rank))
+    {
+      break;
+    }
+
+    occupied_squares &= ~bitboard::square_bit(attacker_x_file, attacker_y_rank);
+    piece_on_square_value =
+        piece_value(chess_board[attacker_x_file][attacker_y_rank]->piece_type);
+    side_to_capture = (side_to_capture == PieceColor::WHITE)
+                          ? PieceColor::BLACK
+                          : PieceColor::WHITE;
+  }
+
+  // Walk back through the exchange, ignoring the last speculative gain. Each
+  // side only continues capturing if it gains from doing so.
+  while (--depth > 0)
+  {
+    gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+  }
+  return gains[0];
+}
+
+auto capture_is_not_losing(const BoardState &board_state,
+                           const Move &move) -> bool
+{
+  if (piece_value(move.captured_piece->piece_type) >=
+          piece_value(move.moving_piece->piece_type) &&
+      move.promotion_piece_type == PieceType::EMPTY)
+  {
+    return true;
+  }
+  return evaluate_capture(board_state, move) >= 0;
+}
+
+// STATIC FUNCTIONS
+
+auto piece_value(PieceType piece_type) -> int
+{
+  return PIECE_VALUES[static_cast<uint8_t>(piece_type)];
+}
+
+auto least_valuable_attacker(const BoardState &board_state,
+                             int x_file,
+                             int y_rank,
+                             PieceColor attacker_color,
+                             bitboard::bitboard_type occupied_squares,
+                             int &attacker_x_file,
+                             int &attacker_y_rank) -> bool
+{
+  const chess_board_type &chess_board = board_state.chess_board;
+
+  auto is_attacker = [&](int file, int rank, PieceType piece_type) -> bool
+  {
+    if (file < X_MIN || file > X_MAX || rank < Y_MIN || rank > Y_MAX ||
+        !bitboard::contains(occupied_squares, file, rank))
+    {
+      return false;
+    }
+    const Piece *piece = chess_board[file][rank];
+    return piece->piece_type == piece_type &&
+           piece->piece_color == attacker_color;
+  };
+
+  // PAWNS
+  // Attacking pawns stand one rank behind the square from their point of view.
+  int pawn_y_rank = (attacker_color == PieceColor::WHITE)
+                        ? y_rank - POSITIVE_DIRECTION
+                        : y_rank - NEGATIVE_DIRECTION;
+  for (int capture_direction : {NEGATIVE_DIRECTION, POSITIVE_DIRECTION})
+  {
+    if (is_attacker(x_file + capture_direction, pawn_y_rank, PieceType::PAWN))
+    {
+      attacker_x_file = x_file + capture_direction;
+      attacker_y_rank = pawn_y_rank;
+      return true;
+    }
+  }
+
+  // KNIGHTS
+  for (const auto &knight_move : KNIGHT_MOVES)
+  {
+    if (is_attacker(x_file + knight_move[0], y_rank + knight_move[1],
+                    PieceType::KNIGHT))
+    {
+      attacker_x_file = x_file + knight_move[0];
+      attacker_y_rank = y_rank + knight_move[1];
+      return true;
+    }
+  }
+
+  // SLIDING PIECES
+  // Find the first piece along every ray, then pick the least valuable
+  // bishop, rook or queen among them.
+  int best_value = INF;
+  int blocker_x_file;
+  int blocker_y_rank;
+  auto check_sliding_attacker = [&](const std::array<int, 2> &direction,
+                                    PieceType sliding_piece_type)
+  {
+    if (!first_occupied_square(x_file, y_rank, direction, occupied_squares,
+                               blocker_x_file, blocker_y_rank))
+    {
+      return;
+    }
+    const Piece *piece = chess_board[blocker_x_file][blocker_y_rank];
+    if (piece->piece_color != attacker_color ||
+        (piece->piece_type != sliding_piece_type &&
+         piece->piece_type != PieceType::QUEEN))
+    {
+      return;
+    }
+    int value = piece_value(piece->piece_type);
+    if (value < best_value)
+    {
+      best_value = value;
+      attacker_x_file = blocker_x_file;
+      attacker_y_rank = blocker_y_rank;
+    }
+  };
+  for (const auto &direction : BISHOP_DIRECTIONS)
+  {
+    check_sliding_attacker(direction, PieceType::BISHOP);
+  }
+  for (const auto &direction : ROOK_DIRECTIONS)
+  {
+    check_sliding_attacker(direction, PieceType::ROOK);
+  }
+  if (best_value != INF)
+  {
+    return true;
+  }
+
+  // KING
+  for (const auto &king_move : KING_MOVES)
+  {
+    if (is_attacker(x_file + king_move[0], y_rank + king_move[1],
+                    PieceType::KING))
+    {
+      attacker_x_file = x_file + king_move[0];
+      attacker_y_rank = y_rank + king_move[1];
+      return true;
+    }
+  }
+  return false;
+}
+
+auto first_occupied_square(int x_file,
+                           int y_rank,
+                           const std::array<int, 2> &direction,
+                           bitboard::bitboard_type occupied_squares,
+                           int &blocker_x_file,
+                           int &blocker_y_rank) -> bool
+{
+  int new_x = x_file + direction[0];
+  int new_y = y_rank + direction[1];
+  while (new_x >= X_MIN && new_x <= X_MAX && new_y >= Y_MIN && new_y <= Y_MAX)
+  {
+    if (bitboard::contains(occupied_squares, new_x, new_y))
+    {
+      blocker_x_file = new_x;
+      blocker_y_rank = new_y;
+      return true;
+    }
+    new_x += direction[0];
+    new_y += direction[1];
+  }
+  return false;
+}
+} // namespace engine::parts::static_exchange
@@ -0,0 +1,98 @@
+#ifndef STATIC_EXCHANGE_H
+#define STATIC_EXCHANGE_H
+
+#include "bitboard.h"
+#include "board_state.h"
+#include "move.h"
+
+/**
+ * @brief Namespace for static exchange evaluation (SEE) functions.
+ *
+ * @details SEE resolves the sequence of captures on a single square, where
+ * both sides always recapture with their least valuable attacker and may stop
+ * capturing whenever it is not in their favour. Attackers hidden behind other
+ * attackers (x-rays), e.g. a rook behind a rook on the same file, join the
+ * exchange once the piece in front of them has captured.
+ */
+namespace engine::parts::static_exchange
+{
+/**
+ * @brief Evaluates the material outcome of a capture on its target square.
+ *
+ * @param board_state BoardState object the move is generated from.
+ * @param move Capture move to evaluate.
+ *
+ * @return Material won (positive) or lost (negative) by the side making the
+ * capture, assuming best play of both sides in the exchange.
+ */
+auto evaluate_capture(const BoardState &board_state, const Move &move) -> int;
+
+/**
+ * @brief Checks if a capture does not lose material.
+ *
+ * @note Captures of a piece worth at least as much as the capturing piece can
+ * never lose material, so the full exchange is only resolved for the others.
+ *
+ * @param board_state BoardState object the move is generated from.
+ * @param move Capture move to check.
+ *
+ * @return True if the static exchange evaluation of the capture is >= 0.
+ */
+auto capture_is_not_losing(const BoardState &board_state,
+                           const Move &move) -> bool;
+
+/**
+ * @brief Gets the material value of a piece type.
+ *
+ * @param piece_type Type of the piece.
+ *
+ * @return Value of the piece type, see PIECE_VALUES.
+ */
+static auto piece_value(PieceType piece_type) -> int;
+
+/**
+ * @brief Finds the least valuable piece of the given color attacking a square.
+ *
+ * @note Only squares set in occupied_squares are considered occupied. Pieces
+ * that already took part in the exchange are removed from occupied_squares,
+ * which reveals the x-ray attackers behind them.
+ *
+ * @param board_state BoardState object to search.
+ * @param x_file The x coordinate of the square (file).
+ * @param y_rank The y coordinate of the square (rank).
+ * @param attacker_color Color of the attacking pieces.
+ * @param occupied_squares Bitboard of the occupied squares.
+ * @param attacker_x_file Set to the file of the attacker, if found.
+ * @param attacker_y_rank Set to the rank of the attacker, if found.
+ *
+ * @return True if an attacker is found, false otherwise.
+ */
+static auto least_valuable_attacker(const BoardState &board_state,
+                                    int x_file,
+                                    int y_rank,
+                                    PieceColor attacker_color,
+                                    bitboard::bitboard_type occupied_squares,
+                                    int &attacker_x_file,
+                                    int &attacker_y_rank) -> bool;
+
+/**
+ * @brief Finds the first occupied square along a direction.
+ *
+ * @param x_file The x coordinate of the starting square (file).
+ * @param y_rank The y coordinate of the starting square (rank).
+ * @param direction Direction to step in.
+ * @param occupied_squares Bitboard of the occupied squares.
+ * @param blocker_x_file Set to the file of the first occupied square.
+ * @param blocker_y_rank Set to the rank of the first occupied square.
+ *
+ * @return True if an occupied square is found, false otherwise.
+ */
+static auto first_occupied_square(int x_file,
+                                  int y_rank,
+                                  const std::array<int, 2> &direction,
+                                  bitboard::bitboard_type occupied_squares,
+                                  int &blocker_x_file,
+                                  int &blocker_y_rank) -> bool;
+} // namespace engine::parts::static_exchange
+
+#endif // STATIC_EXCHANGE_H
@@ -19,19 +19,22 @@ void TranspositionTable::store(uint64_t &hash,
                                int eval_score,
                                int flag,
                                int best_move_index,
+                               int static_eval,
                                bool is_quiescence)
 {
   // Get the entry.
   TranspositionTableEntry &entry = tt_table[hash % max_size];
-  uint32_t checksum = calculate_checksum(hash, search_depth, eval_score, flag,
-                                         best_move_index, is_quiescence);
+  uint32_t checksum =
+      calculate_checksum(hash, search_depth, eval_score, flag, best_move_index,
+                         static_eval, is_quiescence);
 
   // Update the entry.
   entry.hash = hash;
-  entry.search_depth = search_depth;
+  entry.search_depth = static_cast<int8_t>(search_depth);
   entry.eval_score = eval_score;
-  entry.flag = flag;
-  entry.best_move_index = best_move_index;
+  entry.flag = static_cast<int8_t>(flag);
+  entry.best_move_index = static_cast<int16_t>(best_move_index);
+  entry.static_eval = static_eval;
   entry.is_quiescence = is_quiescence;
   entry.checksum = checksum;
 }
@@ -41,7 +44,9 @@ auto TranspositionTable::retrieve(uint64_t &hash,
                                   int &eval_score,
                                   int &flag,
                                   int &best_move_index,
-                                  bool is_quiescence) -> bool
+                                  int &static_eval,
+                                  bool is_quiescence,
+                                  bool *checksum_rejected) -> bool
 {
   // We need to mod the hash to get the index because the hash has a larger
   // range than the table size. This will cause collisions, and potentially
@@ -59,14 +64,20 @@ auto TranspositionTable::retrieve(uint64_t &hash,
   eval_score = entry.eval_score;
   flag = entry.flag;
   best_move_index = entry.best_move_index;
+  int tt_static_eval = entry.static_eval;
   bool tt_is_quiescence = entry.is_quiescence;
   uint32_t tt_checksum = entry.checksum;
 
-  uint32_t checksum = calculate_checksum(hash, search_depth, eval_score, flag,
-                                         best_move_index, tt_is_quiescence);
+  uint32_t checksum =
+      calculate_checksum(hash, search_depth, eval_score, flag, best_move_index,
+                         tt_static_eval, tt_is_quiescence);
 
   if (checksum != tt_checksum)
   {
+    if (checksum_rejected != nullptr)
+    {
+      *checksum_rejected = true;
+    }
     return false;
   }
 
@@ -75,6 +86,7 @@ auto TranspositionTable::retrieve(uint64_t &hash,
     return false;
   }
 
+  static_eval = tt_static_eval;
   return true;
 }
 
@@ -90,18 +102,21 @@ auto TranspositionTable::calculate_checksum(uint64_t &hash,
                                             int &eval_score,
                                             int &flag,
                                             int &best_move_index,
+                                            int &static_eval,
                                             bool &is_quiescence) -> uint32_t
 {
   uint32_t checksum = CHECKSUM_SEED;
   checksum ^= hash;
 
   // Thes evalues may be small, so multiply by a prime number to get a better
-  // distribution, and make the checksum more unique.
-  checksum ^= depth * CHECKSUM_PRIME_1;
-  checksum ^= eval_score * CHECKSUM_PRIME_2;
-  checksum ^= flag * CHECKSUM_PRIME_3;
-  checksum ^= best_move_index * CHECKSUM_PRIME_4;
-  checksum ^= static_cast<int>(is_quiescence) * CHECKSUM_PRIME_5;
+  // distribution, and make the checksum more unique. The products are unsigned
+  // so that large values, e.g. NO_STATIC_EVAL, wrap instead of overflowing.
+  checksum ^= static_cast<uint32_t>(depth) * CHECKSUM_PRIME_1;
+  checksum ^= static_cast<uint32_t>(eval_score) * CHECKSUM_PRIME_2;
+  checksum ^= static_cast<uint32_t>(flag) * CHECKSUM_PRIME_3;
+  checksum ^= static_cast<uint32_t>(best_move_index) * CHECKSUM_PRIME_4;
+  checksum ^= static_cast<uint32_t>(is_quiescence) * CHECKSUM_PRIME_5;
+  checksum ^= static_cast<uint32_t>(static_eval) * CHECKSUM_PRIME_6;
 
   return checksum;
 }
@@ -7,6 +7,9 @@ namespace engine::parts
 {
 /**
  * @brief Entry in the transposition table.
+ *
+ * @note Fields are ordered from largest to smallest and the small values use
+ * narrow types, so the entry stays 32 bytes with the static eval included.
  */
 struct TranspositionTableEntry
 {
@@ -15,23 +18,27 @@ struct TranspositionTableEntry
   /// @brief Hash of the board state.
   uint64_t hash = 0;
 
-  /// @brief Maximum depth of the search.
-  int search_depth = 0;
-
   /// @brief Value of the board state.
-  int eval_score = 0;
+  int32_t eval_score = 0;
 
-  /// @brief Flag of the value. 0 = exact, 1 = lower bound, 2 = upper bound.
-  int flag = 0;
+  /// @brief Static evaluation of the board state, or NO_STATIC_EVAL if the
+  /// node did not compute one.
+  int32_t static_eval = 0;
+
+  /// @brief Checksum of the entry.
+  uint32_t checksum = 0;
 
   /// @brief Index of the best move in the board state.
-  int best_move_index = 0;
+  int16_t best_move_index = 0;
+
+  /// @brief Maximum depth of the search.
+  int8_t search_depth = 0;
+
+  /// @brief Flag of the value. 0 = exact, 1 = lower bound, 2 = upper bound.
+  int8_t flag = 0;
 
   /// @brief Flag to check if the entry is a quiescence search.
   bool is_quiescence = false;
-
-  /// @brief Checksum of the entry.
-  uint32_t checksum = 0;
 };
 
 /**
@@ -67,6 +74,8 @@ public:
    * @param flag Flag of the value (0 = exact, 1 = lower bound, 2 = upper
    * bound).
    * @param best_move_index Index of the best move in the board state.
+   * @param static_eval Static evaluation of the board state, or
+   * NO_STATIC_EVAL.
    * @param is_quiescence Flag to check if the entry is a quiescence search
    * (default is false).
    */
@@ -75,6 +84,7 @@ public:
              int eval_score,
              int flag,
              int best_move_index,
+             int static_eval,
              bool is_quiescence = false);
 
   /**
@@ -86,8 +96,13 @@ public:
    * @param flag Flag of the value (output parameter).
    * @param best_move_index Index of the best move in the board state (output
    * parameter).
+   * @param static_eval Static evaluation of the board state (output
+   * parameter). Only set if the entry was found.
    * @param is_quiescence Flag to check if the entry is a quiescence search
    * (default is false).
+   * @param checksum_rejected Set to true if the entry's hash matched but its
+   * checksum did not, i.e. the entry was torn by a racy write (optional output
+   * parameter).
    *
    * @return True if the entry was found, false otherwise.
    */
@@ -96,7 +111,9 @@ public:
                 int &eval_score,
                 int &flag,
                 int &best_move_index,
-                bool is_quiescence = false) -> bool;
+                int &static_eval,
+                bool is_quiescence = false,
+                bool *checksum_rejected = nullptr) -> bool;
 
   /**
    * @brief Clear the transposition table.
@@ -125,6 +142,7 @@ private:
    * @param eval_score Evaluation score of the board state.
    * @param flag Flag of the value.
    * @param best_move_index Index of the best move in the board state.
+   * @param static_eval Static evaluation of the board state.
    * @param is_quiescence Flag to check if the entry is a quiescence search.
    *
    * @return Calculated checksum.
@@ -134,6 +152,7 @@ private:
                                  int &eval_score,
                                  int &flag,
                                  int &best_move_index,
+                                 int &static_eval,
                                  bool &is_quiescence) -> uint32_t;
 };
 } // namespace engine::parts
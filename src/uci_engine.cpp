@@ -2,7 +2,9 @@
 #include "fen_interface.h"
 #include "move_interface.h"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 namespace engine::uci_engine
 {
@@ -88,6 +90,14 @@ void UCIEngine::handle_input()
     {
       handle_quit_command();
     }
+    else if (token == SETOPTION_COMMAND)
+    {
+      handle_setoption_command(user_input);
+    }
+    else if (token == BENCH_COMMAND)
+    {
+      handle_bench_command(user_input);
+    }
   }
 }
 
@@ -121,6 +131,20 @@ void UCIEngine::handle_uci_command()
 {
   printf("id name Elby-Engine\n");
   printf("id author Elbert Alcantara\n");
+  printf("option name EvalFile type string default <empty>\n");
+  printf("option name UseNNUE type check default false\n");
+  printf("option name LazyEvalMargin type spin default %d min 0 max %d\n",
+         parts::LAZY_EVAL_MARGIN, parts::QUEEN_VALUE);
+  printf("option name AttackTables type check default false\n");
+  printf("option name CopyMake type check default %s\n",
+         parts::COPY_MAKE_SEARCH ? "true" : "false");
+  printf("option name Threads type spin default %d min 1 max %d\n",
+         std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1,
+                    parts::SearchEngine::MAX_SEARCH_THREADS),
+         parts::SearchEngine::MAX_SEARCH_THREADS);
+  printf("option name Deterministic type check default false\n");
+  printf("option name SearchStatsFile type string default <empty>\n");
+  printf("option name PerfCounters type check default false\n");
   printf("uciok\n");
 }
 
@@ -189,6 +213,7 @@ void UCIEngine::handle_go_command(std::string &user_input)
   int movetime_ms = -1;
   int movestogo = -1;
   int depth = -1;
+  size_t nodes = 0;
   bool infinite = false;
 
   while (!user_input.empty())
@@ -225,6 +250,11 @@ void UCIEngine::handle_go_command(std::string &user_input)
       std::string depth_string = read_token(user_input);
       depth = std::stoi(depth_string);
     }
+    else if (token == NODES_COMMAND)
+    {
+      std::string nodes_string = read_token(user_input);
+      nodes = std::stoull(nodes_string);
+    }
     else if (token == MOVETIME_COMMAND)
     {
       std::string movetime_string = read_token(user_input);
@@ -237,7 +267,7 @@ void UCIEngine::handle_go_command(std::string &user_input)
   }
 
   search_for_best_move(wtime_ms, btime_ms, winc_ms, binc_ms, movestogo, depth,
-                       movetime_ms, infinite);
+                       nodes, movetime_ms, infinite);
 }
 
 void UCIEngine::handle_stop_command()
@@ -253,6 +283,131 @@ void UCIEngine::handle_quit_command()
   search_engine.stop_engine_pondering();
 }
 
+void UCIEngine::handle_setoption_command(std::string &user_input)
+{
+  search_engine.stop_engine_search();
+  search_engine.stop_engine_pondering();
+
+  if (read_token(user_input) != NAME_COMMAND)
+  {
+    return;
+  }
+  std::string option_name = read_token(user_input);
+  if (read_token(user_input) != VALUE_COMMAND)
+  {
+    return;
+  }
+  // NOTE: File paths may contain spaces, so the value is the rest of the line.
+  skip_whitespace(user_input);
+  std::string option_value =
+      user_input.substr(0, user_input.find_last_not_of(" \t\r\n") + 1);
+
+  if (option_name == EVAL_FILE_OPTION)
+  {
+    if (!nnue_network.load(option_value))
+    {
+      printf("info string failed to load network file %s\n",
+             option_value.c_str());
+    }
+    update_evaluator();
+  }
+  else if (option_name == USE_NNUE_OPTION)
+  {
+    use_nnue = option_value == "true";
+    update_evaluator();
+  }
+  else if (option_name == LAZY_EVAL_MARGIN_OPTION)
+  {
+    try
+    {
+      search_engine.lazy_eval_margin =
+          std::clamp(std::stoi(option_value), 0, parts::QUEEN_VALUE);
+    }
+    catch (const std::invalid_argument &)
+    {
+      printf("info string invalid value %s for option %s\n",
+             option_value.c_str(), option_name.c_str());
+    }
+    catch (const std::out_of_range &)
+    {
+      printf("info string invalid value %s for option %s\n",
+             option_value.c_str(), option_name.c_str());
+    }
+  }
+  else if (option_name == ATTACK_TABLES_OPTION)
+  {
+    game_board_state.set_attack_tables_enabled(option_value == "true");
+  }
+  else if (option_name == COPY_MAKE_OPTION)
+  {
+    search_engine.use_copy_make = option_value == "true";
+  }
+  else if (option_name == THREADS_OPTION)
+  {
+    try
+    {
+      search_engine.set_search_thread_count(std::stoi(option_value));
+    }
+    catch (const std::invalid_argument &)
+    {
+      printf("info string invalid value %s for option %s\n",
+             option_value.c_str(), option_name.c_str());
+    }
+    catch (const std::out_of_range &)
+    {
+      printf("info string invalid value %s for option %s\n",
+             option_value.c_str(), option_name.c_str());
+    }
+  }
+  else if (option_name == DETERMINISTIC_OPTION)
+  {
+    search_engine.deterministic_search = option_value == "true";
+  }
+  else if (option_name == SEARCH_STATS_FILE_OPTION)
+  {
+    if (option_value == "<empty>")
+    {
+      option_value.clear();
+    }
+    if (!search_engine.set_search_stats_output(option_value))
+    {
+      printf("info string failed to write search statistics to %s\n",
+             option_value.c_str());
+    }
+  }
+  else if (option_name == PERF_COUNTERS_OPTION)
+  {
+    search_engine.use_perf_counters = option_value == "true";
+  }
+}
+
+void UCIEngine::update_evaluator()
+{
+  if (use_nnue && !nnue_network.is_loaded())
+  {
+    printf("info string UseNNUE is set but no network is loaded, using the "
+           "classical evaluation\n");
+  }
+  game_board_state.set_nnue_network(
+      (use_nnue && nnue_network.is_loaded()) ? &nnue_network : nullptr);
+  search_engine.clear_eval_cache();
+  search_engine.clear_transposition_table();
+}
+
+void UCIEngine::handle_bench_command(std::string &user_input)
+{
+  search_engine.stop_engine_search();
+  search_engine.stop_engine_pondering();
+
+  int depth = parts::DEFAULT_BENCH_DEPTH;
+  std::string depth_string = read_token(user_input);
+  if (!depth_string.empty())
+  {
+    depth = std::clamp(std::stoi(depth_string), 1, parts::MAX_SEARCH_DEPTH);
+  }
+  (void)search_engine.run_bench(depth);
+}
+
 // SEARCH FUNCTIONS
 
 void UCIEngine::search_for_best_move(int wtime_ms,
@@ -261,6 +416,7 @@ void UCIEngine::search_for_best_move(int wtime_ms,
                                      int binc_ms,
                                      int movestogo,
                                      int depth,
+                                     size_t nodes,
                                      int movetime_ms,
                                      bool infinite)
 {
@@ -270,6 +426,7 @@ void UCIEngine::search_for_best_move(int wtime_ms,
   // Set default search time and depth
   search_engine.max_search_time_milliseconds = parts::DEFAULT_SEARCH_TIME_MS;
   search_engine.max_search_depth = parts::MAX_SEARCH_DEPTH;
+  search_engine.max_search_nodes = 0;
 
   if (search_engine.engine_color == parts::PieceColor::WHITE)
   {
@@ -285,10 +442,19 @@ void UCIEngine::search_for_best_move(int wtime_ms,
     search_engine.max_search_depth = depth;
   }
 
+  if (nodes > 0)
+  {
+    search_engine.max_search_nodes = nodes;
+  }
+  else if (search_engine.deterministic_search && depth <= 0 && !infinite)
+  {
+    search_engine.max_search_nodes = parts::DEFAULT_DETERMINISTIC_SEARCH_NODES;
+  }
+
   if (engine_clock > 0)
   {
     // First two moves
-    if (game_board_state.previous_move_stack.size() < 2)
+    if (game_board_state.game_ply() < 2)
     {
       //  2 seconds or wtime_ms / 30, whichever is smaller
       search_engine.max_search_time_milliseconds =
@@ -296,8 +462,7 @@ void UCIEngine::search_for_best_move(int wtime_ms,
                    parts::DEFAULT_SEARCH_TIME_MS);
     }
     // Opening
-    else if (game_board_state.previous_move_stack.size() <
-             OPENING_MOVE_STACK_SIZE)
+    else if (game_board_state.game_ply() < OPENING_MOVE_STACK_SIZE)
     {
       search_engine.max_search_time_milliseconds =
           (engine_clock / OPENING_MOVE_STACK_TIME_FACTOR);
@@ -320,6 +485,11 @@ void UCIEngine::search_for_best_move(int wtime_ms,
   {
     search_engine.max_search_time_milliseconds = movetime_ms;
   }
+  else if (nodes > 0 && engine_clock <= 0)
+  {
+    // Only the node limit ends the search.
+    search_engine.max_search_time_milliseconds = parts::INF;
+  }
 
   if (infinite)
   {
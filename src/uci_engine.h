@@ -18,12 +18,29 @@ const std::string POSITION_COMMAND = "position";
 const std::string GO_COMMAND = "go";
 const std::string STOP_COMMAND = "stop";
 const std::string QUIT_COMMAND = "quit";
+const std::string SETOPTION_COMMAND = "setoption";
+
+// NON-STANDARD COMMANDS
+const std::string BENCH_COMMAND = "bench";
 
 // POSITION COMMAND OPTIONS
 const std::string FEN_COMMAND = "fen";
 const std::string STARTPOS_COMMAND = "startpos";
 const std::string MOVE_COMMAND = "moves";
 
+// SETOPTION COMMAND OPTIONS
+const std::string NAME_COMMAND = "name";
+const std::string VALUE_COMMAND = "value";
+const std::string EVAL_FILE_OPTION = "EvalFile";
+const std::string USE_NNUE_OPTION = "UseNNUE";
+const std::string LAZY_EVAL_MARGIN_OPTION = "LazyEvalMargin";
+const std::string ATTACK_TABLES_OPTION = "AttackTables";
+const std::string COPY_MAKE_OPTION = "CopyMake";
+const std::string THREADS_OPTION = "Threads";
+const std::string DETERMINISTIC_OPTION = "Deterministic";
+const std::string SEARCH_STATS_FILE_OPTION = "SearchStatsFile";
+const std::string PERF_COUNTERS_OPTION = "PerfCounters";
+
 // GO COMMAND OPTIONS
 const std::string WTIME_COMMAND = "wtime";
 const std::string BTIME_COMMAND = "btime";
@@ -32,6 +49,7 @@ const std::string BINC_COMMAND = "binc";
 const std::string MOVESTOGO_COMMAND = "movestogo";
 const std::string MOVETIME_COMMAND = "movetime";
 const std::string DEPTH_COMMAND = "depth";
+const std::string NODES_COMMAND = "nodes";
 const std::string MATE_COMMAND = "mate";
 const std::string INFINITE_COMMAND = "infinite";
 
@@ -85,6 +103,12 @@ private:
   /// @brief Best move finder object.
   engine::parts::SearchEngine search_engine;
 
+  /// @brief Network loaded from the EvalFile option.
+  engine::parts::nnue::Network nnue_network;
+
+  /// @brief Value of the UseNNUE option.
+  bool use_nnue = false;
+
   /// @brief Queue for storing the input.
   std::queue<std::string> input_queue;
 
@@ -168,13 +192,42 @@ private:
    */
   void handle_quit_command();
 
+  /**
+   * @brief Handles the SETOPTION command.
+   *
+   * @details This function loads the network file given by EvalFile,
+   * switches between the network and the classical evaluation with UseNNUE,
+   * sets the lazy evaluation margin with LazyEvalMargin, the number of
+   * search threads with Threads and the reproducible search mode with
+   * Deterministic.
+   */
+  void handle_setoption_command(std::string &user_input);
+
+  /**
+   * @brief Sets the evaluator of the game board from the current options.
+   *
+   * @details Cached evaluations from the previous evaluator are cleared.
+   */
+  void update_evaluator();
+
+  /**
+   * @brief Handles the BENCH command.
+   *
+   * @details This function searches the bench positions to the given depth,
+   * or DEFAULT_BENCH_DEPTH, and prints the node count, time and nodes per
+   * second.
+   */
+  void handle_bench_command(std::string &user_input);
+
   // SEARCH FUNCTIONS
 
   /**
    * @brief Searches for the best move.
    *
    * @details This function searches for the best move with the given parameters
-   * and starts pondering when the search is done.
+   * and starts pondering when the search is done. A deterministic search
+   * ignores the clock, so without a depth or node limit it searches
+   * DEFAULT_DETERMINISTIC_SEARCH_NODES nodes.
    *
    * @param wtime_ms White time in milliseconds.
    * @para`m btime_ms Black time in milliseconds.
@@ -182,6 +235,7 @@ private:
    * @param binc_ms Black increment in milliseconds.
    * @param movestogo Moves to go.
    * @param depth Depth.
+   * @param nodes Node limit of the main search thread, 0 for no limit.
    * @param movetime_ms Move time in milliseconds.
    * @param infinite Infinite mode.
    */
@@ -191,6 +245,7 @@ private:
                             int binc_ms,
                             int movestogo,
                             int depth,
+                            size_t nodes,
                             int movetime_ms,
                             bool infinite);
 };
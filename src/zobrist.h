@@ -0,0 +1,113 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "engine_constants.h"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Namespace for the Zobrist hashing keys.
+ *
+ * @details The keys are generated at compile time with SplitMix64 from a fixed
+ * seed, so every board shares one table and hashes are the same across runs
+ * and builds.
+ */
+namespace engine::parts::zobrist
+{
+/// @brief Seed of the key generator.
+const uint64_t ZOBRIST_SEED = 0x45C6A3D5B7E9F102ULL;
+
+/**
+ * @brief Structure to hold every Zobrist key.
+ */
+struct ZobristKeys
+{
+  // PROPERTIES
+
+  /// @brief Key of every piece type of every color on every square.
+  std::array<
+      std::array<std::array<uint64_t, NUM_OF_COLORS>, NUM_OF_PIECE_TYPES>,
+      NUM_OF_SQUARES>
+      pieces{};
+
+  /// @brief Key added when black is to move.
+  uint64_t side_to_move = 0;
+
+  /// @brief Key of every combination of castling rights. No rights has key 0.
+  std::array<uint64_t, NUM_OF_CASTLING_RIGHTS> castling_rights{};
+
+  /// @brief Key of the file of the en passant square.
+  std::array<uint64_t, BOARD_WIDTH> en_passant_files{};
+};
+
+/**
+ * @brief Advances a SplitMix64 generator and returns its next output.
+ *
+ * @param state State of the generator.
+ *
+ * @return Next pseudo random number.
+ */
+constexpr auto split_mix_64(uint64_t &state) -> uint64_t
+{
+  state += 0x9E3779B97F4A7C15ULL;
+  uint64_t result = state;
+  result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  result = (result ^ (result >> 27)) * 0x94D049BB133111EBULL;
+  return result ^ (result >> 31);
+}
+
+/**
+ * @brief Generates every Zobrist key.
+ *
+ * @param seed Seed of the generator.
+ *
+ * @return Zobrist keys.
+ */
+constexpr auto build_keys(uint64_t seed) -> ZobristKeys
+{
+  ZobristKeys keys;
+  uint64_t state = seed;
+  for (auto &square_keys : keys.pieces)
+  {
+    for (auto &piece_keys : square_keys)
+    {
+      for (uint64_t &key : piece_keys)
+      {
+        key = split_mix_64(state);
+      }
+    }
+  }
+  keys.side_to_move = split_mix_64(state);
+
+  // Each castling right gets a key, and a combination of rights XORs the keys
+  // of its rights.
+  std::array<uint64_t, NUM_OF_CASTLING_FLAGS> castling_right_keys{};
+  for (uint64_t &key : castling_right_keys)
+  {
+    key = split_mix_64(state);
+  }
+  for (int castling_rights = 0; castling_rights < NUM_OF_CASTLING_RIGHTS;
+       ++castling_rights)
+  {
+    for (int right = 0; right < NUM_OF_CASTLING_FLAGS; ++right)
+    {
+      if ((castling_rights & (1 << right)) != 0)
+      {
+        keys.castling_rights[castling_rights] ^= castling_right_keys[right];
+      }
+    }
+  }
+
+  for (uint64_t &key : keys.en_passant_files)
+  {
+    key = split_mix_64(state);
+  }
+  return keys;
+}
+
+/// @brief Zobrist keys shared by all boards.
+inline constexpr ZobristKeys KEYS = build_keys(ZOBRIST_SEED);
+} // namespace engine::parts::zobrist
+
+#endif // ZOBRIST_H